@@ -0,0 +1,34 @@
+// Counts the C++ heap allocations of a process and prints the total to stderr
+// at exit. Built as a shared library by bench/bench_allocations.sh and loaded
+// with LD_PRELOAD, so the measured binary needs no changes.
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+namespace {
+    std::atomic<unsigned long long> g_allocations{0};
+    std::atomic<unsigned long long> g_bytes{0};
+
+    struct Reporter {
+        ~Reporter() {
+            std::fprintf(stderr, "allocations: %llu (%llu bytes)\n", g_allocations.load(), g_bytes.load());
+        }
+    } g_reporter;
+
+    void* allocate(std::size_t size) {
+        g_allocations.fetch_add(1, std::memory_order_relaxed);
+        g_bytes.fetch_add(size, std::memory_order_relaxed);
+        if (void* p = std::malloc(size ? size : 1)) {
+            return p;
+        }
+        throw std::bad_alloc();
+    }
+}
+
+void* operator new(std::size_t size) { return allocate(size); }
+void* operator new[](std::size_t size) { return allocate(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
@@ -0,0 +1,67 @@
+#!/bin/bash
+# Counts the C++ heap allocations of the object-heavy commands on a synthetic
+# repository: index-pack, cat-file --batch and --batch-check over every
+# object, write-tree from scratch, ls-tree of a 50,000-entry tree, and a
+# checkout through checkoutCommit.
+# Run it against two builds to compare them.
+#
+# Usage: bench/bench_allocations.sh [directories] [files per directory]
+#   MYGIT_EXEC  mygit binary to measure (default: build/mygit)
+#   CXX         compiler to build the counter and checkout harness with (default: g++)
+set -e
+
+CYAN='\033[0;36m'
+GREEN='\033[0;32m'
+NC='\033[0m'
+
+PROJECT_ROOT=$(cd "$(dirname "$0")/.." && pwd)
+MYGIT_EXEC=${MYGIT_EXEC:-"$PROJECT_ROOT/build/mygit"}
+CXX=${CXX:-g++}
+DIRS=${1:-50}
+FILES=${2:-100}
+
+WORKDIR=$(mktemp -d)
+trap 'rm -rf "$WORKDIR"' EXIT
+
+echo -e "${CYAN}Building the allocation counter and the checkout harness...${NC}"
+"$CXX" -std=c++2b -O2 -shared -fPIC -o "$WORKDIR/alloc_counter.so" "$PROJECT_ROOT/bench/alloc_counter.cpp"
+"$CXX" -std=c++2b -O2 -o "$WORKDIR/bench_checkout" "$PROJECT_ROOT/bench/bench_checkout.cpp" \
+    "$PROJECT_ROOT"/src/utils/*.cpp -lcrypto -lz -pthread
+
+git init --quiet "$WORKDIR/repo"
+cd "$WORKDIR/repo"
+for d in $(seq 1 "$DIRS"); do
+    mkdir -p "dir_$d/sub"
+    for f in $(seq 1 "$FILES"); do
+        if [ $((f % 2)) -eq 0 ]; then path="dir_$d/sub/file_$f.txt"; else path="dir_$d/file_$f.txt"; fi
+        seq "$f" $((f + 60 + (d * f) % 200)) > "$path"
+    done
+done
+git add .
+git -c user.name=bench -c user.email=bench@example.com commit --quiet -m "synthetic tree"
+git repack --quiet -a -d
+git prune-packed
+COMMIT=$(git rev-parse HEAD)
+# A single wide tree whose entries all point to the same blob.
+BLOB=$(git rev-parse HEAD:dir_1/file_1.txt)
+WIDE_TREE=$(seq 1 50000 | sed "s/^/100644 blob $BLOB\tentry_/" | git mktree)
+git cat-file --batch-all-objects --batch-check='%(objectname)' > "$WORKDIR/objects.txt"
+echo "Repository: $(git ls-files | wc -l) files, $(wc -l < "$WORKDIR/objects.txt") objects"
+
+# Runs a command under the counter and prints its allocation count.
+count() {
+    local label="$1"
+    shift
+    local result
+    result=$(LD_PRELOAD="$WORKDIR/alloc_counter.so" "$@" 2>&1 >/dev/null | grep '^allocations:' | tail -n 1)
+    echo -e "${GREEN}$(printf '%-26s' "$label") ${result#allocations: }${NC}"
+}
+
+cp .git/objects/pack/*.pack "$WORKDIR/copy.pack"
+count "index-pack" "$MYGIT_EXEC" index-pack -j 1 "$WORKDIR/copy.pack"
+count "cat-file --batch" "$MYGIT_EXEC" cat-file --batch < "$WORKDIR/objects.txt"
+count "cat-file --batch-check" "$MYGIT_EXEC" cat-file --batch-check < "$WORKDIR/objects.txt"
+rm -f .git/stat-cache
+count "write-tree" "$MYGIT_EXEC" write-tree -j 1
+count "ls-tree (50,000 entries)" "$MYGIT_EXEC" ls-tree "$WIDE_TREE"
+count "checkout" "$WORKDIR/bench_checkout" "$COMMIT" "$WORKDIR/out" 1
@@ -0,0 +1,74 @@
+#!/bin/bash
+# Benchmarks cat-file --batch against one `cat-file -p` process per object,
+# on every object of a packed synthetic history, and reports objects/s.
+# The batch output must match git's byte for byte.
+#
+# Usage: bench/bench_cat_file_batch.sh [files] [commits] [single-process sample]
+#   MYGIT_EXEC  mygit binary to measure (default: build/mygit)
+set -e
+
+CYAN='\033[0;36m'
+GREEN='\033[0;32m'
+NC='\033[0m'
+
+PROJECT_ROOT=$(cd "$(dirname "$0")/.." && pwd)
+MYGIT_EXEC=${MYGIT_EXEC:-"$PROJECT_ROOT/build/mygit"}
+FILES=${1:-300}
+COMMITS=${2:-20}
+SAMPLE=${3:-1000}
+
+WORKDIR=$(mktemp -d)
+trap 'rm -rf "$WORKDIR"' EXIT
+
+echo -e "${CYAN}Building a history of $COMMITS commits over $FILES files...${NC}"
+git init --quiet "$WORKDIR/repo"
+cd "$WORKDIR/repo"
+for c in $(seq 1 "$COMMITS"); do
+    for f in $(seq 1 "$FILES"); do
+        # Every commit rewrites a tenth of the files, so the pack holds deltas.
+        if [ "$c" -eq 1 ] || [ $(( (f + c) % 10 )) -eq 0 ]; then
+            seq "$f" $((f + 300)) > "file_$f.txt"
+            echo "commit $c" >> "file_$f.txt"
+        fi
+    done
+    git add .
+    git -c user.name=bench -c user.email=bench@example.com commit --quiet -m "commit $c"
+done
+git repack -a -d --quiet
+git prune-packed
+git cat-file --batch-all-objects --batch-check='%(objectname)' > objects.txt
+OBJECTS=$(wc -l < objects.txt)
+echo "Objects: $OBJECTS in one pack"
+
+# Prints "<ms> ms, <n> objects/s" for <count> objects handled in <ms>.
+rate() {
+    awk "BEGIN { printf \"%d ms, %.0f objects/s\", $2, $1 * 1000 / ($2 > 0 ? $2 : 1) }"
+}
+
+head -n "$SAMPLE" objects.txt > sample.txt
+count=$(wc -l < sample.txt)
+start=$(date +%s%N)
+while read -r sha; do
+    "$MYGIT_EXEC" cat-file -p "$sha" > /dev/null
+done < sample.txt
+elapsed=$(( ($(date +%s%N) - start) / 1000000 ))
+echo -e "${GREEN}One process per object ($count objects): $(rate "$count" "$elapsed")${NC}"
+
+git cat-file --batch < objects.txt > expected.out
+start=$(date +%s%N)
+"$MYGIT_EXEC" cat-file --batch < objects.txt > actual.out
+elapsed=$(( ($(date +%s%N) - start) / 1000000 ))
+cmp -s expected.out actual.out || { echo "cat-file --batch output differs from git"; exit 1; }
+echo -e "${GREEN}cat-file --batch ($OBJECTS objects): $(rate "$OBJECTS" "$elapsed")${NC}"
+
+start=$(date +%s%N)
+"$MYGIT_EXEC" cat-file --batch-check < objects.txt > /dev/null
+elapsed=$(( ($(date +%s%N) - start) / 1000000 ))
+echo -e "${GREEN}cat-file --batch-check ($OBJECTS objects): $(rate "$OBJECTS" "$elapsed")${NC}"
+
+# Every name asked three times in a row: the repeats are served by the object cache.
+awk '{ print; print; print }' objects.txt > repeated.txt
+start=$(date +%s%N)
+"$MYGIT_EXEC" cat-file --batch < repeated.txt > /dev/null
+elapsed=$(( ($(date +%s%N) - start) / 1000000 ))
+echo -e "${GREEN}cat-file --batch, each name 3 times ($((OBJECTS * 3)) requests): $(rate $((OBJECTS * 3)) "$elapsed")${NC}"
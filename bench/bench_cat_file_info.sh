@@ -0,0 +1,70 @@
+#!/bin/bash
+# Benchmarks cat-file -s against cat-file -p on blobs of growing size, loose
+# and then packed as deltas. -s reads only the object's header, so its time
+# should stay flat while -p grows with the object.
+#
+# Usage: bench/bench_cat_file_info.sh [largest size in MiB] [calls per measurement]
+#   MYGIT_EXEC  mygit binary to measure (default: build/mygit)
+set -e
+
+CYAN='\033[0;36m'
+GREEN='\033[0;32m'
+NC='\033[0m'
+
+PROJECT_ROOT=$(cd "$(dirname "$0")/.." && pwd)
+MYGIT_EXEC=${MYGIT_EXEC:-"$PROJECT_ROOT/build/mygit"}
+MAX_MIB=${1:-64}
+CALLS=${2:-20}
+
+WORKDIR=$(mktemp -d)
+trap 'rm -rf "$WORKDIR"' EXIT
+
+git init --quiet "$WORKDIR/repo"
+cd "$WORKDIR/repo"
+
+# Blobs from 1 KiB up to MAX_MIB. Each is then edited once, and git packs the
+# measured original as a delta against the edited, larger version.
+SIZES=()
+size=1024
+while [ "$size" -le $((MAX_MIB * 1024 * 1024)) ]; do
+    SIZES+=("$size")
+    size=$((size * 32))
+done
+declare -A BLOBS
+for size in "${SIZES[@]}"; do
+    seq 1 $((size / 7 + 1)) | head -c "$size" > "blob_$size"
+    BLOBS[$size]=$(git hash-object -w "blob_$size")
+done
+
+# Prints the average time of one call of `mygit cat-file <option> <sha>`.
+time_calls() {
+    local start elapsed
+    start=$(date +%s%N)
+    for _ in $(seq 1 "$CALLS"); do
+        "$MYGIT_EXEC" cat-file "$1" "$2" > /dev/null
+    done
+    elapsed=$(( ($(date +%s%N) - start) / 1000 ))
+    awk "BEGIN { printf \"%.2f ms\", $elapsed / 1000 / $CALLS }"
+}
+
+measure() {
+    echo -e "${CYAN}$1 (average of $CALLS calls):${NC}"
+    for size in "${SIZES[@]}"; do
+        sha=${BLOBS[$size]}
+        [ "$("$MYGIT_EXEC" cat-file -s "$sha")" == "$(git cat-file -s "$sha")" ] || { echo "cat-file -s $sha differs from git"; exit 1; }
+        echo -e "${GREEN}$(printf '%10s' "$size") bytes: -s $(time_calls -s "$sha"), -p $(time_calls -p "$sha")${NC}"
+    done
+}
+
+measure "Loose objects"
+git add .
+git -c user.name=bench -c user.email=bench@example.com commit --quiet -m base
+for size in "${SIZES[@]}"; do
+    echo "edited" >> "blob_$size"
+done
+git add .
+git -c user.name=bench -c user.email=bench@example.com commit --quiet -m edit
+git repack -a -d -f --quiet
+git prune-packed
+deltas=$(git verify-pack -v .git/objects/pack/*.idx | awk 'NF >= 7 && $2 == "blob"' | wc -l)
+measure "Packed objects ($deltas of ${#SIZES[@]} blobs stored as deltas)"
@@ -0,0 +1,33 @@
+// Benchmark: checks out a commit with checkoutCommit and prints the wall time.
+// Built and run by bench/bench_checkout.sh from inside the repository to read.
+//
+// Usage: bench_checkout <commit> <target dir> <workers>
+#include "../src/include/checkout_utils.h"
+
+#include <chrono>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+int main(int argc, char* argv[]) {
+    if (argc != 4) {
+        std::cerr << "Usage: bench_checkout <commit> <target dir> <workers>\n";
+        return 1;
+    }
+    const unsigned int workers = static_cast<unsigned int>(std::stoul(argv[3]));
+    auto commit = ObjectId::fromHex(argv[1]);
+    if (!commit) {
+        std::cerr << "Not a commit SHA: " << argv[1] << "\n";
+        return 1;
+    }
+    std::filesystem::create_directories(argv[2]);
+
+    auto start = std::chrono::steady_clock::now();
+    if (!checkoutCommit(*commit, argv[2], workers)) {
+        return 1;
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << std::fixed << std::setprecision(0) << elapsed.count() * 1000 << "\n";
+    return 0;
+}
@@ -0,0 +1,54 @@
+#!/bin/bash
+# Benchmarks `checkout` between neighbouring commits of a large tree, against
+# git. The tree has DIRS directories of FILES files; commit "ten" changes one
+# file in each of ten directories. Switching back and forth should take
+# milliseconds whatever the size of the tree, since only the ten files are
+# rewritten.
+#
+# Usage: bench/bench_checkout_incremental.sh [dirs] [files per dir]
+#   MYGIT_EXEC  mygit binary to measure (default: build/mygit)
+set -e
+
+CYAN='\033[0;36m'
+GREEN='\033[0;32m'
+NC='\033[0m'
+
+PROJECT_ROOT=$(cd "$(dirname "$0")/.." && pwd)
+MYGIT_EXEC=${MYGIT_EXEC:-"$PROJECT_ROOT/build/mygit"}
+DIRS=${1:-500}
+FILES=${2:-200}
+
+WORKDIR=$(mktemp -d)
+trap 'rm -rf "$WORKDIR"' EXIT
+
+git init --quiet "$WORKDIR/repo"
+cd "$WORKDIR/repo"
+
+echo -e "${CYAN}Building a tree of $DIRS directories with $FILES files each...${NC}"
+awk -v dirs="$DIRS" -v files="$FILES" 'BEGIN {
+    print "commit refs/heads/base\ncommitter bench <bench@example.com> 0 +0000\ndata 0"
+    for (d = 0; d < dirs; d++)
+        for (f = 0; f < files; f++)
+            printf "M 100644 inline dir%d/file%d\ndata %d\n%s\n", d, f, length(d "/" f), d "/" f
+    print "commit refs/heads/ten\ncommitter bench <bench@example.com> 1 +0000\ndata 0\nfrom refs/heads/base"
+    for (d = 0; d < 10; d++)
+        print "M 100644 inline dir" int(d * dirs / 10) "/file1\ndata 7\nchanged"
+}' | git fast-import --quiet
+git checkout --quiet base
+
+# Prints the wall time of a command in milliseconds.
+time_ms() {
+    local start
+    start=$(date +%s%N)
+    "$@" > /dev/null
+    echo $(( ($(date +%s%N) - start) / 1000000 ))
+}
+
+for branch in ten base; do
+    mine=$(time_ms "$MYGIT_EXEC" checkout "$branch")
+    git reset --quiet
+    [ -z "$(git status --porcelain)" ] || { echo "checkout $branch left the working tree dirty"; exit 1; }
+    git checkout --quiet "$([ $branch == ten ] && echo base || echo ten)"
+    theirs=$(time_ms git checkout --quiet "$branch")
+    echo -e "${GREEN}checkout $branch ($(( DIRS * FILES )) files, 10 changed): mygit ${mine} ms, git ${theirs} ms${NC}"
+done
@@ -0,0 +1,63 @@
+#!/bin/bash
+# Benchmarks delta resolution on a synthetic pack made of 50-deep delta chains.
+#
+# Usage: bench/bench_delta_resolution.sh [files] [runs]
+#   MYGIT_EXEC           mygit binary to measure (default: build/mygit)
+#   MYGIT_BASELINE_EXEC  optional second binary to compare against
+set -e
+
+CYAN='\033[0;36m'
+GREEN='\033[0;32m'
+NC='\033[0m'
+
+PROJECT_ROOT=$(cd "$(dirname "$0")/.." && pwd)
+MYGIT_EXEC=${MYGIT_EXEC:-"$PROJECT_ROOT/build/mygit"}
+FILES=${1:-200}
+RUNS=${2:-3}
+DEPTH=50
+REVISIONS=$((DEPTH + 10)) # A few extra revisions so git can fill chains up to --depth.
+
+WORKDIR=$(mktemp -d)
+trap 'rm -rf "$WORKDIR"' EXIT
+
+echo -e "${CYAN}Building a history of $FILES files x $REVISIONS revisions...${NC}"
+git init --quiet "$WORKDIR/repo"
+cd "$WORKDIR/repo"
+for rev in $(seq 1 $REVISIONS); do
+    for f in $(seq 1 "$FILES"); do
+        # Every revision rewrites one line, so each version deltas well against the previous one.
+        seq 1 2000 | sed "s/^$(( (rev * 37 + f) % 2000 + 1 ))\$/file $f revision $rev/" > "file_$f.txt"
+    done
+    git add .
+    git -c user.name=bench -c user.email=bench@example.com commit --quiet -m "revision $rev"
+done
+git repack --quiet -a -d -f --depth=$DEPTH --window=$((DEPTH + 10))
+
+PACK=$(ls .git/objects/pack/pack-*.pack)
+echo "Pack: $(du -h "$PACK" | cut -f1), $(git verify-pack -v "${PACK%.pack}.idx" | grep -c '^[0-9a-f]\{40\} ') objects"
+git verify-pack -s "${PACK%.pack}.idx" | grep "chain length" | tail -n 3
+
+measure() {
+    local exec="$1" threads="$2"
+    cp "$PACK" "$WORKDIR/bench.pack"
+    local best=""
+    for _ in $(seq 1 "$RUNS"); do
+        rm -f "$WORKDIR/bench.idx"
+        local start elapsed
+        start=$(date +%s%N)
+        "$exec" index-pack -j "$threads" "$WORKDIR/bench.pack" > /dev/null
+        elapsed=$(( ($(date +%s%N) - start) / 1000000 ))
+        if [ -z "$best" ] || [ "$elapsed" -lt "$best" ]; then best=$elapsed; fi
+    done
+    cmp -s "$WORKDIR/bench.idx" "${PACK%.pack}.idx" || { echo "index mismatch for $exec"; exit 1; }
+    echo "$best"
+}
+
+for threads in $(echo 1 "$(nproc)" | tr ' ' '\n' | sort -un); do
+    current=$(measure "$MYGIT_EXEC" "$threads")
+    echo -e "${GREEN}index-pack -j $threads: ${current} ms (best of $RUNS)${NC}"
+    if [ -n "$MYGIT_BASELINE_EXEC" ]; then
+        baseline=$(measure "$MYGIT_BASELINE_EXEC" "$threads")
+        echo "baseline   -j $threads: ${baseline} ms, speedup x$(awk "BEGIN { printf \"%.2f\", $baseline / $current }")"
+    fi
+done
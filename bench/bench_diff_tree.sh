@@ -0,0 +1,59 @@
+#!/bin/bash
+# Benchmarks `diff-tree -r` between large trees that differ in a few files,
+# against git and against a full `ls-tree -r` of the same tree. The tree has
+# DIRS directories of FILES files. Commit "one" changes a single file and
+# commit "many" changes one file in each of CHANGED directories, so the time
+# should follow the number of changes, not the size of the tree.
+#
+# Usage: bench/bench_diff_tree.sh [dirs] [files per dir] [changed dirs]
+#   MYGIT_EXEC  mygit binary to measure (default: build/mygit)
+set -e
+
+CYAN='\033[0;36m'
+GREEN='\033[0;32m'
+NC='\033[0m'
+
+PROJECT_ROOT=$(cd "$(dirname "$0")/.." && pwd)
+MYGIT_EXEC=${MYGIT_EXEC:-"$PROJECT_ROOT/build/mygit"}
+DIRS=${1:-500}
+FILES=${2:-1000}
+CHANGED=${3:-50}
+
+WORKDIR=$(mktemp -d)
+trap 'rm -rf "$WORKDIR"' EXIT
+
+git init --quiet "$WORKDIR/repo"
+cd "$WORKDIR/repo"
+
+echo -e "${CYAN}Building a tree of $DIRS directories with $FILES files each...${NC}"
+awk -v dirs="$DIRS" -v files="$FILES" -v changed="$CHANGED" 'BEGIN {
+    print "commit refs/heads/base\ncommitter bench <bench@example.com> 0 +0000\ndata 0"
+    for (d = 0; d < dirs; d++)
+        for (f = 0; f < files; f++)
+            printf "M 100644 inline dir%d/file%d\ndata %d\n%s\n", d, f, length(d "/" f), d "/" f
+    print "commit refs/heads/one\ncommitter bench <bench@example.com> 1 +0000\ndata 0\nfrom refs/heads/base"
+    print "M 100644 inline dir" int(dirs / 2) "/file0\ndata 7\nchanged"
+    print "commit refs/heads/many\ncommitter bench <bench@example.com> 2 +0000\ndata 0\nfrom refs/heads/base"
+    for (d = 0; d < changed; d++)
+        print "M 100644 inline dir" int(d * dirs / changed) "/file1\ndata 7\nchanged"
+}' | git fast-import --quiet
+base=$(git rev-parse "base^{tree}")
+
+# Prints the wall time of a command in milliseconds.
+time_ms() {
+    local start
+    start=$(date +%s%N)
+    "$@" > /dev/null
+    echo $(( ($(date +%s%N) - start) / 1000000 ))
+}
+
+mine=$(time_ms "$MYGIT_EXEC" ls-tree -r "$base")
+echo -e "${CYAN}ls-tree -r of the whole tree ($(( DIRS * FILES )) files): mygit ${mine} ms${NC}"
+
+for branch in one many; do
+    target=$(git rev-parse "$branch^{tree}")
+    [ "$("$MYGIT_EXEC" diff-tree -r "$base" "$target" | md5sum)" == "$(git diff-tree -r "$base" "$target" | md5sum)" ] || { echo "diff-tree differs from git"; exit 1; }
+    mine=$(time_ms "$MYGIT_EXEC" diff-tree -r "$base" "$target")
+    theirs=$(time_ms git diff-tree -r "$base" "$target")
+    echo -e "${GREEN}diff-tree -r base $branch ($(git diff-tree -r "$base" "$target" | wc -l) changes): mygit ${mine} ms, git ${theirs} ms${NC}"
+done
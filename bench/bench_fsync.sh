@@ -0,0 +1,52 @@
+#!/bin/bash
+# Benchmarks loose object writes under each fsync policy: write-tree on a
+# synthetic directory with an empty object store, so every blob and tree is
+# written. `per-object` pays one disk flush per object; `batch` pays one
+# syncfs() for the whole command. Every run must produce git's tree SHA.
+#
+# Usage: bench/bench_fsync.sh [directories] [files per directory] [runs]
+#   MYGIT_EXEC  mygit binary to measure (default: build/mygit)
+#   BENCH_DIR   where to create the repository (default: a temporary directory);
+#               put it on the filesystem whose sync cost matters
+set -e
+
+CYAN='\033[0;36m'
+GREEN='\033[0;32m'
+NC='\033[0m'
+
+PROJECT_ROOT=$(cd "$(dirname "$0")/.." && pwd)
+MYGIT_EXEC=${MYGIT_EXEC:-"$PROJECT_ROOT/build/mygit"}
+DIRS=${1:-50}
+FILES=${2:-200}
+RUNS=${3:-3}
+
+WORKDIR=$(mktemp -d ${BENCH_DIR:+-p "$BENCH_DIR"})
+trap 'rm -rf "$WORKDIR"' EXIT
+
+echo -e "${CYAN}Building a tree of $DIRS directories x $FILES files in $WORKDIR...${NC}"
+git init --quiet "$WORKDIR/repo"
+cd "$WORKDIR/repo"
+for d in $(seq 1 "$DIRS"); do
+    mkdir -p "dir_$d"
+    for f in $(seq 1 "$FILES"); do
+        echo "file $f of directory $d" > "dir_$d/file_$f.txt"
+    done
+done
+git add .
+EXPECTED=$(git write-tree)
+files=$(git ls-files | wc -l)
+
+for policy in none per-object batch; do
+    best=""
+    for _ in $(seq 1 "$RUNS"); do
+        rm -rf .git/objects/?? .git/objects/pack .git/stat-cache
+        sync
+        start=$(date +%s%N)
+        actual=$("$MYGIT_EXEC" --fsync=$policy write-tree -j 1)
+        elapsed=$(( ($(date +%s%N) - start) / 1000000 ))
+        [ "$actual" == "$EXPECTED" ] || { echo "--fsync=$policy gave $actual, expected $EXPECTED"; exit 1; }
+        if [ -z "$best" ] || [ "$elapsed" -lt "$best" ]; then best=$elapsed; fi
+    done
+    best=$(( best > 0 ? best : 1 ))
+    echo -e "${GREEN}$(printf '%-11s' "$policy") ${best} ms (best of $RUNS), $(awk "BEGIN { printf \"%.0f\", $files * 1000 / $best }") files/s${NC}"
+done
@@ -0,0 +1,71 @@
+#!/bin/bash
+# Benchmarks `log -- <path>` over a synthetic history against git: without a
+# commit graph, with one, and with changed-path Bloom filters. The tree has
+# DIRS directories of FILES files; each of the COMMITS commits rewrites one
+# file, spread evenly over the tree, so a directory changes in about one
+# commit out of DIRS. Output goes to /dev/null.
+#
+# Usage: bench/bench_log_paths.sh [commits] [dirs] [files per dir]
+#   MYGIT_EXEC  mygit binary to measure (default: build/mygit)
+set -e
+
+CYAN='\033[0;36m'
+GREEN='\033[0;32m'
+NC='\033[0m'
+
+PROJECT_ROOT=$(cd "$(dirname "$0")/.." && pwd)
+MYGIT_EXEC=${MYGIT_EXEC:-"$PROJECT_ROOT/build/mygit"}
+COMMITS=${1:-100000}
+DIRS=${2:-100}
+FILES=${3:-20}
+
+WORKDIR=$(mktemp -d)
+trap 'rm -rf "$WORKDIR"' EXIT
+
+git init --quiet "$WORKDIR/repo"
+cd "$WORKDIR/repo"
+
+echo -e "${CYAN}Building $COMMITS commits over $DIRS directories of $FILES files...${NC}"
+awk -v n="$COMMITS" -v dirs="$DIRS" -v files="$FILES" 'BEGIN {
+    printf "commit refs/heads/main\ncommitter bench <bench@example.com> 1000000000 +0000\ndata 0\n"
+    for (d = 0; d < dirs; d++)
+        for (f = 0; f < files; f++)
+            printf "M 100644 inline dir%d/file%d\ndata 2\n0\n", d, f
+    for (i = 1; i < n; i++) {
+        slot = (i * 7919) % (dirs * files)
+        content = "" i
+        printf "commit refs/heads/main\ncommitter bench <bench@example.com> %d +0000\ndata 0\n", 1000000000 + i
+        printf "M 100644 inline dir%d/file%d\ndata %d\n%s\n", int(slot / files), slot % files, length(content), content
+    }
+}' | git fast-import --quiet
+git symbolic-ref HEAD refs/heads/main
+git config core.commitGraph true
+
+# Prints the wall time of a command in milliseconds.
+time_ms() {
+    local start
+    start=$(date +%s%N)
+    "$@" > /dev/null
+    echo $(( ($(date +%s%N) - start) / 1000000 ))
+}
+
+run() {
+    local label=$1
+    echo -e "${CYAN}$label:${NC}"
+    for path in dir7 dir7/file3; do
+        [ "$("$MYGIT_EXEC" log -- $path | md5sum)" == "$(git log -- $path | md5sum)" ] || { echo "log -- $path differs from git"; exit 1; }
+        mine=$(time_ms "$MYGIT_EXEC" log -- $path)
+        theirs=$(time_ms git log -- $path)
+        echo -e "${GREEN}$(printf '%-12s' "$path") $(git rev-list main -- $path | wc -l) commits: mygit ${mine} ms, git ${theirs} ms${NC}"
+    done
+}
+
+run "log -- <path> without a commit graph"
+
+"$MYGIT_EXEC" commit-graph write
+run "log -- <path> with a commit graph"
+
+start=$(date +%s%N)
+"$MYGIT_EXEC" commit-graph write --changed-paths
+echo -e "${CYAN}commit-graph write --changed-paths: $(( ($(date +%s%N) - start) / 1000000 )) ms${NC}"
+run "log -- <path> with changed-path Bloom filters"
@@ -0,0 +1,62 @@
+#!/bin/bash
+# Benchmarks `ls-tree -r` on a large synthetic tree against git. The tree has
+# DIRS subdirectories of FILES entries each, built with `git mktree` so no
+# working copy is needed. Output goes to /dev/null, so the time measured is
+# the walk and the formatting, not the terminal.
+#
+# Usage: bench/bench_ls_tree.sh [dirs] [files per dir]
+#   MYGIT_EXEC  mygit binary to measure (default: build/mygit)
+set -e
+
+CYAN='\033[0;36m'
+GREEN='\033[0;32m'
+NC='\033[0m'
+
+PROJECT_ROOT=$(cd "$(dirname "$0")/.." && pwd)
+MYGIT_EXEC=${MYGIT_EXEC:-"$PROJECT_ROOT/build/mygit"}
+DIRS=${1:-500}
+FILES=${2:-1000}
+
+WORKDIR=$(mktemp -d)
+trap 'rm -rf "$WORKDIR"' EXIT
+
+git init --quiet "$WORKDIR/repo"
+cd "$WORKDIR/repo"
+
+echo -e "${CYAN}Building a tree of $DIRS directories with $FILES files each...${NC}"
+# fast-import writes the blobs and trees straight into a pack. Every file
+# holds distinct content, so every directory's tree is distinct too.
+{
+    echo "commit refs/heads/main"
+    echo "committer bench <bench@example.com> 0 +0000"
+    echo "data 5"
+    echo "bench"
+    for d in $(seq 1 "$DIRS"); do
+        for f in $(seq 1 "$FILES"); do
+            content="$d/$f"
+            echo "M 100644 inline dir$d/file$f"
+            echo "data ${#content}"
+            echo "$content"
+        done
+    done
+} | git fast-import --quiet
+commit=$(git rev-parse main)
+tree=$(git rev-parse "main^{tree}")
+entries=$(git ls-tree -r "$tree" | wc -l)
+
+[ "$("$MYGIT_EXEC" ls-tree -r -t "$commit" | md5sum)" == "$(git ls-tree -r -t "$commit" | md5sum)" ] || { echo "ls-tree -r -t differs from git"; exit 1; }
+
+# Prints the wall time of a command in milliseconds.
+time_ms() {
+    local start
+    start=$(date +%s%N)
+    "$@" > /dev/null
+    echo $(( ($(date +%s%N) - start) / 1000000 ))
+}
+
+echo -e "${CYAN}ls-tree -r over $entries entries:${NC}"
+for flags in "-r" "-r -t" "-r --name-only" "-r -l"; do
+    mine=$(time_ms "$MYGIT_EXEC" ls-tree $flags "$tree")
+    theirs=$(time_ms git ls-tree $flags "$tree")
+    echo -e "${GREEN}$(printf '%-16s' "$flags") mygit ${mine} ms, git ${theirs} ms${NC}"
+done
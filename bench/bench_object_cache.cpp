@@ -0,0 +1,80 @@
+// Benchmark: several threads read a shared set of objects through one
+// ObjectCache, as checkout workers and tree walks do, and the lookup rate is
+// printed for a single lock (1 shard) and for the default sharding.
+// Built and run by bench/bench_object_cache.sh.
+//
+// Usage: bench_object_cache <threads> <lookups per thread>
+#include "../src/include/object_cache.h"
+
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    constexpr size_t OBJECT_COUNT = 20000;
+    constexpr size_t OBJECT_SIZE = 512;
+    // Room for about three quarters of the objects, so some lookups miss and evict.
+    constexpr size_t BUDGET = OBJECT_COUNT * OBJECT_SIZE * 3 / 4;
+
+    ObjectId makeId(size_t n) {
+        ObjectId id;
+        // Spread the counter over the bytes so ids look like SHAs to the hash and the shard choice.
+        std::mt19937_64 mix(n);
+        for (size_t i = 0; i < ObjectId::SIZE; i += sizeof(uint64_t)) {
+            uint64_t word = mix();
+            std::memcpy(id.bytes.data() + i, &word, std::min(sizeof(word), ObjectId::SIZE - i));
+        }
+        return id;
+    }
+
+    void run(size_t shards, unsigned threads, size_t lookups, const std::vector<ObjectId>& ids,
+             const ObjectCache::Value& object) {
+        ObjectCache cache(BUDGET, shards);
+        auto start = std::chrono::steady_clock::now();
+        {
+            std::vector<std::jthread> workers;
+            for (unsigned t = 0; t < threads; ++t) {
+                workers.emplace_back([&, t] {
+                    std::mt19937 rng(t);
+                    std::uniform_int_distribution<size_t> pick(0, ids.size() - 1);
+                    for (size_t i = 0; i < lookups; ++i) {
+                        const ObjectId& id = ids[pick(rng)];
+                        if (!cache.get(id)) {
+                            cache.put(id, object);
+                        }
+                    }
+                });
+            }
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        auto stats = cache.stats();
+        std::cout << std::setw(3) << shards << " shard(s): " << std::fixed << std::setprecision(1)
+                  << threads * lookups / elapsed.count() / 1e6 << " M lookups/s, hits " << stats.hits
+                  << ", misses " << stats.misses << ", evictions " << stats.evictions << "\n";
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 3) {
+        std::cerr << "Usage: bench_object_cache <threads> <lookups per thread>\n";
+        return 1;
+    }
+    const unsigned threads = static_cast<unsigned>(std::stoul(argv[1]));
+    const size_t lookups = std::stoul(argv[2]);
+
+    std::vector<ObjectId> ids;
+    for (size_t n = 0; n < OBJECT_COUNT; ++n) {
+        ids.push_back(makeId(n));
+    }
+    auto object = std::make_shared<const std::vector<std::byte>>(OBJECT_SIZE);
+
+    run(1, threads, lookups, ids, object);
+    run(ObjectCache::DEFAULT_SHARDS, threads, lookups, ids, object);
+    return 0;
+}
@@ -0,0 +1,29 @@
+#!/bin/bash
+# Benchmarks concurrent lookups in the object cache with a single lock and
+# with the default number of shards. The gap grows with the number of cores:
+# with one lock, every lookup of every thread waits on the same mutex.
+#
+# Usage: bench/bench_object_cache.sh [threads] [lookups per thread]
+#   CXX  compiler to build the benchmark with (default: g++)
+set -e
+
+CYAN='\033[0;36m'
+GREEN='\033[0;32m'
+NC='\033[0m'
+
+PROJECT_ROOT=$(cd "$(dirname "$0")/.." && pwd)
+CXX=${CXX:-g++}
+THREADS=${1:-$(nproc)}
+LOOKUPS=${2:-2000000}
+
+WORKDIR=$(mktemp -d)
+trap 'rm -rf "$WORKDIR"' EXIT
+
+echo -e "${CYAN}Building the object cache benchmark...${NC}"
+"$CXX" -std=c++2b -O2 -o "$WORKDIR/bench_object_cache" "$PROJECT_ROOT/bench/bench_object_cache.cpp" \
+    "$PROJECT_ROOT/src/utils/object_cache.cpp" -pthread
+
+echo -e "${CYAN}$THREADS threads, $LOOKUPS lookups each:${NC}"
+"$WORKDIR/bench_object_cache" "$THREADS" "$LOOKUPS" | while read -r line; do
+    echo -e "${GREEN}$line${NC}"
+done
@@ -0,0 +1,142 @@
+// Microbenchmark: decodes a synthetic side-band-64k response with the span-based
+// PktLineDecoder and with the previous istream-based reader, kept here verbatim
+// for comparison. Built and run by bench/bench_pkt_line.sh.
+#include "../src/include/pkt_line_utils.h"
+
+#include <chrono>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <span>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// The reader pkt_line_utils used before PktLineDecoder: one std::string and one
+// std::stoul per length prefix, one heap-allocated vector per packet.
+class IstreamPktLineReader {
+    std::istream& m_stream;
+    bool m_is_finished = false;
+
+public:
+    explicit IstreamPktLineReader(std::istream& stream) : m_stream(stream) {}
+
+    std::optional<std::vector<std::byte>> readNextPacket() {
+        if (m_is_finished) return std::nullopt;
+
+        char length_hex[4];
+        m_stream.read(length_hex, 4);
+        if (m_stream.gcount() < 4) {
+            m_is_finished = true;
+            return std::nullopt;
+        }
+
+        unsigned int length = 0;
+        try {
+            std::string hex_str(length_hex, 4);
+            length = std::stoul(hex_str, nullptr, 16);
+        } catch (const std::invalid_argument&) {
+            m_is_finished = true;
+            return std::nullopt;
+        }
+
+        if (length == 0 || length == 4) {
+            return std::vector<std::byte>{};
+        }
+        if (length < 4) {
+            m_is_finished = true;
+            return std::nullopt;
+        }
+
+        size_t content_length = length - 4;
+        std::vector<std::byte> content(content_length);
+        m_stream.read(reinterpret_cast<char*>(content.data()), static_cast<std::streamsize>(content_length));
+        if (static_cast<size_t>(m_stream.gcount()) < content_length) {
+            m_is_finished = true;
+            return std::nullopt;
+        }
+        return content;
+    }
+};
+
+// Builds a band-1 stream of `packets` packets with payloads of up to `max_payload` bytes.
+static std::string buildResponse(size_t packets, size_t max_payload) {
+    std::mt19937 rng(42);
+    std::string response = createPktLine("NAK\n");
+    for (size_t i = 0; i < packets; ++i) {
+        size_t size = 1 + rng() % max_payload;
+        std::string payload(size, '\x01');
+        for (size_t j = 1; j < size; ++j) payload[j] = static_cast<char>(rng());
+        response += createPktLine(payload);
+    }
+    return response + createPktLine("");
+}
+
+template <typename Fn>
+static double bestSeconds(int runs, Fn&& fn) {
+    double best = 1e30;
+    for (int r = 0; r < runs; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+int main(int argc, char* argv[]) {
+    const size_t packets = argc > 1 ? std::stoul(argv[1]) : 1000000;
+    const size_t max_payload = argc > 2 ? std::stoul(argv[2]) : 256;
+    const size_t chunk_size = argc > 3 ? std::stoul(argv[3]) : 16384;
+    const int runs = 5;
+
+    const std::string response = buildResponse(packets, max_payload);
+    const auto bytes = std::as_bytes(std::span(response.data(), response.size()));
+    std::cout << "Stream: " << packets << " packets, " << response.size() / (1024 * 1024) << " MiB\n";
+
+    // Every variant sums the payload bytes so the work cannot be optimized away.
+    size_t expected = 0;
+    double istream_time = bestSeconds(runs, [&] {
+        std::istringstream stream(response);
+        IstreamPktLineReader reader(stream);
+        size_t total = 0;
+        while (auto packet = reader.readNextPacket()) total += packet->size();
+        expected = total;
+    });
+
+    bool consistent = true;
+    double span_time = bestSeconds(runs, [&] {
+        PktLineDecoder decoder(bytes);
+        size_t total = 0;
+        while (auto packet = decoder.next()) total += packet->payload.size();
+        consistent &= total == expected;
+    });
+
+    double chunked_time = bestSeconds(runs, [&] {
+        PktLineDecoder decoder;
+        size_t total = 0;
+        for (size_t offset = 0; offset < bytes.size(); offset += chunk_size) {
+            decoder.feed(bytes.subspan(offset, std::min(chunk_size, bytes.size() - offset)));
+            while (auto packet = decoder.next()) total += packet->payload.size();
+        }
+        consistent &= total == expected;
+    });
+
+    if (!consistent) {
+        std::cerr << "Decoders disagree on the payload size.\n";
+        return 1;
+    }
+
+    auto report = [&](const char* name, double seconds) {
+        std::cout << std::left << std::setw(28) << name << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(8) << seconds * 1000 << " ms " << std::setw(8)
+                  << response.size() / seconds / (1024 * 1024) << " MiB/s " << std::setw(8)
+                  << packets / seconds / 1e6 << " Mpkt/s  x" << std::setprecision(2) << istream_time / seconds << "\n";
+    };
+    report("istream reader (old)", istream_time);
+    report("span decoder", span_time);
+    report("span decoder, chunked", chunked_time);
+    return 0;
+}
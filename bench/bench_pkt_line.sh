@@ -0,0 +1,21 @@
+#!/bin/bash
+# Microbenchmark of the pkt-line decoder against the previous istream-based reader.
+#
+# Usage: bench/bench_pkt_line.sh [packets] [max payload bytes] [chunk bytes]
+#   CXX  compiler to build the benchmark with (default: g++)
+set -e
+
+CYAN='\033[0;36m'
+NC='\033[0m'
+
+PROJECT_ROOT=$(cd "$(dirname "$0")/.." && pwd)
+CXX=${CXX:-g++}
+
+WORKDIR=$(mktemp -d)
+trap 'rm -rf "$WORKDIR"' EXIT
+
+echo -e "${CYAN}Building the pkt-line benchmark...${NC}"
+"$CXX" -std=c++2b -O2 -o "$WORKDIR/bench_pkt_line" \
+    "$PROJECT_ROOT/bench/bench_pkt_line.cpp" "$PROJECT_ROOT/src/utils/pkt_line_utils.cpp"
+
+"$WORKDIR/bench_pkt_line" "${1:-1000000}" "${2:-256}" "${3:-16384}"
@@ -0,0 +1,62 @@
+#!/bin/bash
+# Benchmarks `rev-list` over a long synthetic history against git, with and
+# without a commit graph. The history has COMMITS commits on a main line; every
+# tenth commit goes to a side branch instead, which main merges back every
+# hundred commits. Output goes to /dev/null, so the time measured is the walk.
+#
+# Usage: bench/bench_rev_list.sh [commits]
+#   MYGIT_EXEC  mygit binary to measure (default: build/mygit)
+set -e
+
+CYAN='\033[0;36m'
+GREEN='\033[0;32m'
+NC='\033[0m'
+
+PROJECT_ROOT=$(cd "$(dirname "$0")/.." && pwd)
+MYGIT_EXEC=${MYGIT_EXEC:-"$PROJECT_ROOT/build/mygit"}
+COMMITS=${1:-1000000}
+
+WORKDIR=$(mktemp -d)
+trap 'rm -rf "$WORKDIR"' EXIT
+
+git init --quiet "$WORKDIR/repo"
+cd "$WORKDIR/repo"
+
+echo -e "${CYAN}Building a history of $COMMITS commits...${NC}"
+# fast-import writes every commit straight into a pack. Commits have no
+# files, so the history is all there is to read.
+awk -v n="$COMMITS" 'BEGIN {
+    side = 0
+    for (i = 1; i <= n; i++) {
+        branch = (i % 10 == 5 && i > 10) ? "side" : "main"
+        printf "commit refs/heads/%s\nmark :%d\ncommitter bench <bench@example.com> %d +0000\ndata 0\n", branch, i, 1000000000 + i
+        if (branch == "side" && side == 0) printf "from :%d\n", i - 1
+        if (branch == "side") side = i
+        if (branch == "main" && i % 100 == 0 && side) printf "merge :%d\n", side
+    }
+}' | git fast-import --quiet
+tip=$(git rev-parse main)
+
+# Prints the wall time of a command in milliseconds.
+time_ms() {
+    local start
+    start=$(date +%s%N)
+    "$@" > /dev/null
+    echo $(( ($(date +%s%N) - start) / 1000000 ))
+}
+
+echo -e "${CYAN}rev-list main without a commit graph:${NC}"
+[ "$("$MYGIT_EXEC" rev-list main | md5sum)" == "$(git rev-list main | md5sum)" ] || { echo "rev-list differs from git"; exit 1; }
+mine=$(time_ms "$MYGIT_EXEC" rev-list "$tip")
+theirs=$(time_ms git -c core.commitGraph=false rev-list "$tip")
+echo -e "${GREEN}mygit ${mine} ms, git ${theirs} ms${NC}"
+
+echo -e "${CYAN}commit-graph write:${NC}"
+mine=$(time_ms "$MYGIT_EXEC" commit-graph write)
+echo -e "${GREEN}mygit ${mine} ms${NC}"
+
+echo -e "${CYAN}rev-list main with the commit graph:${NC}"
+[ "$("$MYGIT_EXEC" rev-list main | md5sum)" == "$(git rev-list main | md5sum)" ] || { echo "rev-list differs from git"; exit 1; }
+mine=$(time_ms "$MYGIT_EXEC" rev-list "$tip")
+theirs=$(time_ms git rev-list "$tip")
+echo -e "${GREEN}mygit ${mine} ms, git ${theirs} ms${NC}"
@@ -0,0 +1,67 @@
+#!/bin/bash
+# Benchmarks a full checkout against sparse checkouts of a few directories
+# of a large tree. The tree has DIRS directories of FILES files; the sparse
+# cones keep 1 and 10 of them. Time and disk use should follow the size of
+# the cone, since the trees outside it are never read.
+#
+# Usage: bench/bench_sparse_checkout.sh [dirs] [files per dir]
+#   MYGIT_EXEC  mygit binary to measure (default: build/mygit)
+set -e
+
+CYAN='\033[0;36m'
+GREEN='\033[0;32m'
+NC='\033[0m'
+
+PROJECT_ROOT=$(cd "$(dirname "$0")/.." && pwd)
+MYGIT_EXEC=${MYGIT_EXEC:-"$PROJECT_ROOT/build/mygit"}
+DIRS=${1:-500}
+FILES=${2:-200}
+
+WORKDIR=$(mktemp -d)
+trap 'rm -rf "$WORKDIR"' EXIT
+
+git init --quiet "$WORKDIR/repo"
+cd "$WORKDIR/repo"
+
+echo -e "${CYAN}Building a tree of $DIRS directories with $FILES files each...${NC}"
+awk -v dirs="$DIRS" -v files="$FILES" 'BEGIN {
+    print "commit refs/heads/main\ncommitter bench <bench@example.com> 0 +0000\ndata 0"
+    for (d = 0; d < dirs; d++)
+        for (f = 0; f < files; f++)
+            printf "M 100644 inline dir%d/sub/file%d\ndata %d\n%s\n", d, f, length(d "/" f), d "/" f
+}' | git fast-import --quiet
+git repack --quiet -a -d
+
+# Prints the wall time of a command in milliseconds.
+time_ms() {
+    local start
+    start=$(date +%s%N)
+    "$@" > /dev/null
+    echo $(( ($(date +%s%N) - start) / 1000000 ))
+}
+
+# Checks out main into a fresh working directory sharing the object store.
+# Arguments: the directories of the cone; none means a full checkout.
+checkout() {
+    local label=$1
+    shift
+    rm -rf "$WORKDIR/wt" && mkdir -p "$WORKDIR/wt/.git/refs/heads"
+    ln -s "$WORKDIR/repo/.git/objects" "$WORKDIR/wt/.git/objects"
+    cp "$WORKDIR/repo/.git/refs/heads/main" "$WORKDIR/wt/.git/refs/heads/main"
+    echo "ref: refs/heads/unborn" > "$WORKDIR/wt/.git/HEAD"
+    sync # Keep the writeback of the previous run out of the timing.
+    cd "$WORKDIR/wt"
+    if [ $# -gt 0 ]; then
+        "$MYGIT_EXEC" sparse-checkout set "$@"
+    fi
+    local ms
+    ms=$(time_ms "$MYGIT_EXEC" checkout main)
+    local files
+    files=$(find . -path ./.git -prune -o -type f -print | wc -l)
+    echo -e "${GREEN}$label: $files files in ${ms} ms, $(du -sh --exclude=.git . | cut -f1) on disk${NC}"
+    cd "$WORKDIR/repo"
+}
+
+checkout "full checkout"
+checkout "sparse, 10 directories" $(seq -f "dir%g" 0 $(( DIRS / 10 )) $(( DIRS - 1 )) | head -10)
+checkout "sparse, 1 directory" dir0
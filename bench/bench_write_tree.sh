@@ -0,0 +1,84 @@
+#!/bin/bash
+# Benchmarks write-tree on a synthetic directory of many files, with one thread
+# and with several, then a no-op run served by the stat cache, then loose
+# writes against --packed ones with the number of files each leaves in
+# .git/objects. Every run must produce git's tree SHA.
+#
+# Usage: bench/bench_write_tree.sh [directories] [files per directory] [runs]
+#   MYGIT_EXEC  mygit binary to measure (default: build/mygit)
+set -e
+
+CYAN='\033[0;36m'
+GREEN='\033[0;32m'
+NC='\033[0m'
+
+PROJECT_ROOT=$(cd "$(dirname "$0")/.." && pwd)
+MYGIT_EXEC=${MYGIT_EXEC:-"$PROJECT_ROOT/build/mygit"}
+DIRS=${1:-200}
+FILES=${2:-250}
+RUNS=${3:-3}
+
+WORKDIR=$(mktemp -d)
+trap 'rm -rf "$WORKDIR"' EXIT
+
+echo -e "${CYAN}Building a tree of $DIRS directories x $FILES files...${NC}"
+git init --quiet "$WORKDIR/repo"
+cd "$WORKDIR/repo"
+for d in $(seq 1 "$DIRS"); do
+    mkdir -p "dir_$d/sub"
+    for f in $(seq 1 "$FILES"); do
+        if [ $((f % 2)) -eq 0 ]; then path="dir_$d/sub/file_$f.txt"; else path="dir_$d/file_$f.txt"; fi
+        seq "$f" $((f + 200 + (d * f) % 2000)) > "$path"
+    done
+done
+git add .
+EXPECTED=$(git write-tree)
+echo "Tree: $(git ls-files | wc -l) files, $(du -sh --exclude=.git . | cut -f1)"
+
+for threads in $(echo 1 4 "$(nproc)" | tr ' ' '\n' | sort -un); do
+    best=""
+    for _ in $(seq 1 "$RUNS"); do
+        # Start from an empty object store and no stat cache so every blob is compressed and written.
+        rm -rf .git/objects/?? .git/objects/pack .git/stat-cache
+        start=$(date +%s%N)
+        actual=$("$MYGIT_EXEC" write-tree -j "$threads")
+        elapsed=$(( ($(date +%s%N) - start) / 1000000 ))
+        [ "$actual" == "$EXPECTED" ] || { echo "write-tree -j $threads gave $actual, expected $EXPECTED"; exit 1; }
+        if [ -z "$best" ] || [ "$elapsed" -lt "$best" ]; then best=$elapsed; fi
+    done
+    files=$(git ls-files | wc -l)
+    echo -e "${GREEN}write-tree -j $threads: ${best} ms (best of $RUNS), $(awk "BEGIN { printf \"%.0f\", $files * 1000 / $best }") files/s${NC}"
+done
+
+# Nothing changed since the last run: only stat() calls are left.
+best=""
+for _ in $(seq 1 "$RUNS"); do
+    start=$(date +%s%N)
+    actual=$("$MYGIT_EXEC" write-tree)
+    elapsed=$(( ($(date +%s%N) - start) / 1000000 ))
+    [ "$actual" == "$EXPECTED" ] || { echo "no-op write-tree gave $actual, expected $EXPECTED"; exit 1; }
+    if [ -z "$best" ] || [ "$elapsed" -lt "$best" ]; then best=$elapsed; fi
+done
+echo -e "${GREEN}write-tree, no change: ${best} ms (best of $RUNS)${NC}"
+
+# Loose objects cost a file, and an inode, each; --packed writes one pack and its index.
+threads=$(nproc)
+for mode in loose packed; do
+    best=""
+    for _ in $(seq 1 "$RUNS"); do
+        rm -rf .git/objects/?? .git/objects/pack .git/stat-cache
+        start=$(date +%s%N)
+        if [ "$mode" == "packed" ]; then
+            actual=$("$MYGIT_EXEC" write-tree -j "$threads" --packed)
+        else
+            actual=$("$MYGIT_EXEC" write-tree -j "$threads")
+        fi
+        elapsed=$(( ($(date +%s%N) - start) / 1000000 ))
+        [ "$actual" == "$EXPECTED" ] || { echo "$mode write-tree gave $actual, expected $EXPECTED"; exit 1; }
+        if [ -z "$best" ] || [ "$elapsed" -lt "$best" ]; then best=$elapsed; fi
+    done
+    inodes=$(find .git/objects -type f | wc -l)
+    files=$(git ls-files | wc -l)
+    echo -e "${GREEN}write-tree -j $threads, $mode: ${best} ms (best of $RUNS), $(awk "BEGIN { printf \"%.0f\", $files * 1000 / $best }") files/s, $inodes files in .git/objects${NC}"
+done
+git fsck --no-dangling 2> /dev/null || { echo "git fsck rejects the packed objects"; exit 1; }
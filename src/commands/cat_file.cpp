@@ -1,23 +1,102 @@
 #include "../include/cat_file.h"
 #include "../include/object_utils.h"
 
+#include <algorithm>
 #include <iostream>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <optional>
 
+// Serves `--batch` (withContent) and `--batch-check`: one object name per
+// line of stdin, one "<sha> <type> <size>" record per name on stdout.
+// Objects read for --batch go through the process-wide object cache, so a
+// name asked for again is answered without inflating it a second time. --batch-check
+// reads headers only and does not need the cache.
+static int runBatch(bool withContent) {
+    // stdout is buffered for the whole session. It is flushed only when no
+    // more input is waiting, so a caller that writes one name and waits for
+    // its answer still gets it, and a piped list is answered in big writes.
+    std::ios::sync_with_stdio(false);
+    std::cin.tie(nullptr);
+    std::cout << std::nounitbuf;
+
+    std::string name;
+    while (true) {
+        if (std::cin.rdbuf()->in_avail() <= 0) {
+            std::cout.flush();
+        }
+        if (!std::getline(std::cin, name)) {
+            break;
+        }
+
+        const auto id = ObjectId::fromHex(name);
+        if (!id) {
+            std::cout << name << " missing\n";
+            continue;
+        }
+
+        if (!withContent) {
+            // --batch-check needs only the header, which is read without the content.
+            if (auto info = readGitObjectInfo(*id)) {
+                std::cout << name << ' ' << info->type << ' ' << info->size << '\n';
+            } else {
+                std::cout << name << " missing\n";
+            }
+            continue;
+        }
+
+        auto object = readCachedGitObject(*id);
+        auto parts = object ? splitObject(*object) : std::nullopt;
+        if (!parts) {
+            std::cout << name << " missing\n";
+            continue;
+        }
+        const auto& [type, content] = *parts;
+        std::cout << name << ' ' << type << ' ' << content.size() << '\n';
+        std::cout.write(reinterpret_cast<const char*>(content.data()), static_cast<std::streamsize>(content.size()));
+        std::cout << '\n';
+    }
+    std::cout.flush();
+    return std::cout ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
 int handleCatFile(int argc, char* argv[]) {
-    // This implementation only supports the '-p' (pretty-print) option.
-    if (argc != 4 || std::string(argv[2]) != "-p") {
-        std::cerr << "Usage: mygit cat-file -p <blob-sha>\n";
+    if (argc == 3 && (std::string_view(argv[2]) == "--batch" || std::string_view(argv[2]) == "--batch-check")) {
+        return runBatch(std::string_view(argv[2]) == "--batch");
+    }
+
+    // Supports '-p' (pretty-print), '-t' (type) and '-s' (size).
+    const std::string option = argc == 4 ? argv[2] : "";
+    if (option != "-p" && option != "-t" && option != "-s") {
+        std::cerr << "Usage: mygit cat-file (-p | -t | -s) <object-sha>\n"
+                  << "       mygit cat-file (--batch | --batch-check) < <object-shas>\n";
         return EXIT_FAILURE;
     }
 
-    const std::string objectId = argv[3];
-    auto decompressedDataOpt = readGitObject(objectId);
+    const std::string objectName = argv[3];
+    const auto objectId = ObjectId::fromHex(objectName);
+
+    // The type and size come from the object's header, so the content is never inflated.
+    if (option != "-p") {
+        auto info = objectId ? readGitObjectInfo(*objectId) : std::nullopt;
+        if (!info) {
+            std::cerr << "Fatal: Not a valid object name " << objectName << '\n';
+            return EXIT_FAILURE;
+        }
+        if (option == "-t") {
+            std::cout << info->type << '\n';
+        } else {
+            std::cout << info->size << '\n';
+        }
+        return EXIT_SUCCESS;
+    }
+
+    auto decompressedDataOpt = objectId ? readGitObject(*objectId) : std::nullopt;
 
     if (!decompressedDataOpt) {
-        std::cerr << "Fatal: Not a valid object name " << objectId << '\n';
+        std::cerr << "Fatal: Not a valid object name " << objectName << '\n';
         return EXIT_FAILURE;
     }
     
@@ -41,4 +120,4 @@ int handleCatFile(int argc, char* argv[]) {
     std::cout.write(contentStart, contentSize);
 
     return EXIT_SUCCESS;
-}
\ No newline at end of file
+}
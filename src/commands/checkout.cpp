@@ -0,0 +1,104 @@
+#include "../include/checkout.h"
+#include "../include/checkout_utils.h"
+#include "../include/constants.h"
+#include "../include/refs.h"
+#include "../include/sparse_checkout.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+
+namespace {
+    // Returns the branch a revision names, e.g. "main" for "main" or "refs/heads/main", if any.
+    std::optional<std::string> branchRef(std::string_view revision) {
+        if (ObjectId::fromHex(revision)) {
+            return std::nullopt;
+        }
+        const std::string ref = revision.starts_with("refs/heads/") ? std::string(revision)
+                                                                     : "refs/heads/" + std::string(revision);
+        return resolveRevision(ref) ? std::optional(ref) : std::nullopt;
+    }
+
+    // Writes HEAD under a temporary name and renames it into place, so it is never half-written.
+    bool writeHead(const std::string& content) {
+        const std::filesystem::path head = constants::GIT_DIR / constants::HEAD_FILE_NAME;
+        std::filesystem::path lock = head;
+        lock += ".lock";
+        {
+            std::ofstream file(lock, std::ios::binary | std::ios::trunc);
+            if (!(file << content << '\n') || !file.flush()) {
+                return false;
+            }
+        }
+        std::error_code ec;
+        std::filesystem::rename(lock, head, ec);
+        return !ec;
+    }
+}
+
+int handleCheckout(int argc, char* argv[]) {
+    // Default to one writer thread per core.
+    unsigned int numWorkers = std::max(1u, std::thread::hardware_concurrency());
+    bool force = false;
+    std::string revision;
+    bool validArgs = true;
+    for (int i = 2; i < argc && validArgs; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "-j" && i + 1 < argc) {
+            try {
+                numWorkers = static_cast<unsigned int>(std::stoul(argv[++i]));
+            } catch (const std::exception&) {
+                numWorkers = 0;
+            }
+            validArgs = numWorkers > 0;
+        } else if (arg == "-f" || arg == "--force") {
+            force = true;
+        } else if (revision.empty() && !arg.starts_with("-")) {
+            revision = arg;
+        } else {
+            validArgs = false;
+        }
+    }
+    if (!validArgs || revision.empty()) {
+        std::cerr << "Usage: mygit checkout [-f] [-j <threads>] <commit>\n";
+        return EXIT_FAILURE;
+    }
+
+    const std::optional<ObjectId> target = resolveCommit(revision);
+    const std::optional<ObjectId> targetTree = target ? resolveTreeish(target->toHex()) : std::nullopt;
+    if (!targetTree) {
+        std::cerr << "Fatal: Not a valid commit: " << revision << '\n';
+        return EXIT_FAILURE;
+    }
+    // An unborn HEAD has no tree yet: every file of the target is new.
+    const std::optional<ObjectId> headTree = resolveTreeish(constants::HEAD_FILE_NAME);
+
+    // A sparse checkout only touches the files inside its cone.
+    std::optional<SparseCone> cone;
+    try {
+        cone = SparseCone::load();
+    } catch (const std::runtime_error& e) {
+        std::cerr << "Fatal: " << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+
+    if (!checkoutTreeChanges(headTree, *targetTree, ".", numWorkers, force, cone ? &*cone : nullptr)) {
+        return EXIT_FAILURE;
+    }
+
+    const std::optional<std::string> branch = branchRef(revision);
+    if (!writeHead(branch ? "ref: " + *branch : target->toHex())) {
+        std::cerr << "Fatal: could not update HEAD\n";
+        return EXIT_FAILURE;
+    }
+    if (branch) {
+        std::cout << "Switched to branch '" << branch->substr(11) << "'\n";
+    } else {
+        std::cout << "HEAD is now at " << target->toHex().substr(0, 7) << "\n";
+    }
+    return EXIT_SUCCESS;
+}
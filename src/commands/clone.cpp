@@ -4,6 +4,12 @@
 #include "../include/object_utils.h"
 #include "../include/checkout_utils.h" 
 #include "../include/init.h"
+#include "../include/size_utils.h"
+#include "../include/constants.h"
+#include "../include/mapped_file.h"
+#include "../include/pack_store.h"
+#include "../include/sha1_utils.h"
+#include "../include/sparse_checkout.h"
 
 #include <cpr/cpr.h>  // Using a library for HTTP requests simplifies the logic.
 
@@ -12,26 +18,66 @@
 #include <vector>
 #include <optional>
 #include <map>
+#include <fstream>
+#include <algorithm>
+#include <thread>
 
 
 int handleClone(int argc, char* argv[]){
      std::string baseUrl;
     std::filesystem::path targetDir; 
 
+    size_t deltaCacheSize = constants::DEFAULT_DELTA_CACHE_SIZE;
+    uint32_t unpackLimit = 0; // Packs with fewer objects are exploded into loose objects.
+    bool sparse = false;      // Check out the files at the root only, as `git clone --sparse`.
+    // Default to one checkout worker per core.
+    unsigned int checkoutWorkers = std::max(1u, std::thread::hardware_concurrency());
+
     // --- 1. Argument Parsing ---
-    if (argc == 3) { // mygit clone <url>
-        baseUrl = argv[2];
+    // Options may appear anywhere; the remaining arguments are <url> [<directory>].
+    std::vector<std::string> positional;
+    bool validArgs = true;
+    for (int i = 2; i < argc && validArgs; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "-j" && i + 1 < argc) {
+            try {
+                checkoutWorkers = static_cast<unsigned int>(std::stoul(argv[++i]));
+            } catch (const std::exception&) {
+                checkoutWorkers = 0;
+            }
+            validArgs = checkoutWorkers > 0;
+        } else if (arg.starts_with("--delta-cache-size=")) {
+            auto size = parseByteSize(std::string_view(arg).substr(arg.find('=') + 1));
+            validArgs = size.has_value();
+            deltaCacheSize = size.value_or(0);
+        } else if (arg.starts_with("--unpack-limit=")) {
+            try {
+                unpackLimit = static_cast<uint32_t>(std::stoul(arg.substr(arg.find('=') + 1)));
+            } catch (const std::exception&) {
+                validArgs = false;
+            }
+        } else if (arg == "--sparse") {
+            sparse = true;
+        } else if (arg.starts_with("-")) {
+            validArgs = false;
+        } else {
+            positional.push_back(arg);
+        }
+    }
+
+    if (validArgs && positional.size() == 1) { // mygit clone <url>
+        baseUrl = positional[0];
         // Infer directory name from URL, e.g., https://github.com/user/repo.git -> repo
         std::string repoName = baseUrl.substr(baseUrl.find_last_of('/') + 1);
         if (repoName.ends_with(".git")) {
             repoName.resize(repoName.size() - 4);
         }
         targetDir = repoName;
-    } else if (argc == 4) { // mygit clone <url> <dir>
-        baseUrl = argv[2];
-        targetDir = argv[3];
+    } else if (validArgs && positional.size() == 2) { // mygit clone <url> <dir>
+        baseUrl = positional[0];
+        targetDir = positional[1];
     } else {
-        std::cerr << "Usage: mygit clone <url> [<directory>]\n";
+        std::cerr << "Usage: mygit clone [-j <workers>] [--delta-cache-size=<n>[k|m|g]] [--unpack-limit=<n>] [--sparse] <url> [<directory>]\n";
         return EXIT_FAILURE;
     }
 
@@ -69,7 +115,8 @@ int handleClone(int argc, char* argv[]){
 
      // From the response, find the SHA of the main branch (master or main).
     auto sha1HexMain = findMainBranchSha1(discoveryResp.text);
-    if (!sha1HexMain) {
+    auto mainCommit = sha1HexMain ? ObjectId::fromHex(*sha1HexMain) : std::nullopt;
+    if (!mainCommit) {
         std::cerr << "Couldn't find the main Sha1 \n" ;
         return EXIT_FAILURE;
     }
@@ -82,58 +129,149 @@ int handleClone(int argc, char* argv[]){
     requestBodyStream << createPktLine("");       // Flush packet
     requestBodyStream << createPktLine("done\n"); // We are done specifying what we want.
 
-     cpr::Response bodyResp = cpr::Post(cpr::Url{baseUrl + "/git-upload-pack"},
+    // --- 5. Stream the Packfile Into the Object Database ---
+    // The response is never held in memory. Each chunk cpr receives goes
+    // through the side-band demuxer; the packfile band is appended to a spool
+    // file in .git/objects/pack and fed to the scanner at the same time. The
+    // pack is normally kept as is. Only a pack with fewer objects than
+    // --unpack-limit is exploded: the scanner then hands base objects to the
+    // handler below, which writes them into .git/objects right away.
+    int written_count = 0;
+
+    auto writeObject = [&](const PackObjectInfo& obj_info, std::span<const std::byte> data) {
+        std::string header_str = typeToStringMap.at(obj_info.type) + " " + std::to_string(data.size()) + '\0';
+
+        std::vector<std::byte> full_object_content;
+        full_object_content.reserve(header_str.size() + data.size());
+        auto headerBytes = std::as_bytes(std::span{header_str});
+        full_object_content.insert(full_object_content.end(), headerBytes.begin(), headerBytes.end());
+        full_object_content.insert(full_object_content.end(), data.begin(), data.end());
+
+        if (!writeGitObject(full_object_content)) {
+            throw std::runtime_error("failed to write object " + obj_info.sha1.toHex() + " to disk");
+        }
+        written_count++;
+    };
+
+    std::filesystem::create_directories(constants::PACK_DIR);
+    const std::filesystem::path spoolPath = constants::PACK_DIR / "tmp_pack_incoming";
+    std::ofstream spool(spoolPath, std::ios::binary | std::ios::trunc);
+    if (!spool) {
+        std::cerr << "Fatal: cannot create " << spoolPath.string() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    PackStreamScanner scanner;
+    if (unpackLimit > 0) {
+        // The handler runs after the pack header, so the object count is known by then.
+        scanner.setObjectHandler([&](const PackObjectInfo& obj_info, std::span<const std::byte> data) {
+            if (scanner.objectCount() < unpackLimit) writeObject(obj_info, data);
+        });
+    }
+    SideBandDemuxer demuxer([&](std::span<const std::byte> packData) {
+        spool.write(reinterpret_cast<const char*>(packData.data()), static_cast<std::streamsize>(packData.size()));
+        if (!spool) {
+            throw std::runtime_error("failed to write " + spoolPath.string());
+        }
+        scanner.feed(packData);
+    });
+
+    // Returning false from the callback makes cpr abort the transfer.
+    std::string streamError;
+    cpr::Response bodyResp = cpr::Post(cpr::Url{baseUrl + "/git-upload-pack"},
                                        cpr::Header{{"Content-Type", "application/x-git-upload-pack-request"},
                                                    {"Accept", "application/x-git-upload-pack-result"}},
-                                       cpr::Body{requestBodyStream.str()});
+                                       cpr::Body{requestBodyStream.str()},
+                                       cpr::WriteCallback{[&](const std::string_view& chunk, intptr_t) -> bool {
+                                           try {
+                                               return demuxer.feed(chunk);
+                                           } catch (const std::exception& e) {
+                                               streamError = e.what();
+                                               return false;
+                                           }
+                                       }});
+    spool.close();
 
+    if (!streamError.empty()) {
+        std::cerr << "Critical error: " << streamError << "\n";
+        std::filesystem::remove(spoolPath);
+        return EXIT_FAILURE;
+    }
     if (bodyResp.status_code != 200) {
         std::cerr << "Error during POST request. Status: " << bodyResp.status_code << "\n";
+        std::filesystem::remove(spoolPath);
         return EXIT_FAILURE;
     }
-
-    // --- 5. Process Packfile ---
-    // The server's response is multiplexed. We need to extract the raw packfile data.
-    auto packfile_opt = extractPackfileData(bodyResp.text);
-    if (!packfile_opt) {
+    if (!scanner.isComplete()) {
         std::cerr << "Couldn't read the packfile from the server response.\n";
+        std::filesystem::remove(spoolPath);
         return EXIT_FAILURE;
     }
 
-    // Parse the packfile to get individual objects, resolving any deltas.
-    std::vector<std::byte>& packfile = *packfile_opt;
-    PackfileParser parser(packfile);
-    auto objects_opt = parser.parseAndResolve();
+    // --- 6. Resolve Deltas From the Spooled Packfile ---
+    // Deltas were only walked through while streaming. Now that the whole pack
+    // is on disk, the parser maps it and resolves every delta chain to learn
+    // each object's SHA-1. When unpacking, every reconstructed object also goes
+    // to the same handler.
+    const bool unpack = scanner.objectCount() < unpackLimit;
+    std::optional<std::vector<PackObjectInfo>> objects_opt;
+    {
+        auto packfile = MappedFile::open(spoolPath);
+        if (!packfile) {
+            std::cerr << "Fatal: cannot map " << spoolPath.string() << "\n";
+            return EXIT_FAILURE;
+        }
+        PackfileParser parser(packfile->bytes(), 1, deltaCacheSize);
+        if (unpack) {
+            parser.setObjectHandler(writeObject);
+        }
+        try {
+            objects_opt = parser.resolveDeltas(scanner.takeObjects());
+        } catch (const std::exception& e) {
+            std::cerr << "Critical error: " << e.what() << "\n";
+            std::filesystem::remove(spoolPath);
+            return EXIT_FAILURE;
+        }
+    }
     if (!objects_opt){
         std::cerr << "Couldn't parse the packfile \n";
+        std::filesystem::remove(spoolPath);
         return EXIT_FAILURE;
     }
 
-    std::vector<PackObjectInfo> objects = *objects_opt;
-    std::cout << "Analysis complete. Found " << objects.size() << " objects.\n";
-
-    // --- 6. Write Objects to Local Database ---
-    // Take the resolved objects from the packfile and write them into the .git/objects directory.
-    const auto& resolved_data_map = parser.getResolvedObjectsData();
-    int written_count = 0;
-    for (const auto& obj_info : objects) {
-        const auto& data = resolved_data_map.at(obj_info.sha1);
-        std::string header_str = typeToStringMap.at(obj_info.type) + " " + std::to_string(data.size()) + '\0';
-
-        std::vector<std::byte> full_object_content;
-        auto headerBytes = std::as_bytes(std::span{header_str});
-        full_object_content.insert(full_object_content.end(), headerBytes.begin(), headerBytes.end());
-        full_object_content.insert(full_object_content.end(), data.begin(), data.end());
-
-        if (!writeGitObject(full_object_content)) {
-            std::cerr << "Critical error: failed to write object " << obj_info.sha1 << " to disk.\n";
+    // --- 7. Store the Packfile ---
+    // Like Git, keep the pack verbatim as pack-<checksum>.pack next to its
+    // index. The index is written last under a temporary name: a pack only
+    // becomes visible to readers once its .idx exists.
+    if (unpack) {
+        std::filesystem::remove(spoolPath);
+        // Checkout reads these objects back, so they must be in place first.
+        try {
+            flushObjectWrites();
+        } catch (const std::exception& e) {
+            std::cerr << "Fatal: " << e.what() << "\n";
             return EXIT_FAILURE;
         }
-        written_count++;
+        std::cout << written_count << " objects successfully written to .git/objects.\n";
+    } else {
+        const std::string packName = "pack-" + bytesToHex(scanner.packChecksum());
+        const std::filesystem::path tmpIdxPath = constants::PACK_DIR / "tmp_idx_incoming";
+        try {
+            syncFileForPolicy(spoolPath);
+            std::filesystem::rename(spoolPath, constants::PACK_DIR / (packName + ".pack"));
+            if (!writePackIndex(tmpIdxPath, *objects_opt, scanner.packChecksum())) {
+                throw std::runtime_error("cannot write " + tmpIdxPath.string());
+            }
+            syncFileForPolicy(tmpIdxPath);
+            std::filesystem::rename(tmpIdxPath, constants::PACK_DIR / (packName + ".idx"));
+        } catch (const std::exception& e) {
+            std::cerr << "Fatal: failed to store the packfile: " << e.what() << "\n";
+            return EXIT_FAILURE;
+        }
+        std::cout << "Stored " << objects_opt->size() << " objects in .git/objects/pack/" << packName << ".pack\n";
     }
-    std::cout << written_count << " objects successfully written to .git/objects.\n";
 
-    // --- 7. Update Local References ---
+    // --- 8. Update Local References ---
     // Point the local 'main' branch and HEAD to the commit we just fetched.
     try {
         std::filesystem::path mainRefPath = std::filesystem::path(".git") / "refs" / "heads" / "main";
@@ -149,10 +287,20 @@ int handleClone(int argc, char* argv[]){
         return EXIT_FAILURE;
     }
 
-    // --- 8. Checkout Files ---
+    // --- 9. Checkout Files ---
     // Populate the working directory with the files from the main branch commit.
+    // With --sparse, the cone starts with the files at the root only;
+    // `sparse-checkout set` adds directories later.
+    std::optional<SparseCone> cone;
+    if (sparse) {
+        cone = SparseCone(std::vector<std::string>{});
+        if (!cone->save()) {
+            std::cerr << "Fatal: failed to write " << constants::SPARSE_CHECKOUT_FILE << "\n";
+            return EXIT_FAILURE;
+        }
+    }
     std::cout << "Checking out files from main branch...\n";
-    if (!checkoutCommit(*sha1HexMain, ".")) { // "." is the current directory.
+    if (!checkoutCommit(*mainCommit, ".", checkoutWorkers, cone ? &*cone : nullptr)) { // "." is the current directory.
         std::cerr << "Fatal: Failed to checkout files from the main branch.\n";
         return EXIT_FAILURE;
     }
@@ -0,0 +1,40 @@
+#include "../include/commit_graph.h"
+#include "../include/refs.h"
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+int handleCommitGraph(int argc, char* argv[]) {
+    CommitGraphWriteOptions options;
+    bool validArgs = argc >= 3 && std::string(argv[2]) == "write";
+    for (int i = 3; i < argc && validArgs; ++i) {
+        if (std::string(argv[i]) == "--changed-paths") {
+            options.changedPaths = true;
+        } else {
+            validArgs = false;
+        }
+    }
+    if (!validArgs) {
+        std::cerr << "Usage: mygit commit-graph write [--changed-paths]\n";
+        return EXIT_FAILURE;
+    }
+
+    // The graph covers everything reachable from HEAD and the refs.
+    std::vector<ObjectId> tips;
+    if (auto head = resolveRevision("HEAD")) {
+        tips.push_back(*head);
+    }
+    for (const auto& ref : listRefs()) {
+        tips.push_back(ref.second);
+    }
+
+    try {
+        writeCommitGraph(tips, options);
+    } catch (const std::exception& e) {
+        std::cerr << "Fatal: " << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -51,7 +51,7 @@ int handleCommitTree(int argc, char* argv[]){
     // Write the complete object to the database and print its SHA.
     auto sha1BytesOpt = writeGitObject(std::as_bytes(std::span{fullCommitObjectStr}));
     if (sha1BytesOpt) {
-        std::cout << bytesToHex(*sha1BytesOpt) << "\n";
+        std::cout << sha1BytesOpt->toHex() << "\n";
     } else {
         std::cerr << "Failed to write commit object.\n";
         return EXIT_FAILURE;
@@ -0,0 +1,95 @@
+#include "../include/diff_tree.h"
+#include "../include/output_buffer.h"
+#include "../include/refs.h"
+#include "../include/tree_diff.h"
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+    enum class DiffFormat { Raw, NameOnly, NameStatus };
+
+    // Appends a mode with 6 digits, as Git shows it: "40000" becomes "040000", none becomes "000000".
+    void appendMode(std::string_view mode, OutputBuffer& out) {
+        for (size_t i = mode.size(); i < 6; ++i) {
+            out << '0';
+        }
+        out << mode;
+    }
+
+    void appendId(const ObjectId& id, OutputBuffer& out) {
+        char hex[ObjectId::HEX_SIZE];
+        id.toHex(hex);
+        out << std::string_view(hex, sizeof(hex));
+    }
+}
+
+int handleDiffTree(int argc, char* argv[]) {
+    TreeDiffOptions options;
+    options.recursive = false;
+    DiffFormat format = DiffFormat::Raw;
+    std::vector<std::string> revisions;
+    bool validArgs = true;
+    for (int i = 2; i < argc && validArgs; ++i) {
+        const std::string_view arg = argv[i];
+        if (arg == "--name-only") {
+            format = DiffFormat::NameOnly;
+        } else if (arg == "--name-status") {
+            format = DiffFormat::NameStatus;
+        } else if (arg.size() > 1 && arg[0] == '-' && arg[1] != '-') {
+            // Short flags may be combined, as in "-rt".
+            for (char flag : arg.substr(1)) {
+                if (flag == 'r') options.recursive = true;
+                else if (flag == 't') options.recursive = options.showTrees = true; // -t implies -r.
+                else validArgs = false;
+            }
+        } else if (!arg.starts_with("-")) {
+            revisions.emplace_back(arg);
+        } else {
+            validArgs = false;
+        }
+    }
+    if (!validArgs || revisions.size() != 2) {
+        std::cerr << "Usage: mygit diff-tree [-r] [-t] [--name-only | --name-status] <tree-ish> <tree-ish>\n";
+        return EXIT_FAILURE;
+    }
+
+    std::optional<ObjectId> trees[2];
+    for (size_t i = 0; i < 2; ++i) {
+        trees[i] = resolveTreeish(revisions[i]);
+        if (!trees[i]) {
+            std::cerr << "Fatal: Not a valid tree-ish: " << revisions[i] << '\n';
+            return EXIT_FAILURE;
+        }
+    }
+
+    OutputBuffer out(std::cout);
+    try {
+        diffTrees(trees[0], trees[1], options, [&](const TreeChange& change) {
+            if (format == DiffFormat::Raw) {
+                out << ':';
+                appendMode(change.oldMode, out);
+                out << ' ';
+                appendMode(change.newMode, out);
+                out << ' ';
+                appendId(change.oldId, out);
+                out << ' ';
+                appendId(change.newId, out);
+                out << ' ' << change.status << '\t';
+            } else if (format == DiffFormat::NameStatus) {
+                out << change.status << '\t';
+            }
+            out << change.path << '\n';
+            return true;
+        });
+    } catch (const std::runtime_error& e) {
+        out.flush();
+        std::cerr << "Fatal: " << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+    out.flush();
+    return out.good() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
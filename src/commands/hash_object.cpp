@@ -1,6 +1,7 @@
 #include "../include/hash_object.h"
 #include "../include/constants.h"
 #include "../include/object_utils.h"
+#include "../include/bulk_checkin.h"
 #include "../include/sha1_utils.h"
 
 #include <iostream>
@@ -9,57 +10,109 @@
 #include <string>
 #include <optional>
 #include <algorithm>
+#include <stdexcept>
 
+// Files up to this size are read whole; larger ones are streamed in chunks.
+static constexpr uint64_t STREAMING_THRESHOLD = 1024 * 1024;
+static constexpr size_t READ_CHUNK_SIZE = 64 * 1024;
 
 // Internal implementation for creating and writing a blob object.
-std::optional<std::vector<std::byte>> createBlobAndGetRawSha(const std::filesystem::path& filePath) {
+std::optional<ObjectId> createBlobAndGetRawSha(const std::filesystem::path& filePath) {
+    std::error_code ec;
+    const uint64_t fileSize = std::filesystem::file_size(filePath, ec);
     std::ifstream inFile(filePath, std::ios::binary);
-    if (!inFile) {
+    if (ec || !inFile) {
         return std::nullopt; 
     }
 
-    // Read file content into a buffer.
-    const std::vector<char> fileContent(
-        (std::istreambuf_iterator<char>(inFile)),
-        std::istreambuf_iterator<char>()
-    );
-
     // Prepare the Git object header: "blob <size>\0".
-    std::string header = "blob " + std::to_string(fileContent.size()) + '\0';
-    
-    // Construct the full object content (header + data) as a byte vector.
-    std::vector<std::byte> blobContent;
-    blobContent.reserve(header.length() + fileContent.size());
+    std::string header = "blob " + std::to_string(fileSize) + '\0';
 
-    // Insert header bytes directly
-    blobContent.insert(blobContent.end(), 
-                    reinterpret_cast<const std::byte*>(header.data()), 
-                    reinterpret_cast<const std::byte*>(header.data()) + header.length());
+    if (fileSize <= STREAMING_THRESHOLD) {
+        // Read the file straight into place after the header.
+        std::vector<std::byte> blobContent(header.size() + fileSize);
+        std::copy_n(reinterpret_cast<const std::byte*>(header.data()), header.size(), blobContent.begin());
+        inFile.read(reinterpret_cast<char*>(blobContent.data() + header.size()), static_cast<std::streamsize>(fileSize));
+        if (static_cast<uint64_t>(inFile.gcount()) != fileSize || inFile.peek() != std::ifstream::traits_type::eof()) {
+            std::cerr << "Error: " << filePath.string() << " changed while it was read\n";
+            return std::nullopt;
+        }
 
-    // Insert file content bytes directly
-    blobContent.insert(blobContent.end(), 
-                    reinterpret_cast<const std::byte*>(fileContent.data()), 
-                    reinterpret_cast<const std::byte*>(fileContent.data()) + fileContent.size());
+        // The writeGitObject function handles hashing, compression, and writing to disk.
+        return writeGitObject(blobContent);
+    }
 
-    // The writeGitObject function handles hashing, compression, and writing to disk.
-    return writeGitObject(blobContent);
+    // Large files are hashed and compressed chunk by chunk, so memory use
+    // stays the same whatever their size.
+    try {
+        if (auto* bulk = BulkCheckin::active()) {
+            return bulk->addStreamed("blob", fileSize, [&](std::span<std::byte> buffer) {
+                inFile.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+                if (inFile.bad()) {
+                    throw std::runtime_error("cannot read " + filePath.string());
+                }
+                return static_cast<size_t>(inFile.gcount());
+            });
+        }
+        LooseObjectWriter writer("blob", fileSize);
+        std::vector<std::byte> chunk(READ_CHUNK_SIZE);
+        while (inFile) {
+            inFile.read(reinterpret_cast<char*>(chunk.data()), static_cast<std::streamsize>(chunk.size()));
+            writer.write(std::span<const std::byte>(chunk.data(), static_cast<size_t>(inFile.gcount())));
+        }
+        if (!inFile.eof()) {
+            throw std::runtime_error("cannot read " + filePath.string());
+        }
+        return writer.commit();
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << '\n';
+        return std::nullopt;
+    }
 }
 
-// Command handler for `mygit hash-object -w <file>`.
+// Command handler for `mygit hash-object -w [--packed] <file>...`.
 int handleHashObject(int argc, char* argv[]) {
-    if (argc != 4 || std::string(argv[2]) != "-w") {
-        std::cerr << "Usage: mygit hash-object -w <file-path>\n";
+    bool packed = false;
+    std::vector<std::filesystem::path> files;
+    bool validArgs = argc >= 4 && std::string_view(argv[2]) == "-w";
+    for (int i = 3; i < argc && validArgs; ++i) {
+        const std::string_view arg = argv[i];
+        if (arg == "--packed") {
+            packed = true;
+        } else {
+            files.emplace_back(arg);
+        }
+    }
+    if (!validArgs || files.empty()) {
+        std::cerr << "Usage: mygit hash-object -w [--packed] <file-path>...\n";
         return EXIT_FAILURE;
     }
 
-    const std::filesystem::path filePath = argv[3];
-    auto sha1BytesOpt = createBlobAndGetRawSha(filePath);
-
-    if (sha1BytesOpt) {
-        std::cout << bytesToHex(*sha1BytesOpt) << "\n"; // Convert to hex only for display
-        return EXIT_SUCCESS;
-    } else {
-        std::cerr << "Error: cannot create blob object from: " << filePath << '\n';
+    // With --packed, all the blobs go into one new pack instead of one loose file each.
+    // The ids are only printed once every object is stored, pack included.
+    std::optional<BulkCheckin> bulk;
+    std::vector<ObjectId> ids;
+    try {
+        if (packed) {
+            bulk.emplace();
+        }
+        for (const auto& filePath : files) {
+            auto sha1BytesOpt = createBlobAndGetRawSha(filePath);
+            if (!sha1BytesOpt) {
+                std::cerr << "Error: cannot create blob object from: " << filePath << '\n';
+                return EXIT_FAILURE;
+            }
+            ids.push_back(*sha1BytesOpt);
+        }
+        if (bulk) {
+            bulk->commit();
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << '\n';
         return EXIT_FAILURE;
     }
-}
\ No newline at end of file
+    for (const ObjectId& id : ids) {
+        std::cout << id.toHex() << "\n"; // Convert to hex only for display
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,81 @@
+#include "../include/index_pack.h"
+#include "../include/packfile_utils.h"
+#include "../include/pack_store.h"
+#include "../include/mapped_file.h"
+#include "../include/sha1_utils.h"
+#include "../include/size_utils.h"
+#include "../include/constants.h"
+
+#include <iostream>
+#include <string>
+#include <thread>
+#include <filesystem>
+
+int handleIndexPack(int argc, char* argv[]) {
+    // Default to one delta-resolution thread per core.
+    unsigned int numThreads = std::max(1u, std::thread::hardware_concurrency());
+    size_t deltaCacheSize = constants::DEFAULT_DELTA_CACHE_SIZE;
+    std::filesystem::path packPath;
+    bool validArgs = true;
+
+    for (int i = 2; i < argc && validArgs; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "-j" && i + 1 < argc) {
+            try {
+                numThreads = static_cast<unsigned int>(std::stoul(argv[++i]));
+            } catch (const std::exception&) {
+                numThreads = 0;
+            }
+            validArgs = numThreads > 0;
+        } else if (arg.starts_with("--delta-cache-size=")) {
+            auto size = parseByteSize(std::string_view(arg).substr(arg.find('=') + 1));
+            validArgs = size.has_value();
+            deltaCacheSize = size.value_or(0);
+        } else if (packPath.empty() && !arg.starts_with("-")) {
+            packPath = arg;
+        } else {
+            validArgs = false;
+        }
+    }
+
+    if (!validArgs || packPath.empty()) {
+        std::cerr << "Usage: mygit index-pack [-j <threads>] [--delta-cache-size=<n>[k|m|g]] <file.pack>\n";
+        return EXIT_FAILURE;
+    }
+    if (packPath.extension() != ".pack") {
+        std::cerr << "Fatal: packfile name '" << packPath.string() << "' does not end with '.pack'\n";
+        return EXIT_FAILURE;
+    }
+
+    auto packFile = MappedFile::open(packPath);
+    if (!packFile) {
+        std::cerr << "Fatal: cannot open packfile '" << packPath.string() << "'\n";
+        return EXIT_FAILURE;
+    }
+
+    // Parse every entry and resolve the delta chains to learn each object's SHA.
+    std::optional<std::vector<PackObjectInfo>> objectsOpt;
+    try {
+        PackfileParser parser(packFile->bytes(), numThreads, deltaCacheSize);
+        objectsOpt = parser.parseAndResolve();
+    } catch (const std::exception& e) {
+        std::cerr << "Fatal: " << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+    if (!objectsOpt) {
+        std::cerr << "Fatal: cannot index packfile '" << packPath.string() << "'\n";
+        return EXIT_FAILURE;
+    }
+
+    auto packChecksum = packFile->bytes().last(20);
+    auto idxPath = packPath;
+    idxPath.replace_extension(".idx");
+    if (!writePackIndex(idxPath, *objectsOpt, packChecksum)) {
+        std::cerr << "Fatal: cannot write index file '" << idxPath.string() << "'\n";
+        return EXIT_FAILURE;
+    }
+
+    // Like Git, print the pack's checksum, which is also the name of a stored pack.
+    std::cout << bytesToHex(packChecksum) << "\n";
+    return EXIT_SUCCESS;
+}
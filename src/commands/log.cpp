@@ -0,0 +1,92 @@
+#include "../include/log.h"
+#include "../include/commit_parser.h"
+#include "../include/object_utils.h"
+#include "../include/output_buffer.h"
+#include "../include/rev_walk.h"
+
+#include <cstdint>
+#include <ctime>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+namespace {
+    // Merge parents are shown abbreviated, like Git does in small repositories.
+    constexpr size_t ABBREV_SIZE = 7;
+
+    // Formats a signature's date as Git's default format does, in the signer's
+    // own time zone: "Thu Apr 7 15:13:13 2005 -0700".
+    std::string formatDate(const Signature& signature) {
+        const std::time_t local = static_cast<std::time_t>(signature.timestamp + signature.timezoneMinutes * 60);
+        std::tm tm{};
+        gmtime_r(&local, &tm);
+        char weekdayMonth[16];
+        char time[32];
+        std::strftime(weekdayMonth, sizeof(weekdayMonth), "%a %b", &tm);
+        std::strftime(time, sizeof(time), "%H:%M:%S %Y", &tm);
+        // The day of the month is not padded.
+        return std::string(weekdayMonth) + ' ' + std::to_string(tm.tm_mday) + ' ' + time + ' ' +
+               std::string(signature.timezone);
+    }
+
+    // Appends a blank line and the message indented by four spaces, without its
+    // leading and trailing blank lines. An empty message prints nothing.
+    void printMessage(std::string_view message, OutputBuffer& out) {
+        while (message.starts_with('\n')) {
+            message.remove_prefix(1);
+        }
+        while (message.ends_with('\n')) {
+            message.remove_suffix(1);
+        }
+        if (!message.empty()) {
+            out << '\n';
+        }
+        while (!message.empty()) {
+            const size_t end = message.find('\n');
+            out << "    " << message.substr(0, end) << '\n';
+            message = end == std::string_view::npos ? std::string_view{} : message.substr(end + 1);
+        }
+    }
+
+    void printCommit(const ObjectId& id, OutputBuffer& out) {
+        auto object = readGitObject(id);
+        auto parts = object ? splitObject(*object) : std::nullopt;
+        auto commit = parts && parts->first == "commit" ? parseCommit(parts->second) : std::nullopt;
+        if (!commit) {
+            throw std::runtime_error("could not read commit " + id.toHex());
+        }
+
+        out << "commit " << id.toHex() << '\n';
+        if (commit->parents.size() > 1) {
+            out << "Merge:";
+            for (const ObjectId& parent : commit->parents) {
+                out << ' ' << std::string_view(parent.toHex()).substr(0, ABBREV_SIZE);
+            }
+            out << '\n';
+        }
+        if (auto author = parseSignature(commit->author)) {
+            out << "Author: " << author->name << '\n';
+            out << "Date:   " << formatDate(*author) << '\n';
+        }
+        printMessage(commit->message, out);
+    }
+}
+
+int handleLog(int argc, char* argv[]) {
+    std::optional<RevWalkArgs> args = parseRevWalkArgs(argc, argv, 2);
+    if (!args) {
+        std::cerr << "Usage: mygit log [-n <count> | --max-count=<count>] [<commit>...] [-- <path>...]\n";
+        return EXIT_FAILURE;
+    }
+    if (args->revisions.empty()) {
+        args->revisions.emplace_back("HEAD");
+    }
+
+    // Only the commits shown are inflated.
+    return printRevWalk(std::move(*args), [](const ObjectId& id, uint64_t index, OutputBuffer& out) {
+        if (index > 0) {
+            out << '\n';
+        }
+        printCommit(id, out);
+    });
+}
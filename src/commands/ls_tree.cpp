@@ -1,62 +1,157 @@
 #include "../include/ls_tree.h"
 #include "../include/object_utils.h"
+#include "../include/output_buffer.h"
+#include "../include/refs.h"
 #include "../include/tree_parser.h"
-#include "../include/sha1_utils.h"
-#include "../include/constants.h"
 
 #include <iostream>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <optional>
-#include <algorithm> 
+#include <algorithm>
 #include <span>
+#include <stdexcept>
 
+namespace {
+    struct LsTreeOptions {
+        bool nameOnly = false;
+        bool recursive = false; // -r: descend into subtrees.
+        bool showTrees = false; // -t: list a subtree itself even when descending into it.
+        bool showSizes = false; // -l: print blob sizes.
+    };
+
+    /**
+     * @class TreeLister
+     * @brief Walks a tree depth-first and appends one line per entry to an output buffer.
+     *
+     * Subtrees are read through the process-wide object cache: a tree that
+     * appears in several places is inflated once. The current path is kept in a single
+     * string that grows and shrinks with the walk.
+     */
+    class TreeLister {
+    public:
+        TreeLister(const LsTreeOptions& options, OutputBuffer& out) : m_options(options), m_out(out) {}
+
+        // Lists one tree whose entries are named relative to m_path. Throws std::runtime_error on a bad tree.
+        void list(const ObjectId& treeId) {
+            auto tree = readTree(treeId);
+            auto parts = splitObject(*tree);
+            if (!parts || parts->first != "tree") {
+                throw std::runtime_error("not a tree object: " + treeId.toHex());
+            }
+
+            for (const auto& entry : TreeView(parts->second)) {
+                const size_t pathLength = m_path.size();
+                m_path.append(entry.name);
+
+                const bool descend = m_options.recursive && entry.isTree();
+                if (!descend || m_options.showTrees) {
+                    printEntry(entry);
+                }
+                if (descend) {
+                    m_path.push_back('/');
+                    list(entry.id());
+                }
+                m_path.resize(pathLength);
+            }
+        }
+
+    private:
+        static ObjectCache::Value readTree(const ObjectId& id) {
+            auto tree = readCachedGitObject(id);
+            if (!tree) {
+                throw std::runtime_error("could not read tree " + id.toHex());
+            }
+            return tree;
+        }
+
+        void printEntry(const TreeEntryView& entry) {
+            if (m_options.nameOnly) {
+                m_out << std::string_view(m_path) << '\n';
+                return;
+            }
+
+            std::string_view type = entry.isTree() ? "tree" : entry.type == TreeEntryType::Submodule ? "commit" : "blob";
+            char hex[ObjectId::HEX_SIZE];
+            const ObjectId id = entry.id();
+            id.toHex(hex);
+
+            // Modes are shown with 6 digits, so "40000" becomes "040000".
+            for (size_t i = entry.mode.size(); i < 6; ++i) {
+                m_out << '0';
+            }
+            m_out << entry.mode << ' ' << type << ' ' << std::string_view(hex, sizeof(hex));
+            if (m_options.showSizes) {
+                m_out << ' ';
+                if (type == "blob") {
+                    // Only the blob's header is read, never its content.
+                    auto info = readGitObjectInfo(id);
+                    if (!info) {
+                        throw std::runtime_error("could not read blob " + id.toHex());
+                    }
+                    m_out.appendNumber(info->size, 7);
+                } else {
+                    m_out << "      -";
+                }
+            }
+            m_out << '\t' << std::string_view(m_path) << '\n';
+        }
+
+        const LsTreeOptions& m_options;
+        OutputBuffer& m_out;
+        std::string m_path;
+    };
+}
 
 int handleLsTree(int argc, char* argv[]) {
-    bool nameOnly = false;
+    LsTreeOptions options;
     std::string treeSha;
 
-    if (argc == 4 && std::string(argv[2]) == "--name-only") {
-        nameOnly = true;
-        treeSha = argv[3];
-    } else if (argc == 3) {
-        treeSha = argv[2];
-    } else {
-        std::cerr << "Usage: mygit ls-tree [--name-only] <tree-sha>\n";
-        return EXIT_FAILURE;
+    bool validArgs = true;
+    for (int i = 2; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (arg == "--name-only") {
+            options.nameOnly = true;
+        } else if (arg.size() > 1 && arg[0] == '-' && arg[1] != '-') {
+            // Short flags may be combined, as in "-rt".
+            for (char flag : arg.substr(1)) {
+                if (flag == 'r') options.recursive = true;
+                else if (flag == 't') options.showTrees = true;
+                else if (flag == 'l') options.showSizes = true;
+                else validArgs = false;
+            }
+        } else if (treeSha.empty() && i == argc - 1) {
+            treeSha = arg;
+        } else {
+            validArgs = false;
+        }
     }
-
-    auto decompressedDataOpt = readGitObject(treeSha);
-    if (!decompressedDataOpt) {
-        std::cerr << "Fatal: Not a valid object name " << treeSha << '\n';
+    if (!validArgs || treeSha.empty()) {
+        std::cerr << "Usage: mygit ls-tree [-r] [-t] [-l] [--name-only] <tree-ish>\n";
         return EXIT_FAILURE;
     }
-
-    // Isolate the tree's content (after the "tree <size>\0" header).
-    const auto& decompressedDataVec = *decompressedDataOpt;
-    std::span<const std::byte> dataSpan(decompressedDataVec);
-    auto nullPosIt = findNullSeparator(dataSpan);
-    if (nullPosIt == dataSpan.end()) {
-        std::cerr << "Invalid tree object: missing header\n";
-        return EXIT_FAILURE;
+    // Without -r, subtrees are listed as entries anyway.
+    if (!options.recursive) {
+        options.showTrees = true;
     }
-    auto treeContent = dataSpan.subspan(std::distance(dataSpan.begin(), nullPosIt) + 1);
 
-    // Use a dedicated parser to extract entries from the binary tree format.
-    auto entriesOpt = parseTreeObject(treeContent);
-    if (!entriesOpt) {
-        std::cerr << "Failed to parse tree object\n";
+    auto treeId = resolveTreeish(treeSha);
+    if (!treeId) {
+        std::cerr << "Fatal: Not a valid object name " << treeSha << '\n';
         return EXIT_FAILURE;
     }
 
-    for (const auto& entry : *entriesOpt) {
-        if (nameOnly) {
-            std::cout << entry.filename << "\n";
-        } else {
-            const std::string type = (entry.mode == constants::MODE_TREE) ? "tree" : "blob";
-            std::cout <<  formatModeForDisplay(entry.mode)  << " " << type << " " << bytesToHex(entry.sha1Bytes) << "\t" << entry.filename << "\n";
-        }
+    // Lines go to a large buffer and reach stdout in blocks.
+    OutputBuffer out(std::cout);
+    try {
+        TreeLister(options, out).list(*treeId);
+    } catch (const std::runtime_error& e) {
+        out.flush();
+        std::cerr << "Fatal: " << e.what() << '\n';
+        return EXIT_FAILURE;
     }
-
-    return EXIT_SUCCESS;
-}
\ No newline at end of file
+    out.flush();
+    return out.good() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,21 @@
+#include "../include/rev_list.h"
+#include "../include/rev_walk.h"
+
+#include <cstdint>
+#include <iostream>
+#include <string_view>
+#include <utility>
+
+int handleRevList(int argc, char* argv[]) {
+    std::optional<RevWalkArgs> args = parseRevWalkArgs(argc, argv, 2);
+    if (!args || args->revisions.empty()) {
+        std::cerr << "Usage: mygit rev-list [-n <count> | --max-count=<count>] <commit>... [-- <path>...]\n";
+        return EXIT_FAILURE;
+    }
+
+    return printRevWalk(std::move(*args), [](const ObjectId& id, uint64_t, OutputBuffer& out) {
+        char hex[ObjectId::HEX_SIZE];
+        id.toHex(hex);
+        out << std::string_view(hex, sizeof(hex)) << '\n';
+    });
+}
@@ -0,0 +1,78 @@
+#include "../include/sparse_checkout.h"
+#include "../include/checkout_utils.h"
+#include "../include/constants.h"
+#include "../include/refs.h"
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace {
+    // Moves the working directory from one cone to another; nullptr stands for a full checkout.
+    bool switchCone(const SparseCone* oldCone, const SparseCone* newCone) {
+        // Before the first commit, there is nothing to check out yet.
+        const std::optional<ObjectId> headTree = resolveTreeish(constants::HEAD_FILE_NAME);
+        if (!headTree) {
+            return true;
+        }
+        const unsigned int numWorkers = std::max(1u, std::thread::hardware_concurrency());
+        return applySparseCone(*headTree, oldCone, newCone, ".", numWorkers);
+    }
+}
+
+int handleSparseCheckout(int argc, char* argv[]) {
+    const std::string_view subcommand = argc >= 3 ? argv[2] : "";
+    std::vector<std::string> directories(argv + std::min(argc, 3), argv + argc);
+    const bool takesDirectories = subcommand == "set" || subcommand == "add";
+    if (!takesDirectories && (!directories.empty() || (subcommand != "list" && subcommand != "disable"))) {
+        std::cerr << "Usage: mygit sparse-checkout (set | add) [<directory>...]\n"
+                  << "       mygit sparse-checkout (list | disable)\n";
+        return EXIT_FAILURE;
+    }
+
+    std::optional<SparseCone> current;
+    try {
+        current = SparseCone::load();
+    } catch (const std::runtime_error& e) {
+        std::cerr << "Fatal: " << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+
+    if (subcommand == "list") {
+        if (!current) {
+            std::cerr << "Fatal: this worktree is not sparse\n";
+            return EXIT_FAILURE;
+        }
+        for (const std::string& directory : current->directories()) {
+            std::cout << directory << '\n';
+        }
+        return EXIT_SUCCESS;
+    }
+
+    if (subcommand == "disable") {
+        if (!switchCone(current ? &*current : nullptr, nullptr)) {
+            return EXIT_FAILURE;
+        }
+        std::error_code ec;
+        std::filesystem::remove(constants::SPARSE_CHECKOUT_FILE, ec);
+        return EXIT_SUCCESS;
+    }
+
+    // "add" keeps the directories already in the cone.
+    if (subcommand == "add" && current) {
+        directories.insert(directories.end(), current->directories().begin(), current->directories().end());
+    }
+    const SparseCone cone(directories);
+    if (!switchCone(current ? &*current : nullptr, &cone)) {
+        return EXIT_FAILURE;
+    }
+    if (!cone.save()) {
+        std::cerr << "Fatal: could not write " << constants::SPARSE_CHECKOUT_FILE.string() << '\n';
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
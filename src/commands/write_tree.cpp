@@ -1,8 +1,11 @@
 #include "../include/write_tree.h"
 #include "../include/hash_object.h"
 #include "../include/object_utils.h"
+#include "../include/bulk_checkin.h"
 #include "../include/constants.h"
 #include "../include/sha1_utils.h"
+#include "../include/parallel_utils.h"
+#include "../include/stat_cache.h"
 
 #include <iostream>
 #include <vector>
@@ -10,74 +13,280 @@
 #include <algorithm>
 #include <iterator>
 #include <optional>
+#include <stdexcept>
+#include <chrono>
+#include <iomanip>
+#include <thread>
 
-std::optional<std::vector<std::byte>> writeTreeFromDirectory(const std::filesystem::path& dirPath) {
-    std::vector<TreeEntry> entries;
+namespace {
+    /** @struct DirectoryNode
+     *  @brief A directory waiting to become a tree object.
+     *
+     *  Its entries are already sorted in tree order; their SHAs are filled in
+     *  once the blobs and subtrees they point to have been written.
+     */
+    struct DirectoryNode {
+        std::string path;                               ///< Path from the root, '/'-separated; "" for the root.
+        size_t depth = 0;                               ///< Distance from the root directory.
+        std::vector<TreeEntry> entries;                 ///< The future tree entries, in order.
+        std::vector<FileStat> stats;                    ///< Stat data of each blob entry, by entry index.
+        std::vector<std::pair<size_t, size_t>> subdirs; ///< (entry index, node index) of each subdirectory.
+        ObjectId treeSha;                               ///< The tree's SHA, once written.
+        bool cached = false;                            ///< True if treeSha comes from the stat cache.
+    };
 
-    // To ensure a deterministic SHA-1 for the tree, directory entries must be sorted by filename.
-    std::vector<std::filesystem::directory_entry> files;
-    for (const auto& entry : std::filesystem::directory_iterator(dirPath)) {
-        files.push_back(entry);
-    }
-    std::sort(files.begin(), files.end(), [](const auto& a, const auto& b) {
-        return a.path().filename() < b.path().filename();
-    });
-
-    for (const auto& file : files) {
-        auto filename = file.path().filename().string();
-        if (filename == constants::GIT_DIR_NAME) {
-            continue; // The .git directory is never included in its own tree.
+    /** @struct PendingBlob
+     *  @brief A file whose blob goes into `nodes[node].entries[entry]`.
+     */
+    struct PendingBlob {
+        std::filesystem::path path;
+        size_t node;
+        size_t entry;
+    };
+
+    /**
+     * @brief Lists a directory and its subdirectories without reading any file.
+     *
+     * Files whose stat data matches the cache take their cached SHA; the
+     * others are queued in `blobs`. A directory whose entries all come from
+     * the cache, and which has as many entries as its cached tree, reuses
+     * that tree's SHA.
+     *
+     * @return The index of the directory's node in `nodes`.
+     */
+    size_t scanDirectory(const std::filesystem::path& dirPath, std::string relativePath, size_t depth,
+                         const StatCache* cache, std::vector<DirectoryNode>& nodes, std::vector<PendingBlob>& blobs) {
+        const size_t nodeIndex = nodes.size();
+        nodes.emplace_back().depth = depth;
+        nodes[nodeIndex].path = std::move(relativePath);
+        bool allCached = cache != nullptr;
+
+        // To ensure a deterministic SHA-1 for the tree, directory entries must be sorted by filename.
+        // Names are extracted once: comparing paths would rebuild them on every comparison.
+        std::vector<std::pair<std::string, std::filesystem::directory_entry>> files;
+        for (const auto& entry : std::filesystem::directory_iterator(dirPath)) {
+            files.emplace_back(entry.path().filename().string(), entry);
         }
+        std::sort(files.begin(), files.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
 
-        TreeEntry entry;
-        entry.filename = filename;
-
-        if (file.is_directory()) {
-            entry.mode = constants::MODE_TREE;
-            // Recurse to create the subtree object.
-            auto sha1BytesOpt = writeTreeFromDirectory(file.path());
-            if (!sha1BytesOpt) return std::nullopt;
-            entry.sha1Bytes = *sha1BytesOpt;
-        } else if (file.is_regular_file()) {
-            entry.mode = constants::MODE_BLOB;
-            // Create a blob object for the file's content.
-            auto sha1BytesOpt = createBlobAndGetRawSha(file.path()); 
-            if (!sha1BytesOpt) return std::nullopt;
-            entry.sha1Bytes = *sha1BytesOpt;
-        } else {
-            continue;  // Skip symlinks, etc. for this implementation.
+        for (const auto& [filename, file] : files) {
+            if (filename == constants::GIT_DIR_NAME) {
+                continue; // The .git directory is never included in its own tree.
+            }
+
+            // `nodes` grows while recursing, so it is indexed again every time.
+            const size_t entryIndex = nodes[nodeIndex].entries.size();
+            std::string entryPath = nodes[nodeIndex].path.empty() ? filename : nodes[nodeIndex].path + '/' + filename;
+            if (file.is_directory()) {
+                nodes[nodeIndex].entries.push_back({std::string(constants::MODE_TREE), filename, {}});
+                nodes[nodeIndex].stats.emplace_back();
+                size_t child = scanDirectory(file.path(), std::move(entryPath), depth + 1, cache, nodes, blobs);
+                nodes[nodeIndex].subdirs.emplace_back(entryIndex, child);
+                allCached = allCached && nodes[child].cached;
+            } else if (file.is_regular_file()) {
+                auto stat = statFile(file.path());
+                if (!stat) {
+                    throw std::runtime_error("cannot stat " + file.path().string());
+                }
+                auto cachedSha = cache ? cache->findBlob(entryPath, *stat) : std::nullopt;
+                if (!cachedSha) {
+                    blobs.push_back({file.path(), nodeIndex, entryIndex});
+                    allCached = false;
+                }
+                nodes[nodeIndex].entries.push_back({std::string(constants::MODE_BLOB), filename, cachedSha.value_or(ObjectId{})});
+                nodes[nodeIndex].stats.push_back(*stat);
+            }
+            // Symlinks, etc. are skipped in this implementation.
         }
-        entries.push_back(entry);
+
+        DirectoryNode& node = nodes[nodeIndex];
+        if (allCached) {
+            auto cachedTree = cache->findTree(node.path);
+            if (cachedTree && cachedTree->entryCount == node.entries.size()) {
+                node.treeSha = cachedTree->sha;
+                node.cached = true;
+            }
+        }
+        return nodeIndex;
     }
 
-    // Construct the binary content of the tree object from its entries.
-    // Format for each entry: "<mode> <filename>\0<sha1_bytes>"
-    std::vector<std::byte> treeContent;
-    for (const auto& entry : entries) {
-        std::string entryStr = entry.mode + " " + entry.filename + '\0';
-        std::transform(entryStr.begin(), entryStr.end(), std::back_inserter(treeContent), 
+    // Serializes tree entries and writes the tree object, returning its SHA.
+    std::optional<ObjectId> writeTreeObject(const std::vector<TreeEntry>& entries) {
+        // Construct the binary content of the tree object from its entries.
+        // Format for each entry: "<mode> <filename>\0<sha1_bytes>"
+        std::vector<std::byte> treeContent;
+        auto append = [&](std::string_view text) {
+            auto bytes = std::as_bytes(std::span{text});
+            treeContent.insert(treeContent.end(), bytes.begin(), bytes.end());
+        };
+        for (const auto& entry : entries) {
+            append(entry.mode);
+            append(" ");
+            append(entry.filename);
+            treeContent.push_back(std::byte{0});
+            treeContent.insert(treeContent.end(), entry.sha1.bytes.begin(), entry.sha1.bytes.end());
+        }
+
+        // Prepend the Git object header ("tree <size>\0") and write to the object store
+        std::string header = "tree " + std::to_string(treeContent.size()) + '\0';
+        std::vector<std::byte> fullTreeObject;
+        std::transform(header.begin(), header.end(), std::back_inserter(fullTreeObject),
                        [](char c){ return std::byte(c); });
-        treeContent.insert(treeContent.end(), entry.sha1Bytes.begin(), entry.sha1Bytes.end());
+        fullTreeObject.insert(fullTreeObject.end(), treeContent.begin(), treeContent.end());
+        
+        return writeGitObject(fullTreeObject);
+    }
+}
+
+std::optional<ObjectId> writeTreeFromDirectory(const std::filesystem::path& dirPath,
+                                                             const WriteTreeOptions& options, WriteTreeStats* stats) {
+    std::vector<DirectoryNode> nodes;
+    std::vector<PendingBlob> blobs;
+
+    try {
+        // 1. Walk the directory tree on this thread. Listing directories is
+        // cheap next to hashing and compressing file contents.
+        scanDirectory(dirPath, "", 0, options.cache, nodes, blobs);
+
+        // 2. Hash and compress every file that changed. Each worker fills in
+        // a distinct entry, and the vectors no longer change size.
+        parallelFor(blobs.size(), options.numThreads, [&](size_t i) {
+            const PendingBlob& blob = blobs[i];
+            auto blobShaOpt = createBlobAndGetRawSha(blob.path);
+            if (!blobShaOpt) {
+                throw std::runtime_error("cannot create blob object from " + blob.path.string());
+            }
+            nodes[blob.node].entries[blob.entry].sha1 = *blobShaOpt;
+        });
+
+        // 3. Write the trees from the deepest level up. A tree is only built
+        // once every subtree below it has its SHA, and the trees of one level
+        // are independent of each other.
+        size_t maxDepth = 0;
+        for (const auto& node : nodes) maxDepth = std::max(maxDepth, node.depth);
+        std::vector<std::vector<size_t>> levels(maxDepth + 1);
+        for (size_t i = 0; i < nodes.size(); ++i) levels[nodes[i].depth].push_back(i);
+
+        for (size_t depth = levels.size(); depth-- > 0;) {
+            const auto& level = levels[depth];
+            parallelFor(level.size(), options.numThreads, [&](size_t i) {
+                DirectoryNode& node = nodes[level[i]];
+                if (node.cached) {
+                    return; // Nothing below this directory changed.
+                }
+                for (const auto& [entryIndex, child] : node.subdirs) {
+                    node.entries[entryIndex].sha1 = nodes[child].treeSha;
+                }
+                auto treeShaOpt = writeTreeObject(node.entries);
+                if (!treeShaOpt) {
+                    throw std::runtime_error("cannot write tree object");
+                }
+                node.treeSha = *treeShaOpt;
+            });
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << '\n';
+        return std::nullopt;
     }
 
-     // Prepend the Git object header ("tree <size>\0") and write to the object store
-    std::string header = "tree " + std::to_string(treeContent.size()) + '\0';
-    std::vector<std::byte> fullTreeObject;
-    std::transform(header.begin(), header.end(), std::back_inserter(fullTreeObject),
-                   [](char c){ return std::byte(c); });
-    fullTreeObject.insert(fullTreeObject.end(), treeContent.begin(), treeContent.end());
-    
-    return writeGitObject(fullTreeObject);
+    if (options.cacheWriter) {
+        for (const auto& node : nodes) {
+            options.cacheWriter->addTree(node.path, static_cast<uint32_t>(node.entries.size()), node.treeSha);
+            for (size_t i = 0; i < node.entries.size(); ++i) {
+                const TreeEntry& entry = node.entries[i];
+                if (entry.mode == constants::MODE_BLOB) {
+                    options.cacheWriter->addBlob(node.path.empty() ? entry.filename : node.path + '/' + entry.filename,
+                                                 node.stats[i], entry.sha1);
+                }
+            }
+        }
+    }
+    if (stats) {
+        *stats = {};
+        for (const auto& node : nodes) {
+            stats->files += node.entries.size() - node.subdirs.size();
+            stats->writtenTrees += node.cached ? 0 : 1;
+        }
+        stats->hashedFiles = blobs.size();
+    }
+    return nodes.front().treeSha;
 }
 
-// Command handler for `mygit write-tree`.
+// Command handler for `mygit write-tree [-j <threads>] [-v] [--packed]`.
 int handleWriteTree(int argc, char* argv[]) {
-    // The command operates on the current working directory.
-    auto sha1BytesOpt = writeTreeFromDirectory(".");
+    // Default to one hashing thread per core.
+    unsigned int numThreads = std::max(1u, std::thread::hardware_concurrency());
+    bool verbose = false;
+    bool packed = false;
+    bool validArgs = true;
+
+    for (int i = 2; i < argc && validArgs; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "-j" && i + 1 < argc) {
+            try {
+                numThreads = static_cast<unsigned int>(std::stoul(argv[++i]));
+            } catch (const std::exception&) {
+                numThreads = 0;
+            }
+            validArgs = numThreads > 0;
+        } else if (arg == "-v") {
+            verbose = true;
+        } else if (arg == "--packed") {
+            packed = true;
+        } else {
+            validArgs = false;
+        }
+    }
+    if (!validArgs) {
+        std::cerr << "Usage: mygit write-tree [-j <threads>] [-v] [--packed]\n";
+        return EXIT_FAILURE;
+    }
+
+    // The command operates on the current working directory. The stat cache
+    // left by the previous run lets unchanged files and directories be skipped.
+    WriteTreeStats stats;
+    auto start = std::chrono::steady_clock::now();
+    StatCache cache = StatCache::load(constants::STAT_CACHE_FILE);
+    StatCacheWriter newCache;
+    std::optional<ObjectId> sha1BytesOpt;
+    size_t packedObjects = 0;
+    try {
+        // With --packed, every new object goes into one pack, stored once all are written.
+        std::optional<BulkCheckin> bulk;
+        if (packed) {
+            bulk.emplace();
+        }
+        sha1BytesOpt = writeTreeFromDirectory(".", {numThreads, &cache, &newCache}, &stats);
+        if (sha1BytesOpt && bulk) {
+            packedObjects = bulk->commit();
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << '\n';
+        sha1BytesOpt.reset();
+    }
+    // The cache is rewritten whenever a tree was written or a file had to be
+    // hashed, racy files included: otherwise the next run would hash it again.
+    const bool cacheChanged = stats.writtenTrees > 0 || stats.hashedFiles > 0;
+    if (sha1BytesOpt && cacheChanged && !newCache.write(constants::STAT_CACHE_FILE)) {
+        std::cerr << "Warning: cannot write " << constants::STAT_CACHE_FILE.string() << "\n";
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
     if (sha1BytesOpt) {
-        std::cout << bytesToHex(*sha1BytesOpt) << "\n";
+        // Throughput goes to stderr so that stdout only carries the tree SHA.
+        if (verbose) {
+            std::cerr << std::fixed << std::setprecision(2) << "Hashed " << stats.hashedFiles << " of "
+                      << stats.files << " files and wrote " << stats.writtenTrees << " trees in "
+                      << elapsed.count() << " s ("
+                      << std::setprecision(0) << stats.files / std::max(elapsed.count(), 1e-9)
+                      << " files/s) with " << numThreads << " thread(s).\n";
+            if (packed) {
+                std::cerr << "Stored " << packedObjects << " new objects in one pack.\n";
+            }
+        }
+        std::cout << sha1BytesOpt->toHex() << "\n";
         return EXIT_SUCCESS;
     }
     std::cerr << "Failed to write tree object.\n";
     return EXIT_FAILURE;
-}
\ No newline at end of file
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/** @struct BloomSettings
+ *  @brief The parameters of changed-path Bloom filters, as Git sets them by default.
+ */
+struct BloomSettings {
+    uint32_t hashVersion = 1;       ///< The murmur3 variant; 1 is the one Git writes.
+    uint32_t numHashes = 7;         ///< Bits set per path.
+    uint32_t bitsPerEntry = 10;     ///< Filter size per path.
+    uint32_t maxChangedPaths = 512; ///< Commits changing more paths get a filter that matches everything.
+};
+
+/**
+ * @brief Hashes data with 32-bit murmur3, as Git's version 1 filters do.
+ *
+ * Git's version 1 reads the bytes as signed chars, so bytes above 0x7F are
+ * sign-extended before mixing. This copies that quirk so the filters Git
+ * wrote, and the ones written here, agree on every path.
+ */
+uint32_t murmur3SeededV1(uint32_t seed, std::string_view data);
+
+/** @class BloomKey
+ *  @brief The bit positions of one path, computed once and tested against many filters.
+ */
+class BloomKey {
+public:
+    BloomKey(std::string_view path, const BloomSettings& settings);
+
+    /// @brief Sets the path's bits in a filter.
+    void addTo(std::span<std::byte> filter) const;
+
+    /// @brief Returns false if the filter proves the path is absent; true if it may be present.
+    bool mayBeIn(std::span<const std::byte> filter) const;
+
+private:
+    std::vector<uint32_t> m_hashes;
+};
+
+/**
+ * @brief Builds the changed-path filter of one commit.
+ *
+ * Every path and each of its leading directories is added once, so a query
+ * for "src" matches a commit that only changed "src/main.cpp". A commit that
+ * changed no path gets a one-byte empty filter; one that changed more than
+ * settings.maxChangedPaths paths gets a one-byte filter with every bit set.
+ *
+ * @param paths The paths of the files the commit changed, relative to the root.
+ *              A caller may stop collecting once it has more than settings.maxChangedPaths.
+ */
+std::vector<std::byte> buildChangedPathFilter(const std::vector<std::string>& paths, const BloomSettings& settings);
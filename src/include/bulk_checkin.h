@@ -0,0 +1,106 @@
+#pragma once
+
+#include "object_id.h"
+#include "packfile_utils.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+/**
+ * @class BulkCheckin
+ * @brief Collects the objects written by one command into a single new packfile.
+ *
+ * While a BulkCheckin is alive, writeGitObject() appends every new object to
+ * a temporary pack in `.git/objects/pack` instead of creating a loose file
+ * for it: no stat, no directory creation and no new inode per object.
+ * commit() then fixes up the pack header, writes the index, and renames both
+ * into place, the index last, so readers see either the whole pack or none
+ * of it. A BulkCheckin destroyed without commit() removes its temporary pack.
+ *
+ * Objects are compressed by the calling thread and only appended under a
+ * lock, so parallel writers such as write-tree's workers keep compressing in
+ * parallel. An object already in a pack, or already added, is skipped. The
+ * added objects are not readable before commit() returns.
+ */
+class BulkCheckin {
+public:
+    /// @brief Returns the next bytes of an object's content into `buffer`, or 0 at the end.
+    using ContentSource = std::function<size_t(std::span<std::byte> buffer)>;
+
+    /**
+     * @brief Starts a temporary pack and makes it the target of writeGitObject().
+     * @throws std::runtime_error if the pack cannot be created.
+     * @throws std::logic_error if another BulkCheckin is already active.
+     */
+    BulkCheckin();
+    ~BulkCheckin();
+    BulkCheckin(const BulkCheckin&) = delete;
+    BulkCheckin& operator=(const BulkCheckin&) = delete;
+
+    /// @brief Returns the active BulkCheckin, or nullptr when objects are written loose.
+    static BulkCheckin* active();
+
+    /**
+     * @brief Adds a full object ("<type> <size>\0<content>") to the pack. Thread-safe.
+     * @return The SHA-1 of the object.
+     * @throws std::runtime_error if the object is malformed or cannot be written.
+     */
+    ObjectId add(std::span<const std::byte> object);
+
+    /**
+     * @brief Adds an object whose content arrives in pieces, with bounded memory. Thread-safe.
+     *
+     * The content is compressed straight into the pack, so other writers wait
+     * until it is complete. If the object turns out to be known already, its
+     * entry is cut off again.
+     *
+     * @param type The object type, e.g. "blob".
+     * @param size The exact number of content bytes `source` will return.
+     * @param source Called until it returns 0.
+     * @return The SHA-1 of the object.
+     * @throws std::runtime_error if the content size does not match or the pack cannot be written.
+     */
+    ObjectId addStreamed(std::string_view type, uint64_t size, const ContentSource& source);
+
+    /**
+     * @brief Finishes the pack, writes its index and moves both into `.git/objects/pack`.
+     *
+     * Nothing is stored if no object was added. Afterwards the pack is
+     * visible to readGitObject() and this BulkCheckin is no longer active.
+     *
+     * @return The number of objects stored.
+     * @throws std::runtime_error if the pack or its index cannot be written.
+     */
+    size_t commit();
+
+private:
+    // Returns true if the object is already stored or added. Requires m_mutex.
+    bool knownLocked(const ObjectId& id) const;
+
+    // Buffers bytes at the end of the pack, writing them out in large blocks. Requires m_mutex.
+    void appendLocked(std::span<const std::byte> data);
+    void flushLocked();
+
+    // Drops everything after `offset`, e.g. a duplicate streamed entry. Requires m_mutex.
+    void truncateLocked(uint64_t offset);
+
+    std::filesystem::path m_tmpPath;
+    int m_fd = -1;
+    bool m_committed = false;
+
+    std::mutex m_mutex;
+    uint64_t m_offset = 0;           // Logical end of the pack, buffered bytes included.
+    uint64_t m_flushed = 0;          // Bytes already written to the file.
+    std::vector<std::byte> m_buffer; // Bytes after m_flushed.
+    std::vector<PackObjectInfo> m_objects;
+    std::unordered_set<ObjectId> m_ids;
+};
@@ -5,5 +5,7 @@
  * 
  * Implements `git cat-file -p <object-sha>`, reading a Git object
  * from the database, and printing its content to standard output.
+ * `-t` and `-s` print the object's type or size, read from its header only.
+ * `--batch` and `--batch-check` answer object names read from stdin.
  */
 int handleCatFile(int argc, char* argv[]);
\ No newline at end of file
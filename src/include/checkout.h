@@ -0,0 +1,12 @@
+#pragma once
+
+/**
+ * @brief Handles the 'checkout' command.
+ *
+ * Implements `git checkout [-f] [-j <threads>] <commit>`: moves the working
+ * directory from the tree of HEAD to the tree of `<commit>` and points HEAD
+ * at it. Only the paths that differ between the two trees are touched (see
+ * checkoutTreeChanges()). A branch name leaves HEAD on that branch; any
+ * other revision detaches it.
+ */
+int handleCheckout(int argc, char* argv[]);
@@ -1,18 +1,77 @@
 #pragma once
 
-#include <string>
+#include "object_id.h"
+
 #include <filesystem>
+#include <optional>
+
+class SparseCone;
 
 /**
  * @brief Restores the files from a specific commit to the working directory.
  * 
  * This function is the entry point for the checkout process. It reads the
- * specified commit, finds its root tree, and then recursively writes all
- * associated files and directories to the target path.
+ * specified commit and walks its trees once to create every directory and
+ * list the files. The blobs are then read and written by a pool of workers;
+ * the resulting files are the same whatever the number of workers.
  *
- * @param commitSha The 40-character hex SHA of the commit to check out.
+ * With a sparse cone, only the files in the cone are written, and the
+ * trees of the directories outside it are not read.
+ *
+ * @param commitId The SHA of the commit to check out.
  * @param targetDir The root directory where files will be written.
+ * @param numWorkers The number of threads that write files. 1 checks out serially.
+ * @param cone The sparse cone, or nullptr to check out every file.
  * @return True on success, false on failure.
  */
-bool checkoutCommit(const std::string& commitSha, const std::filesystem::path& targetDir);
+bool checkoutCommit(const ObjectId& commitId, const std::filesystem::path& targetDir, unsigned int numWorkers = 1,
+                    const SparseCone* cone = nullptr);
+
+/**
+ * @brief Moves a working directory from one tree to another, touching only the paths that differ.
+ *
+ * The trees are compared with diffTrees(), so a subtree with the same SHA
+ * on both sides is never read, whatever its size. Deleted files and files
+ * that change type are removed first, along with the directories they
+ * leave empty; then new and modified files are written by a pool of
+ * workers. Everything else in the directory, untracked files included, is
+ * left alone.
+ *
+ * Unless `force` is set, nothing is touched if a file to be overwritten or
+ * removed no longer matches `fromTree`, or if an untracked file is in the
+ * way of a new one. Only those files are read to check this.
+ *
+ * With a sparse cone, changes outside it are ignored and the subtrees
+ * outside it are not read.
+ *
+ * @param fromTree The tree the directory holds now, or std::nullopt if it holds none.
+ * @param toTree The tree to check out.
+ * @param targetDir The root directory of the working tree.
+ * @param numWorkers The number of threads that write files.
+ * @param force Overwrite local changes and untracked files instead of refusing.
+ * @param cone The sparse cone, or nullptr if every file is checked out.
+ * @return True on success; false after printing why.
+ */
+bool checkoutTreeChanges(const std::optional<ObjectId>& fromTree, const ObjectId& toTree,
+                         const std::filesystem::path& targetDir, unsigned int numWorkers = 1, bool force = false,
+                         const SparseCone* cone = nullptr);
 
+/**
+ * @brief Brings a checked-out tree from one sparse cone to another.
+ *
+ * Files that enter the cone are written and files that leave it are
+ * removed, along with the directories they leave empty. Only the
+ * directories in one of the two cones are read. A file that leaves the
+ * cone with local changes is kept, with a warning; an untracked file in the
+ * way of one that enters it stops everything before any change, as in
+ * checkoutTreeChanges().
+ *
+ * @param tree The tree checked out, e.g. HEAD's.
+ * @param oldCone The current cone, or nullptr if every file is checked out.
+ * @param newCone The cone to apply, or nullptr to check out every file.
+ * @param targetDir The root directory of the working tree.
+ * @param numWorkers The number of threads that write files.
+ * @return True on success; false after printing why.
+ */
+bool applySparseCone(const ObjectId& tree, const SparseCone* oldCone, const SparseCone* newCone,
+                     const std::filesystem::path& targetDir, unsigned int numWorkers = 1);
@@ -0,0 +1,127 @@
+#pragma once
+
+#include "bloom_filter.h"
+#include "constants.h"
+#include "mapped_file.h"
+#include "object_id.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <vector>
+
+/**
+ * @brief Handles the 'commit-graph' command.
+ *
+ * Implements `git commit-graph write [--changed-paths]`, which writes the
+ * commit-graph file for every commit reachable from HEAD and the refs.
+ */
+int handleCommitGraph(int argc, char* argv[]);
+
+/**
+ * @class CommitGraph
+ * @brief A read-only view of a commit-graph file (`.git/objects/info/commit-graph`).
+ *
+ * The file uses Git's version 1 format: a table of chunks holding every
+ * commit's SHA sorted under a 256-entry fanout (OIDF, OIDL), then one
+ * fixed-size record per commit (CDAT) with its root tree, the positions of
+ * its parents, its generation number and its commit date. Commits with more
+ * than two parents keep the rest in an extra edge list (EDGE). Optionally,
+ * a changed-path Bloom filter per commit (BIDX, BDAT) tells which paths the
+ * commit may have changed relative to its first parent.
+ *
+ * A history walk that only needs parents and dates reads them straight from
+ * the mapping, without inflating a single commit object. Commits are named
+ * by their position in the sorted SHA table.
+ */
+class CommitGraph {
+public:
+    /// Generation numbers are stored in 30 bits and capped at this value.
+    static constexpr uint32_t GENERATION_MAX = 0x3FFFFFFF;
+
+    /**
+     * @brief Maps and validates a commit-graph file.
+     * @return The graph, or std::nullopt if the file is missing or malformed.
+     */
+    static std::optional<CommitGraph> open(const std::filesystem::path& path = constants::COMMIT_GRAPH_FILE);
+
+    /// @brief Returns the number of commits in the graph.
+    uint32_t size() const { return m_count; }
+
+    /// @brief Returns the position of a commit, or std::nullopt if the graph does not have it.
+    std::optional<uint32_t> find(const ObjectId& id) const;
+
+    /// @brief Returns the SHA of the commit at `pos`.
+    ObjectId id(uint32_t pos) const;
+
+    /// @brief Returns the root tree of the commit at `pos`.
+    ObjectId tree(uint32_t pos) const;
+
+    /// @brief Returns the generation number of the commit at `pos`: 1 for a root, else one more than its highest parent.
+    uint32_t generation(uint32_t pos) const;
+
+    /// @brief Returns the committer timestamp of the commit at `pos`.
+    uint64_t commitTime(uint32_t pos) const;
+
+    /**
+     * @brief Appends the positions of a commit's parents, in order, to `out`.
+     * @return False if the record points outside the graph.
+     */
+    bool parents(uint32_t pos, std::vector<uint32_t>& out) const;
+
+    /// @brief Returns true if the graph holds changed-path Bloom filters.
+    bool hasBloomFilters() const { return m_bloomIndex != nullptr; }
+
+    /// @brief Returns the parameters the Bloom filters were built with.
+    const BloomSettings& bloomSettings() const { return m_bloomSettings; }
+
+    /**
+     * @brief Returns the changed-path filter of the commit at `pos`.
+     * @return The filter's bytes, or an empty span if there is none, which matches every path.
+     */
+    std::span<const std::byte> bloomFilter(uint32_t pos) const;
+
+private:
+    explicit CommitGraph(MappedFile file) : m_file(std::move(file)) {}
+
+    const std::byte* record(uint32_t pos) const;
+
+    MappedFile m_file;
+    uint32_t m_count = 0;
+    const std::byte* m_fanout = nullptr;
+    const std::byte* m_ids = nullptr;
+    const std::byte* m_data = nullptr;
+    const std::byte* m_edges = nullptr;
+    size_t m_edgeCount = 0;
+    const std::byte* m_bloomIndex = nullptr;
+    std::span<const std::byte> m_bloomData;
+    BloomSettings m_bloomSettings;
+};
+
+/** @struct CommitGraphWriteOptions
+ *  @brief Tunes a call to writeCommitGraph().
+ */
+struct CommitGraphWriteOptions {
+    /// Also write a changed-path Bloom filter per commit, from a diff against its first parent.
+    bool changedPaths = false;
+};
+
+/**
+ * @brief Writes a commit-graph file covering every commit reachable from `tips`.
+ *
+ * Commit objects are read and parsed once, generation numbers are computed
+ * over the whole set, and the file is written under a temporary name and
+ * renamed into place, so readers see either the old graph or the new one.
+ * Tips that are annotated tags are peeled to their commit; other non-commit
+ * tips are ignored.
+ *
+ * @param tips The starting points, e.g. every ref and HEAD.
+ * @param options Whether to add changed-path Bloom filters.
+ * @param path Where to write the graph.
+ * @return The number of commits written.
+ * @throws std::runtime_error if a reachable commit or tree cannot be read or the file cannot be written.
+ */
+size_t writeCommitGraph(const std::vector<ObjectId>& tips, const CommitGraphWriteOptions& options = {},
+                        const std::filesystem::path& path = constants::COMMIT_GRAPH_FILE);
@@ -0,0 +1,47 @@
+#pragma once
+#include "object_id.h"
+
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+/** @struct CommitView
+ *  @brief The fields of a commit object, pointing into the commit's inflated content.
+ *
+ *  Nothing but the parent list is copied: the views stay valid as long as the
+ *  commit's buffer does.
+ */
+struct CommitView {
+    ObjectId tree;                 ///< The commit's root tree.
+    std::vector<ObjectId> parents; ///< Its parents, in order; empty for a root commit.
+    std::string_view author;       ///< "Name <email> <timestamp> <tz>", as stored.
+    std::string_view committer;    ///< "Name <email> <timestamp> <tz>", as stored.
+    uint64_t commitTime = 0;       ///< The committer timestamp, in seconds since the epoch.
+    std::string_view message;      ///< Everything after the blank line that ends the headers.
+};
+
+/**
+ * @brief Parses the payload of a commit object.
+ *
+ * Reads the "tree", "parent", "author" and "committer" headers and finds the
+ * message; other headers, such as "gpgsig", are skipped.
+ *
+ * @param content The commit's payload, after its "commit <size>\0" header.
+ * @return The commit's fields, or std::nullopt if its tree line is missing or malformed.
+ */
+std::optional<CommitView> parseCommit(std::span<const std::byte> content);
+
+/** @struct Signature
+ *  @brief An author or committer line, split into its parts.
+ */
+struct Signature {
+    std::string_view name;     ///< "Name <email>", as stored.
+    int64_t timestamp = 0;     ///< Seconds since the epoch.
+    int timezoneMinutes = 0;   ///< Offset from UTC, e.g. 120 for "+0200".
+    std::string_view timezone; ///< The offset as stored, e.g. "+0200".
+};
+
+/// @brief Splits "Name <email> <timestamp> <tz>". Returns std::nullopt if the line is malformed.
+std::optional<Signature> parseSignature(std::string_view line);
@@ -23,6 +23,12 @@ namespace constants {
     constexpr std::string_view MODE_BLOB = "100644"; // Regular file
     constexpr std::string_view MODE_TREE = "40000"; // Directory
 
+    // Default memory budget for delta bases kept while resolving packfile deltas.
+    constexpr size_t DEFAULT_DELTA_CACHE_SIZE = 256 * 1024 * 1024;
+
+    // Default memory budget of the process-wide cache of inflated objects (see objectCache()).
+    constexpr size_t DEFAULT_OBJECT_CACHE_SIZE = 64 * 1024 * 1024;
+
     // Default author information for commits
     // In a full Git implementation, this would be read from .git/config.
     constexpr std::string_view AUTHOR_NAME = "Mathis-L";
@@ -31,4 +37,8 @@ namespace constants {
     // Filesystem paths, initialized at runtime
     const std::filesystem::path GIT_DIR = ".git";
     const std::filesystem::path OBJECTS_DIR = GIT_DIR / "objects";
+    const std::filesystem::path PACK_DIR = OBJECTS_DIR / "pack";
+    const std::filesystem::path COMMIT_GRAPH_FILE = OBJECTS_DIR / "info" / "commit-graph";
+    const std::filesystem::path STAT_CACHE_FILE = GIT_DIR / "stat-cache";
+    const std::filesystem::path SPARSE_CHECKOUT_FILE = GIT_DIR / "info" / "sparse-checkout";
 }
\ No newline at end of file
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "packfile_utils.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+/**
+ * @class DeltaBaseCache
+ * @brief A thread-safe LRU cache of resolved pack objects, bounded by total bytes.
+ *
+ * Resolving a delta needs the full content of its base, which may itself be
+ * the product of a long chain. This cache keeps recently used bases so that
+ * siblings and repeated reads do not rebuild the chain, while capping memory
+ * at a fixed budget. Entries are keyed by the pack they come from and their
+ * offset in it, so an evicted entry can always be rebuilt from the pack.
+ *
+ * Values are shared pointers: a caller keeps the data alive while it uses it
+ * even if the cache evicts the entry in the meantime.
+ */
+class DeltaBaseCache {
+public:
+    using Value = std::shared_ptr<const PackedObject>;
+
+    /// @param max_bytes The budget for the content of all cached objects.
+    explicit DeltaBaseCache(size_t max_bytes);
+
+    /// @brief Returns the cached object, marking it as recently used, or nullptr on a miss.
+    Value get(const void* pack, uint64_t offset);
+
+    /**
+     * @brief Caches an object, evicting the least recently used ones to stay within budget.
+     * Objects larger than the whole budget are not cached.
+     */
+    void put(const void* pack, uint64_t offset, Value object);
+
+    /// @brief Drops an entry that will not be needed again.
+    void erase(const void* pack, uint64_t offset);
+
+    /// @brief Returns the number of content bytes currently cached.
+    size_t bytesUsed() const;
+
+private:
+    struct Key {
+        const void* pack;
+        uint64_t offset;
+        bool operator==(const Key&) const = default;
+    };
+    struct KeyHash {
+        size_t operator()(const Key& key) const {
+            return std::hash<const void*>{}(key.pack) ^ (std::hash<uint64_t>{}(key.offset) * 0x9e3779b97f4a7c15ULL);
+        }
+    };
+    using LruList = std::list<std::pair<Key, Value>>; // Most recently used first.
+
+    void evictLocked(LruList::iterator it);
+
+    mutable std::mutex m_mutex;
+    size_t m_max_bytes;
+    size_t m_bytes_used = 0;
+    LruList m_lru;
+    std::unordered_map<Key, LruList::iterator, KeyHash> m_index;
+};
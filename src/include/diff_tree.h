@@ -0,0 +1,12 @@
+#pragma once
+
+/**
+ * @brief Handles the 'diff-tree' command.
+ *
+ * Implements `git diff-tree [-r] [-t] [--name-only | --name-status] <tree-ish> <tree-ish>`,
+ * listing the entries that differ between two trees (or the root trees of
+ * two commits) in Git's raw format. Without `-r`, a changed subtree is one
+ * entry; `-r` lists the files inside it and `-t` also keeps the subtree.
+ * Subtrees with the same SHA on both sides are never read (see diffTrees()).
+ */
+int handleDiffTree(int argc, char* argv[]);
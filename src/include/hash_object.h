@@ -1,5 +1,7 @@
 #pragma once
 #include <string>
+#include "object_id.h"
+
 #include <vector>
 #include <optional>
 #include <filesystem>
@@ -7,8 +9,9 @@
 /**
  * @brief Handles the 'hash-object' command.
  * 
- * Implements the functionality of `git hash-object -w <file>`, creating a blob
- * object from a file and writing it to the object database.
+ * Implements the functionality of `git hash-object -w <file>...`, creating a
+ * blob object from each file and writing it to the object database. With
+ * `--packed`, the blobs are written into one new pack (see BulkCheckin).
  */
 int handleHashObject(int argc, char* argv[]);
 
@@ -18,6 +21,6 @@ int handleHashObject(int argc, char* argv[]);
  * This is a core utility used by other commands like `write-tree`.
  * 
  * @param filePath Path to the file to be hashed.
- * @return The 20-byte raw SHA-1 hash of the created object, or std::nullopt on failure.
+ * @return The SHA-1 of the created object, or std::nullopt on failure.
  */
-std::optional<std::vector<std::byte>> createBlobAndGetRawSha(const std::filesystem::path& filePath);
+std::optional<ObjectId> createBlobAndGetRawSha(const std::filesystem::path& filePath);
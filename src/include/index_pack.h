@@ -0,0 +1,9 @@
+#pragma once
+
+/**
+ * @brief Handles the 'index-pack' command.
+ * 
+ * Implements `git index-pack [-j <threads>] [--delta-cache-size=<n>] <file.pack>`,
+ * reading a packfile from disk, resolving its deltas, and writing the matching `.idx` file.
+ */
+int handleIndexPack(int argc, char* argv[]);
@@ -0,0 +1,10 @@
+#pragma once
+
+/**
+ * @brief Handles the 'log' command.
+ *
+ * Implements `git log [-n <count>] [<commit>...]` in Git's default format:
+ * the SHA, the merge parents, the author, the author date and the indented
+ * message of each commit, newest first. Without a commit, starts from HEAD.
+ */
+int handleLog(int argc, char* argv[]);
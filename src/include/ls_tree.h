@@ -3,7 +3,9 @@
 /**
  * @brief Handles the 'ls-tree' command.
  * 
- * Implements `git ls-tree [--name-only] <tree-sha>`, listing the contents
- * of a tree object (filenames, modes, and SHAs).
+ * Implements `git ls-tree [-r] [-t] [-l] [--name-only] <tree-ish>`, listing
+ * the contents of a tree object, or of a commit's root tree (filenames, modes,
+ * and SHAs). `-r` descends into subtrees, `-t` still lists the subtrees it
+ * descends into, and `-l` adds blob sizes read from the object headers only.
  */
 int handleLsTree(int argc, char* argv[]);
\ No newline at end of file
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <optional>
+#include <span>
+
+/**
+ * @class MappedFile
+ * @brief A read-only, memory-mapped view of a file on disk.
+ *
+ * Mapping a file lets the kernel page its contents in lazily, so large files
+ * such as packfiles and their indexes can be accessed randomly without being
+ * read into a heap buffer first. The mapping is released on destruction.
+ */
+class MappedFile {
+public:
+    /**
+     * @brief Maps an entire file into memory.
+     * @param path The file to map.
+     * @return The mapping, or std::nullopt if the file cannot be opened or mapped.
+     */
+    static std::optional<MappedFile> open(const std::filesystem::path& path);
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile();
+
+    /// @brief Returns the mapped bytes. Valid for the lifetime of this object.
+    std::span<const std::byte> bytes() const { return {m_data, m_size}; }
+
+private:
+    MappedFile(const std::byte* data, size_t size) : m_data(data), m_size(size) {}
+
+    const std::byte* m_data = nullptr;
+    size_t m_size = 0;
+};
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "object_id.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @class ObjectCache
+ * @brief A thread-safe LRU cache of inflated objects, keyed by SHA and bounded by total bytes.
+ *
+ * Commands that walk trees or answer `cat-file --batch` are often asked for
+ * the same objects again; this cache keeps the most recently read ones so a
+ * repeat costs a hash lookup instead of an inflate and a delta chain.
+ * Values are full objects ("<type> <size>\0<content>"), as readGitObject()
+ * returns them, held by shared pointers so an evicted entry stays valid for
+ * whoever is still using it.
+ *
+ * The cache is split into shards, each with its own lock, LRU list and an
+ * equal part of the budget. An object always lands in the shard picked by
+ * its last SHA byte, so threads reading different objects rarely wait on
+ * each other.
+ */
+class ObjectCache {
+public:
+    using Value = std::shared_ptr<const std::vector<std::byte>>;
+
+    static constexpr size_t DEFAULT_SHARDS = 16;
+
+    /// @brief Counters summed over all shards.
+    struct Stats {
+        uint64_t hits = 0;      ///< get() calls that found their object.
+        uint64_t misses = 0;    ///< get() calls that did not.
+        uint64_t evictions = 0; ///< Objects dropped to make room for others.
+        size_t bytes_used = 0;  ///< Bytes currently cached.
+    };
+
+    /**
+     * @param max_bytes The budget for all cached objects.
+     * @param shards The number of independently locked shards, at least one.
+     */
+    explicit ObjectCache(size_t max_bytes, size_t shards = DEFAULT_SHARDS);
+
+    /// @brief Returns the cached object, marking it as recently used, or nullptr on a miss.
+    Value get(const ObjectId& id);
+
+    /**
+     * @brief Caches an object, evicting the least recently used ones of its shard to stay within budget.
+     * Objects larger than a shard's part of the budget are not cached.
+     */
+    void put(const ObjectId& id, Value object);
+
+    /// @brief Changes the budget, evicting objects if the cache is now over it.
+    void setMaxBytes(size_t max_bytes);
+
+    /// @brief Returns the number of bytes currently cached.
+    size_t bytesUsed() const;
+
+    /// @brief Returns the hit, miss and eviction counters.
+    Stats stats() const;
+
+private:
+    using LruList = std::list<std::pair<ObjectId, Value>>; // Most recently used first.
+
+    // Shards sit on their own cache lines so their locks do not contend through false sharing.
+    struct alignas(64) Shard {
+        mutable std::mutex mutex;
+        size_t max_bytes = 0;
+        size_t bytes_used = 0;
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+        LruList lru;
+        std::unordered_map<ObjectId, LruList::iterator> index;
+
+        void evictLocked(LruList::iterator it);
+        void shrinkLocked(size_t incoming);
+    };
+
+    Shard& shardFor(const ObjectId& id) {
+        return m_shards[static_cast<size_t>(id.bytes[ObjectId::SIZE - 1]) % m_shards.size()];
+    }
+
+    std::vector<Shard> m_shards;
+};
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <array>
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+/**
+ * @struct ObjectId
+ * @brief The 20-byte SHA-1 that names a Git object, held by value.
+ *
+ * An ObjectId is trivially copyable and never allocates, so it can be
+ * passed, stored and used as a map key freely. Hex conversion happens only
+ * at the edges: when parsing user input and when printing.
+ */
+struct ObjectId {
+    static constexpr size_t SIZE = 20;     ///< Raw bytes in a SHA-1.
+    static constexpr size_t HEX_SIZE = 40; ///< Characters in its hex form.
+
+    std::array<std::byte, SIZE> bytes{};
+
+    /// @brief Parses 40 hex digits, in either case. Returns std::nullopt for anything else.
+    static constexpr std::optional<ObjectId> fromHex(std::string_view hex);
+
+    /**
+     * @brief Copies 20 raw bytes, e.g. out of a tree entry or a pack index.
+     * @throws std::invalid_argument if `raw` is not exactly 20 bytes long.
+     */
+    static ObjectId fromBytes(std::span<const std::byte> raw);
+
+    /// @brief Writes the 40 lowercase hex digits to `out`, which must have room for them.
+    constexpr void toHex(char* out) const;
+
+    /// @brief Returns the 40 lowercase hex digits.
+    std::string toHex() const;
+
+    /// @brief Returns the raw bytes.
+    std::span<const std::byte, SIZE> span() const { return bytes; }
+
+    constexpr auto operator<=>(const ObjectId&) const = default;
+};
+
+namespace object_id_detail {
+    constexpr char HEX_DIGITS[] = "0123456789abcdef";
+
+    // Maps an ASCII character to its hex value, or -1 if it is not a hex digit.
+    constexpr std::array<int8_t, 256> HEX_VALUES = [] {
+        std::array<int8_t, 256> values{};
+        values.fill(-1);
+        for (int i = 0; i < 10; ++i) {
+            values['0' + i] = static_cast<int8_t>(i);
+        }
+        for (int i = 0; i < 6; ++i) {
+            values['a' + i] = static_cast<int8_t>(10 + i);
+            values['A' + i] = static_cast<int8_t>(10 + i);
+        }
+        return values;
+    }();
+}
+
+constexpr std::optional<ObjectId> ObjectId::fromHex(std::string_view hex) {
+    if (hex.size() != HEX_SIZE) {
+        return std::nullopt;
+    }
+    ObjectId id;
+    for (size_t i = 0; i < SIZE; ++i) {
+        int high = object_id_detail::HEX_VALUES[static_cast<unsigned char>(hex[2 * i])];
+        int low = object_id_detail::HEX_VALUES[static_cast<unsigned char>(hex[2 * i + 1])];
+        if (high < 0 || low < 0) {
+            return std::nullopt;
+        }
+        id.bytes[i] = static_cast<std::byte>((high << 4) | low);
+    }
+    return id;
+}
+
+constexpr void ObjectId::toHex(char* out) const {
+    for (size_t i = 0; i < SIZE; ++i) {
+        auto value = static_cast<unsigned char>(bytes[i]);
+        out[2 * i] = object_id_detail::HEX_DIGITS[value >> 4];
+        out[2 * i + 1] = object_id_detail::HEX_DIGITS[value & 0x0F];
+    }
+}
+
+inline ObjectId ObjectId::fromBytes(std::span<const std::byte> raw) {
+    if (raw.size() != SIZE) {
+        throw std::invalid_argument("An object id must be 20 bytes long");
+    }
+    ObjectId id;
+    std::memcpy(id.bytes.data(), raw.data(), SIZE);
+    return id;
+}
+
+inline std::string ObjectId::toHex() const {
+    std::string hex(HEX_SIZE, '\0');
+    toHex(hex.data());
+    return hex;
+}
+
+/**
+ * @brief Hashes an ObjectId for unordered containers.
+ *
+ * A SHA-1 is already uniformly distributed, so its first 8 bytes are a
+ * good hash as they are.
+ */
+struct ObjectIdHash {
+    size_t operator()(const ObjectId& id) const noexcept {
+        uint64_t prefix;
+        std::memcpy(&prefix, id.bytes.data(), sizeof(prefix));
+        return static_cast<size_t>(prefix);
+    }
+};
+
+template <>
+struct std::hash<ObjectId> : ObjectIdHash {};
@@ -1,10 +1,22 @@
 #pragma once
 
+#include "object_cache.h"
+#include "object_id.h"
+
 #include <string>
 #include <vector>
 #include <optional>
 #include <cstddef>
 #include <span>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string_view>
+#include <functional>
+#include <utility>
+
+class Sha1Hasher;
+class ZlibDeflateStream;
 
 /** @struct TreeEntry
  *  @brief Represents a single entry (file or directory) within a Git tree object.
@@ -12,31 +24,190 @@
 struct TreeEntry {
     std::string mode;                 ///< File mode (e.g., "100644" for blob, "40000" for tree).
     std::string filename;             ///< The name of the file or subdirectory.
-    std::vector<std::byte> sha1Bytes; ///< The 20-byte raw SHA-1 hash of the blob or subtree.
+    ObjectId sha1;                    ///< The SHA-1 of the blob or subtree.
 };
 
 
 /**
  * @brief Reads a Git object from the local object database.
  * 
- * Locates the object file using its SHA, reads it, and decompresses it.
+ * Looks the SHA up in the packfiles of `.git/objects/pack` first, then falls
+ * back to the loose file `.git/objects/xx/yyyy`, and decompresses it.
  *
- * @param sha1Hex The 40-character hex SHA of the object.
+ * @param id The SHA of the object.
  * @return A vector of bytes containing the decompressed object (header + content),
  *         or std::nullopt if the object is not found or an error occurs.
  */
-std::optional<std::vector<std::byte>> readGitObject(const std::string& sha1Hex);
+std::optional<std::vector<std::byte>> readGitObject(const ObjectId& id);
+
+/**
+ * @brief Returns true if the object is stored loose or in a loaded pack, without reading it.
+ *
+ * Writers call it to skip objects the repository already has, whichever
+ * store holds them.
+ */
+bool hasObject(const ObjectId& id);
+
+/**
+ * @brief Returns the object cache shared by the whole process.
+ *
+ * Its budget starts at constants::DEFAULT_OBJECT_CACHE_SIZE and can be
+ * changed with ObjectCache::setMaxBytes(), e.g. from `--object-cache-size`.
+ */
+ObjectCache& objectCache();
+
+/**
+ * @brief Reads a Git object through the process-wide object cache.
+ *
+ * A hit costs a hash lookup; a miss reads the object with readGitObject()
+ * and caches it. Objects never change once written, so a cached object
+ * never goes stale. Meant for objects that are read again and again, such
+ * as trees during a walk; large blobs read once are better streamed.
+ *
+ * @param id The SHA of the object.
+ * @return The full object (header + content), or nullptr if it is not found.
+ */
+ObjectCache::Value readCachedGitObject(const ObjectId& id);
+
+/** @struct ObjectInfo
+ *  @brief The type and size of an object, as announced by its header.
+ */
+struct ObjectInfo {
+    std::string type; ///< The object type, e.g. "blob".
+    uint64_t size;    ///< The size of the content, without the header.
+};
+
+/**
+ * @brief Reads the type and size of an object without reading its content.
+ *
+ * A loose object is inflated only as far as its "<type> <size>\0" header.
+ * A packed object is answered from its entry header, plus the first bytes
+ * of the delta instructions when it is stored as a delta. The cost is the
+ * same for a 10-byte blob and a 1 GB one.
+ *
+ * @param id The SHA of the object.
+ * @return The object's type and size, or std::nullopt if it is missing or corrupt.
+ */
+std::optional<ObjectInfo> readGitObjectInfo(const ObjectId& id);
+
+/// @brief Receives the next bytes of an object's content.
+using ObjectContentSink = std::function<void(std::span<const std::byte> data)>;
+
+/**
+ * @brief Streams the content of an object, without its header, to a sink.
+ *
+ * A loose object is inflated in fixed-size chunks, so even a huge blob is
+ * never held in memory. A packed object is resolved in memory first and
+ * handed to the sink in one piece. If the object turns out to be corrupt,
+ * the sink may already have received part of it.
+ *
+ * @param id The SHA of the object.
+ * @param sink Called with each piece of content, in order. Exceptions it throws propagate.
+ * @return True if the whole content was streamed, false if the object is missing or corrupt.
+ */
+bool streamGitObject(const ObjectId& id, const ObjectContentSink& sink);
+
+/** @enum FsyncPolicy
+ *  @brief How new objects are made durable before they become visible.
+ *
+ *  Whatever the policy, an object is written to a temporary file and renamed
+ *  to `.git/objects/xx/yyyy` once complete, so a crash never leaves a
+ *  truncated object under its final name. The policy only decides how much
+ *  a crash may lose.
+ */
+enum class FsyncPolicy {
+    None,      ///< Never fsync. Objects written just before a crash may be lost.
+    PerObject, ///< fsync every object before renaming it. Safe, but one disk flush per object.
+    Batch,     ///< Renames wait for flushObjectWrites(), which syncs the filesystem once for all of them.
+};
+
+/// @brief Returns the fsync policy of this process. The default is FsyncPolicy::None.
+FsyncPolicy fsyncPolicy();
+
+/// @brief Sets the fsync policy for every object written from now on.
+void setFsyncPolicy(FsyncPolicy policy);
+
+/// @brief Parses "none", "per-object" or "batch". Returns std::nullopt for anything else.
+std::optional<FsyncPolicy> parseFsyncPolicy(std::string_view name);
+
+/**
+ * @brief Makes the loose objects written under FsyncPolicy::Batch durable and visible.
+ *
+ * Calls syncfs() once on the filesystem of `.git/objects`, then renames
+ * every pending object into place. Until then, those objects cannot be read.
+ * This is done after each command and at exit; a command that reads back
+ * objects it has just written calls it first. Does nothing if no object is pending.
+ *
+ * @throws std::runtime_error if the sync or a rename fails.
+ */
+void flushObjectWrites();
+
+/**
+ * @brief Flushes a finished file, such as a new pack or index, to disk unless the policy is FsyncPolicy::None.
+ *
+ * Packs are few and large, so they are synced one by one even under FsyncPolicy::Batch.
+ * @throws std::runtime_error if the file cannot be opened or synced.
+ */
+void syncFileForPolicy(const std::filesystem::path& path);
 
 /**
  * @brief Writes a Git object to the local object database.
  *
- * Hashes the content to get its SHA, compresses it, and writes it to the
- * appropriate path in `.git/objects`.
+ * Hashes the content to get its SHA, compresses it into a temporary file,
+ * and moves that to the appropriate path in `.git/objects` according to the
+ * fsync policy. While a BulkCheckin is active, the object is appended to its
+ * pack instead.
  *
  * @param content The full object content (header + data) as a byte span.
- * @return The 20-byte raw SHA-1 hash of the object, or std::nullopt on failure.
+ * @return The SHA-1 of the object, or std::nullopt on failure.
  */
-std::optional<std::vector<std::byte>> writeGitObject(std::span<const std::byte> content);
+std::optional<ObjectId> writeGitObject(std::span<const std::byte> content);
+
+/**
+ * @class LooseObjectWriter
+ * @brief Writes a loose object whose content arrives in pieces, with bounded memory.
+ *
+ * The content is hashed and compressed as it is written, and the compressed
+ * bytes go to a temporary file in `.git/objects`. Once the SHA is known,
+ * commit() moves that file to `.git/objects/xx/yyyy` following the fsync
+ * policy, so a reader never sees a partial object. An uncommitted writer
+ * deletes its temporary file.
+ */
+class LooseObjectWriter {
+public:
+    /**
+     * @brief Starts an object and writes its "<type> <size>\0" header.
+     * @param type The object type, e.g. "blob".
+     * @param size The exact number of content bytes that will be written.
+     * @throws std::runtime_error if the temporary file cannot be created.
+     */
+    LooseObjectWriter(std::string_view type, uint64_t size);
+    ~LooseObjectWriter();
+    LooseObjectWriter(const LooseObjectWriter&) = delete;
+    LooseObjectWriter& operator=(const LooseObjectWriter&) = delete;
+
+    /// @brief Adds the next bytes of content. @throws std::runtime_error on a write error.
+    void write(std::span<const std::byte> data);
+
+    /**
+     * @brief Finishes the object and moves it into place.
+     * @return The SHA-1 of the object.
+     * @throws std::runtime_error if the content size does not match the header or the file cannot be stored.
+     */
+    ObjectId commit();
+
+private:
+    // Writes compressed bytes to the temporary file.
+    void writeCompressed(std::span<const std::byte> data);
+
+    std::filesystem::path m_tmpPath;
+    int m_fd = -1;
+    uint64_t m_expectedSize;
+    uint64_t m_writtenSize = 0;
+    bool m_committed = false;
+    std::unique_ptr<Sha1Hasher> m_hasher;
+    std::unique_ptr<ZlibDeflateStream> m_deflater;
+};
 
 /**
  * @brief Finds the first null byte separator in a data span.
@@ -44,6 +215,12 @@ std::optional<std::vector<std::byte>> writeGitObject(std::span<const std::byte>
  */
 std::span<const std::byte>::iterator findNullSeparator(std::span<const std::byte> data);
 
+/**
+ * @brief Splits a full "<type> <size>\0<content>" object into its type and its content.
+ * @return The type and the content, both pointing into `object`, or std::nullopt if the header is malformed.
+ */
+std::optional<std::pair<std::string_view, std::span<const std::byte>>> splitObject(std::span<const std::byte> object);
+
 /**
  * @brief Formats a file mode for display, matching `git ls-tree` output.
  * Ensures the mode is 6 digits (e.g., "40000" becomes "040000").
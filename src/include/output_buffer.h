@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+/**
+ * @class OutputBuffer
+ * @brief Collects command output in memory and writes it to a stream in large blocks.
+ *
+ * main() puts std::cout in unitbuf mode, so every `<<` is a write(2). A
+ * command that prints one line per object instead appends its lines here;
+ * the stream then sees one write per block, whatever its unitbuf setting.
+ */
+class OutputBuffer {
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 256 * 1024;
+
+    explicit OutputBuffer(std::ostream& out, size_t capacity = DEFAULT_CAPACITY);
+    ~OutputBuffer(); ///< Flushes what is left.
+    OutputBuffer(const OutputBuffer&) = delete;
+    OutputBuffer& operator=(const OutputBuffer&) = delete;
+
+    OutputBuffer& operator<<(std::string_view text) {
+        if (m_buffer.size() + text.size() > m_capacity) {
+            flush();
+        }
+        m_buffer.insert(m_buffer.end(), text.begin(), text.end());
+        return *this;
+    }
+
+    OutputBuffer& operator<<(char c) {
+        if (m_buffer.size() == m_capacity) {
+            flush();
+        }
+        m_buffer.push_back(c);
+        return *this;
+    }
+
+    /// @brief Appends a number in decimal, right-aligned in `width` columns.
+    void appendNumber(uint64_t value, size_t width = 0);
+
+    /// @brief Writes the buffered bytes to the stream.
+    void flush();
+
+    /// @brief Returns false once a write to the stream has failed.
+    bool good() const { return m_out.good(); }
+
+private:
+    std::ostream& m_out;
+    size_t m_capacity;
+    std::vector<char> m_buffer;
+};
@@ -0,0 +1,147 @@
+#pragma once
+
+#include "mapped_file.h"
+#include "packfile_utils.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <vector>
+
+/**
+ * @class PackIndex
+ * @brief A read-only view of a version 2 pack index (`.idx`) file.
+ *
+ * The index lists every object of a packfile sorted by SHA-1, preceded by a
+ * 256-entry fanout table where entry `i` counts the objects whose first byte
+ * is at most `i`. A lookup therefore only binary-searches the small range of
+ * names that share the first byte of the wanted SHA.
+ */
+class PackIndex {
+public:
+    /**
+     * @brief Maps and validates an index file.
+     * @return The index, or std::nullopt if the file is missing or not a v2 index.
+     */
+    static std::optional<PackIndex> open(const std::filesystem::path& path);
+
+    /**
+     * @brief Finds the offset of an object inside the matching packfile.
+     * @param id The SHA-1 of the object.
+     * @return The byte offset of the object's entry, or std::nullopt if it is not in this pack.
+     */
+    std::optional<uint64_t> findOffset(const ObjectId& id) const;
+
+    /// @brief Returns the number of objects listed in the index.
+    uint32_t objectCount() const { return m_object_count; }
+
+    /// @brief Returns the trailing checksum of the packfile this index describes.
+    std::span<const std::byte> packChecksum() const;
+
+private:
+    explicit PackIndex(MappedFile file) : m_file(std::move(file)) {}
+
+    // Returns the offset stored at a position of the sorted SHA table.
+    uint64_t offsetAt(uint32_t position) const;
+
+    MappedFile m_file;
+    uint32_t m_object_count = 0;
+};
+
+/** @struct PackedObjectInfo
+ *  @brief The type and size of a packed object, known without inflating its content.
+ */
+struct PackedObjectInfo {
+    GitObjectType type; ///< The object's type (never a delta type).
+    uint64_t size;      ///< The size of the object's content.
+};
+
+/**
+ * @class Packfile
+ * @brief A memory-mapped packfile paired with its index.
+ *
+ * Objects are located through the index and inflated straight from the
+ * mapping. Deltas are resolved by walking their base chain back to a full
+ * object and replaying the instructions on the way out.
+ */
+class Packfile {
+public:
+    /**
+     * @brief Opens `pack-<sha>.idx` and the `pack-<sha>.pack` next to it.
+     * @return The packfile, or std::nullopt if either file is invalid or they do not match.
+     */
+    static std::optional<Packfile> open(const std::filesystem::path& idxPath);
+
+    /// @brief Returns the offset of an object in this pack, if present.
+    std::optional<uint64_t> findOffset(const ObjectId& id) const { return m_index.findOffset(id); }
+
+    /**
+     * @brief Reads and fully resolves the object stored at an offset.
+     * @param offset The byte offset of the object's entry, as returned by findOffset().
+     * @return The resolved object, or std::nullopt if the entry is corrupt or its base is missing.
+     */
+    std::optional<PackedObject> readObject(uint64_t offset) const;
+
+    /**
+     * @brief Reads the type and size of the object stored at an offset, without inflating it.
+     *
+     * A base entry's header already holds both. For a delta, the size is read
+     * from the first bytes of its instructions, and the type is that of the
+     * base found at the end of its chain, whose headers are all that is read.
+     *
+     * @param offset The byte offset of the object's entry, as returned by findOffset().
+     * @return The object's type and size, or std::nullopt if the entry is corrupt or its base is missing.
+     */
+    std::optional<PackedObjectInfo> readObjectInfo(uint64_t offset) const;
+
+private:
+    Packfile(PackIndex index, MappedFile pack) : m_index(std::move(index)), m_pack(std::move(pack)) {}
+
+    PackIndex m_index;
+    MappedFile m_pack;
+};
+
+/**
+ * @brief Looks an object up in every packfile of `.git/objects/pack`.
+ *
+ * The pack directory is scanned once per process and kept mapped. Call
+ * reloadPacks() after a new pack has been written to make it visible.
+ *
+ * @param id The SHA-1 of the object.
+ * @return The resolved object, or std::nullopt if no pack contains it.
+ */
+std::optional<PackedObject> readPackedObject(const ObjectId& id);
+
+/**
+ * @brief Looks up the type and size of an object in every packfile, without inflating it.
+ * @param id The SHA-1 of the object.
+ * @return The object's type and size, or std::nullopt if no pack contains it.
+ */
+std::optional<PackedObjectInfo> readPackedObjectInfo(const ObjectId& id);
+
+/// @brief Returns true if some packfile lists the object, without reading it.
+bool hasPackedObject(const ObjectId& id);
+
+/**
+ * @brief Rescans `.git/objects/pack` and maps any pack that is not loaded yet.
+ * @return True if at least one new pack was found.
+ */
+bool reloadPacks();
+
+/**
+ * @brief Writes a version 2 pack index (`.idx`) describing a parsed packfile.
+ *
+ * Objects are sorted by SHA-1 and written as a fanout table, the SHA table,
+ * the CRC32 table and the offset table. Offsets that do not fit in 31 bits are
+ * moved to a trailing 64-bit table. The file ends with the pack's checksum and
+ * a SHA-1 of the index itself, exactly as `git index-pack` produces it.
+ *
+ * @param idxPath Where to write the index.
+ * @param objects The metadata of every object in the pack, as returned by PackfileParser.
+ * @param packChecksum The 20-byte trailing checksum of the packfile.
+ * @return True on success, false if the file cannot be written.
+ */
+bool writePackIndex(const std::filesystem::path& idxPath, const std::vector<PackObjectInfo>& objects,
+                    std::span<const std::byte> packChecksum);
@@ -5,6 +5,18 @@
 #include <cstdint>
 #include <optional>
 #include <map>
+#include <span>
+#include <string_view>
+#include <utility>
+#include <functional>
+#include <memory>
+
+#include "constants.h"
+#include "object_id.h"
+
+class DeltaBaseCache;
+class Sha1Hasher;
+struct z_stream_s; // zlib's z_stream, kept out of this header.
 
 // Represents the different types of objects found within a packfile.
 enum class GitObjectType {
@@ -29,18 +41,94 @@ static const std::map<GitObjectType, std::string> typeToStringMap = {
 
 // Stores metadata for a single object after it has been parsed from the packfile.
 struct PackObjectInfo {
-    std::string sha1;             // The final SHA-1 of the object (computed after delta resolution).
+    ObjectId sha1;                // The final SHA-1 of the object (computed after delta resolution).
     GitObjectType type;           // The object's type (e.g., COMMIT, BLOB).
     size_t uncompressed_size;     // The size of the object's data after decompression.
     size_t size_in_packfile;      // The total size of the entry in the packfile (header + compressed data).
     size_t offset_in_packfile;    // The starting offset of the object within the packfile.
-    std::string delta_ref;        // For deltas, stores the base object's SHA or offset.
+    uint32_t crc32;               // CRC32 of the raw entry bytes (header + compressed data), as stored in .idx files.
+    ObjectId delta_ref;           // For REF_DELTA entries, the base object's SHA.
+    size_t base_offset = 0;       // For OFS_DELTA entries, the offset of the base entry.
 };
 
-// Represents a delta object that has been parsed but not yet resolved.
-struct PendingDeltaObject {
-    PackObjectInfo info;               // Parsed metadata for the delta object itself.
-    std::vector<std::byte> delta_data; // The raw delta instructions.
+/** @struct PackedObject
+ *  @brief A fully resolved object read out of a packfile.
+ */
+struct PackedObject {
+    GitObjectType type;          ///< The object's type (never a delta type).
+    std::vector<std::byte> data; ///< The object's content, without the "<type> <size>\0" header.
+};
+
+/**
+ * @class PackStreamScanner
+ * @brief Walks a packfile as its bytes arrive, without ever holding the whole pack.
+ *
+ * Chunks of any size can be fed in, e.g. straight from a network callback.
+ * The scanner keeps one zlib stream open for the entry being read and
+ * records the metadata of every entry: offset, type, size, CRC32 and delta
+ * base. Base objects are hashed as they are inflated. Delta data is only
+ * walked through; it is resolved later from the stored pack by PackfileParser.
+ */
+class PackStreamScanner {
+public:
+    /// @brief Receives every base (non-delta) object once it has been fully inflated.
+    using ObjectHandler = std::function<void(const PackObjectInfo& info, std::span<const std::byte> data)>;
+
+    PackStreamScanner();
+    ~PackStreamScanner();
+    PackStreamScanner(const PackStreamScanner&) = delete;
+    PackStreamScanner& operator=(const PackStreamScanner&) = delete;
+
+    /**
+     * @brief Registers a callback that receives the content of every base object.
+     * Without one, base objects are hashed on the fly and never buffered.
+     */
+    void setObjectHandler(ObjectHandler handler);
+
+    /**
+     * @brief Consumes the next bytes of the packfile.
+     * @throws std::runtime_error if the data is not a valid version 2 packfile,
+     *         if its checksum does not match, or if bytes follow the trailer.
+     */
+    void feed(std::span<const std::byte> data);
+
+    /// @brief Returns true once every entry and the trailing checksum have been read and verified.
+    bool isComplete() const { return m_state == State::Done; }
+
+    /// @brief Returns the number of objects announced in the pack header (0 until it has been read).
+    uint32_t objectCount() const { return m_object_count; }
+
+    /// @brief Returns the verified 20-byte trailing checksum. Only valid once isComplete().
+    std::span<const std::byte> packChecksum() const { return m_checksum.span(); }
+
+    /// @brief Hands over the metadata of every entry read so far, in packfile order.
+    std::vector<PackObjectInfo> takeObjects() { return std::move(m_objects); }
+
+private:
+    enum class State { PackHeader, EntryHeader, EntryData, Trailer, Done };
+
+    // Parses the entry header buffered in m_pending once it is complete.
+    // Returns how many buffered bytes it spans, or 0 if more bytes are needed.
+    size_t tryParseEntryHeader();
+
+    // Inflates as much of the current entry as `data` holds. Returns the bytes consumed.
+    size_t inflateEntryData(std::span<const std::byte> data);
+
+    State m_state = State::PackHeader;
+    size_t m_offset = 0;                       // Packfile offset of the next byte to be fed.
+    uint32_t m_object_count = 0;               // Entries announced in the pack header.
+    uint32_t m_remaining = 0;                  // Entries not fully read yet.
+    std::vector<std::byte> m_pending;          // Bytes of a header or trailer split across chunks.
+    ObjectId m_checksum;                       // The verified trailing checksum.
+    std::vector<PackObjectInfo> m_objects;     // Metadata of the entries read so far.
+    PackObjectInfo m_current;                  // The entry being inflated.
+    size_t m_produced = 0;                     // Bytes inflated so far for the current entry.
+    std::vector<std::byte> m_content;          // Content of the current base object, if a handler is set.
+    std::vector<std::byte> m_scratch;          // Output buffer for inflate when nothing is kept.
+    ObjectHandler m_object_handler;
+    std::unique_ptr<z_stream_s> m_zstream;     // Inflates the entry being read.
+    std::unique_ptr<Sha1Hasher> m_pack_hasher; // Checksum of everything before the trailer.
+    std::unique_ptr<Sha1Hasher> m_object_hasher; // SHA-1 of the current base object.
 };
 
 /**
@@ -53,62 +141,139 @@ struct PendingDeltaObject {
  */
 class PackfileParser {
 public:
+    /**
+     * @brief Receives every object of the pack once its content is known.
+     *
+     * The span is only valid during the call. When the parser uses several
+     * threads, the handler may be called concurrently and must be thread-safe.
+     */
+    using ObjectHandler = std::function<void(const PackObjectInfo& info, std::span<const std::byte> data)>;
+
      /**
      * @brief Constructs a parser for the given packfile data.
-     * @param packfile_data A vector of bytes containing the entire packfile.
+     * @param packfile_data The entire packfile, including its trailing checksum.
+     *        It must outlive the parser (e.g., a vector or a memory-mapped file).
+     * @param num_threads The number of threads used to apply deltas.
+     * @param delta_cache_size The byte budget for delta bases kept in memory.
      */
-    PackfileParser(const std::vector<std::byte>& packfile_data);
+    PackfileParser(std::span<const std::byte> packfile_data, unsigned int num_threads = 1,
+                   size_t delta_cache_size = constants::DEFAULT_DELTA_CACHE_SIZE);
+    ~PackfileParser();
+
+    /**
+     * @brief Registers a callback that receives the content of every object.
+     * Use it to write objects out; the parser itself does not keep them.
+     */
+    void setObjectHandler(ObjectHandler handler);
 
     /**
      * @brief Parses the entire packfile and resolves all deltas.
      * 
-     * This is the main entry point. It employs a multi-pass strategy:
-     * 1. First pass: Parses all objects. Base objects are stored directly.
-     *    Delta objects are stored in a "pending" list.
-     * 2. Subsequent passes: Iteratively attempts to resolve pending deltas
-     *    until all have been applied.
+     * This is the main entry point. It works in two passes:
+     * 1. First pass: Streams the pack through a PackStreamScanner, hashing
+     *    base objects and recording where each delta's base is (by offset or by SHA).
+     * 2. Second pass: Builds a base -> children graph once, then walks each
+     *    base object's delta tree depth-first. Every delta is applied exactly
+     *    once. Bases live in a byte-budgeted LRU cache; when one has been
+     *    evicted it is inflated again from its offset in the pack, so memory
+     *    stays bounded by the cache size. Independent trees are resolved in parallel.
      * 
-     * @return A vector of object metadata structures, or std::nullopt on failure.
+     * @return A vector of object metadata structures sorted by offset, or std::nullopt
+     *         on failure (bad header or checksum, or a delta whose base is not in the pack).
      */
     std::optional<std::vector<PackObjectInfo>> parseAndResolve();
 
     /**
-     * @brief Retrieves the raw, uncompressed data of all resolved objects.
-     * @return A const reference to a map from SHA-1 to the object's byte data.
+     * @brief Runs only the second pass, on entries already read by a PackStreamScanner.
+     *
+     * Use it when the pack was scanned while it was being received, so that
+     * base objects have already been hashed and handed out. Only the deltas
+     * reach the object handler.
+     *
+     * @param objects The entries returned by PackStreamScanner::takeObjects().
+     * @return The same entries with every delta resolved, or std::nullopt if a base is missing.
      */
-    const std::map<std::string, std::vector<std::byte>>& getResolvedObjectsData() const;
+    std::optional<std::vector<PackObjectInfo>> resolveDeltas(std::vector<PackObjectInfo> objects);
 
 private:
-    const std::vector<std::byte>& m_packfile; // A non-owning reference to the packfile data.
-    size_t m_cursor;                          // Current read position within the packfile.
+    std::span<const std::byte> m_packfile; // A non-owning view of the packfile data.
+    unsigned int m_num_threads;            // Number of threads used to apply deltas.
+    ObjectHandler m_object_handler;        // Optional consumer of resolved objects.
+    std::unique_ptr<DeltaBaseCache> m_delta_base_cache; // Bases of the chains being walked.
 
-    // Caches used during the delta resolution process.
-    std::map<std::string, std::vector<std::byte>> m_object_data_cache; // sha1 -> raw_data
-    std::map<std::string, GitObjectType> m_object_type_cache;          // sha1 -> type
-    std::map<size_t, std::string> m_offset_to_sha_map;                 // offset -> sha1
+    // One level of a delta chain being walked: a base and the deltas left to apply on it.
+    struct ChainLink {
+        size_t object;                 // Index of the object serving as a base.
+        std::vector<size_t> children;  // Deltas still to be applied on top of it.
+    };
 
+    // Inflates the data (or delta instructions) of the entry starting at an offset.
+    std::vector<std::byte> inflateEntryAt(size_t offset) const;
 
-    // Reads a 32-bit big-endian integer and advances the cursor.
-    uint32_t read_big_endian_32();
+    // Returns the content of the base at `depth` in a chain, rebuilding it from the pack if evicted.
+    std::shared_ptr<const PackedObject> loadBase(const std::vector<PackObjectInfo>& objects,
+                                                 const std::vector<ChainLink>& chain, size_t depth);
+};
 
-    // Verifies the "PACK" magic header and version number.
-    bool verify_header();
+/**
+ * @brief Decodes the variable-length type and size header of a packfile entry.
+ * @param pack The packfile bytes.
+ * @param cursor The offset of the entry. It is advanced past the header.
+ * @return The entry's type and uncompressed size.
+ * @throws std::runtime_error if the header runs past the end of the data.
+ */
+std::pair<GitObjectType, uint64_t> readPackEntryHeader(std::span<const std::byte> pack, size_t& cursor);
+
+/**
+ * @brief Encodes the type and size header of a packfile entry, the inverse of readPackEntryHeader().
+ * @param type The entry's type.
+ * @param size The entry's uncompressed size.
+ * @param out Receives the header; 10 bytes are always enough.
+ * @return The number of bytes written to `out`.
+ */
+size_t writePackEntryHeader(GitObjectType type, uint64_t size, std::byte* out);
 
-    // Reads a variable-length integer used for object sizes in packfiles.
-    uint64_t read_variable_length_integer(size_t& cursor, const std::vector<std::byte>& data);
+/// @brief Maps a type name from an object header, e.g. "blob", back to its type.
+std::optional<GitObjectType> typeFromName(std::string_view typeName);
 
-    /**
-     * @brief Applies delta instructions to a base object to reconstruct a target object.
-     * @param base The raw data of the base object.
-     * @param delta_instructions The raw delta instructions.
-     * @return The reconstructed data of the target object.
-     */
-    std::vector<std::byte> apply_delta(const std::vector<std::byte>& base, const std::vector<std::byte>& delta_instructions);
-    
-    /**
-     * @brief Decompresses object data starting from the current cursor.
-     * @param uncompressed_size The expected size of the data after decompression.
-     * @return A pair containing the decompressed data and the number of compressed bytes consumed.
-     */
-    std::pair<std::vector<std::byte>, size_t> decompress_data(size_t uncompressed_size);
-};
+/**
+ * @brief Decodes the base offset that follows an OFS_DELTA entry header.
+ *
+ * Unlike sizes, this is a big-endian base-128 number where each continuation
+ * adds one before shifting, so that every encoding is unique.
+ *
+ * @param pack The packfile bytes.
+ * @param cursor The offset right after the entry header. It is advanced past the encoding.
+ * @return The distance between the delta entry and its base, in bytes.
+ */
+uint64_t readOfsDeltaOffset(std::span<const std::byte> pack, size_t& cursor);
+
+/**
+ * @brief Inflates the zlib stream of a single packfile entry.
+ * @param input The bytes starting at the entry's compressed data.
+ * @param uncompressed_size The size announced in the entry header.
+ * @return A pair containing the decompressed data and the number of compressed bytes consumed.
+ * @throws std::runtime_error if the stream is corrupt or does not match the announced size.
+ */
+std::pair<std::vector<std::byte>, size_t> inflatePackEntry(std::span<const std::byte> input, size_t uncompressed_size);
+
+/**
+ * @brief Reads the size of the object a delta produces, from the start of its instructions.
+ *
+ * Delta instructions begin with the base size and the target size as two
+ * little-endian base-128 numbers, so only their first few bytes are needed.
+ *
+ * @param delta_prefix The first bytes of the inflated delta instructions (20 are always enough).
+ * @return The size of the reconstructed object.
+ * @throws std::runtime_error if the prefix ends inside one of the two numbers.
+ */
+uint64_t readDeltaTargetSize(std::span<const std::byte> delta_prefix);
+
+/**
+ * @brief Applies delta instructions to a base object to reconstruct a target object.
+ * @param base The raw data of the base object.
+ * @param delta_instructions The raw delta instructions.
+ * @return The reconstructed data of the target object.
+ * @throws std::runtime_error if the delta is malformed or does not match the base.
+ */
+std::vector<std::byte> applyDelta(std::span<const std::byte> base, std::span<const std::byte> delta_instructions);
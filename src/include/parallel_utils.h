@@ -0,0 +1,47 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Runs `fn(i)` for every `i` in `[0, count)` across up to `num_threads` threads.
+ *
+ * Work is handed out one index at a time through an atomic counter, so slow
+ * items do not hold up a whole batch. The first exception thrown by any
+ * worker stops the remaining work and is rethrown on the calling thread.
+ */
+template <typename Fn>
+void parallelFor(size_t count, unsigned int num_threads, Fn&& fn) {
+    if (num_threads <= 1 || count < 2) {
+        for (size_t i = 0; i < count; ++i) fn(i);
+        return;
+    }
+
+    std::atomic<size_t> next{0};
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    auto worker = [&]() {
+        try {
+            for (size_t i; (i = next.fetch_add(1)) < count;) fn(i);
+        } catch (...) {
+            std::lock_guard lock(error_mutex);
+            if (!error) error = std::current_exception();
+            next = count; // Make the other workers stop early.
+        }
+    };
+
+    {
+        std::vector<std::jthread> workers;
+        for (unsigned int t = 1; t < std::min<size_t>(num_threads, count); ++t) {
+            workers.emplace_back(worker);
+        }
+        worker(); // The calling thread takes its share too.
+    } // jthread joins on destruction.
+
+    if (error) std::rethrow_exception(error);
+}
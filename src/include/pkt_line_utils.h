@@ -1,31 +1,101 @@
 #pragma once
-#include <istream>
 #include <vector>
 #include <string>
 #include <optional>
+#include <span>
+#include <string_view>
+#include <functional>
+#include <cstddef>
 
 
 /**
- * @class PktLineReader
- * @brief A stateful reader for Git's pkt-line formatted data streams.
- * 
- * This class reads one "packet" at a time from a stream. A packet consists
- * of a 4-byte hex length prefix followed by the payload.
+ * @struct PktLine
+ * @brief One packet decoded from a pkt-line stream.
  */
-class PktLineReader {
+struct PktLine {
+    enum class Type {
+        Data,        ///< A regular packet ("0004" and up); its payload may be empty.
+        Flush,       ///< "0000", ends a section.
+        Delim,       ///< "0001", separates sections in protocol v2.
+        ResponseEnd  ///< "0002", ends a stateless protocol v2 response.
+    };
+    Type type;
+    std::span<const std::byte> payload; ///< The bytes after the length prefix; empty unless type is Data.
+};
+
+/**
+ * @class PktLineDecoder
+ * @brief A zero-copy decoder for Git's pkt-line formatted data.
+ *
+ * A packet consists of a 4-byte hex length prefix followed by the payload.
+ * Packets are returned as views into the input, so nothing is allocated per
+ * packet. Input may be supplied in chunks of any size: a packet cut by the
+ * end of a chunk is assembled in an internal buffer, and only that packet is
+ * copied.
+ */
+class PktLineDecoder {
+public:
+    PktLineDecoder() = default;
+
+    /// @brief Creates a decoder over a complete buffer, which must outlive the decoder's packets.
+    explicit PktLineDecoder(std::span<const std::byte> input) { feed(input); }
+
+    /**
+     * @brief Supplies the next chunk of input.
+     * Call it only once next() has returned std::nullopt for the previous chunk.
+     */
+    void feed(std::span<const std::byte> chunk) { m_input = chunk; }
+
+    /**
+     * @brief Decodes the next packet.
+     * @return The packet, or std::nullopt when more input is needed (or the
+     *         stream is corrupt, see hasError()). The payload stays valid until
+     *         the next call, and as long as the chunk it was fed in.
+     */
+    std::optional<PktLine> next();
+
+    /// @brief Returns true if an invalid length prefix was found. No packet is returned after that.
+    bool hasError() const { return m_error; }
+
+    /// @brief Returns true if the input fed so far ends in the middle of a packet.
+    bool hasPartialPacket() const { return !m_partial.empty(); }
+
 private:
-    std::istream& m_stream;
-    bool m_is_finished;
+    // Moves input into m_partial until it holds `size` bytes. Returns true once it does.
+    bool fillPartial(size_t size);
+
+    std::span<const std::byte> m_input;  // The part of the current chunk not decoded yet.
+    std::vector<std::byte> m_partial;    // A packet cut by the end of a chunk, being assembled.
+    std::vector<std::byte> m_assembled;  // The last packet completed from m_partial.
+    bool m_error = false;
+};
 
+/**
+ * @class SideBandDemuxer
+ * @brief Splits a side-band multiplexed pkt-line stream that arrives in arbitrary chunks.
+ *
+ * A `git-upload-pack` response with side-band-64k carries the packfile on
+ * band 1, progress messages on band 2 and a fatal error on band 3. Chunks can
+ * cut a packet anywhere, even inside its length prefix. Each packfile packet
+ * is forwarded as soon as it is complete.
+ */
+class SideBandDemuxer {
 public:
-    PktLineReader(std::istream& stream);
+    using DataHandler = std::function<void(std::span<const std::byte> data)>;
+
+    /// @param on_pack_data Receives the packfile bytes of band 1, in order.
+    explicit SideBandDemuxer(DataHandler on_pack_data);
 
     /**
-     * @brief Reads the next packet from the stream.
-     * @return The packet's payload as a vector of bytes, or std::nullopt if the
-     *         stream has ended. An empty vector indicates a flush packet ("0000").
+     * @brief Consumes the next chunk of the response.
+     * Progress messages are printed to stderr prefixed with "remote: ".
+     * @return False if the remote reported an error or a length prefix is invalid.
      */
-    std::optional<std::vector<std::byte>> readNextPacket();
+    bool feed(std::string_view chunk);
+
+private:
+    DataHandler m_on_pack_data;
+    PktLineDecoder m_decoder;
 };
 
 /**
@@ -43,16 +113,3 @@ std::optional<std::string> findMainBranchSha1(const std::string& str);
  * @return The pkt-line formatted string.
  */
 std::string createPktLine(const std::string& line);
-
-/**
- * @brief Extracts raw packfile data from a multiplexed server response stream.
- *
- * A `git-upload-pack` response often uses a side-band protocol (like side-band-64k)
- * where the packfile data is mixed with progress messages and error messages.
- * This function reads the pkt-line formatted stream, filters for the packfile
- * data band (\x01), and concatenates it into a single byte vector.
- *
- * @param str The full server response body as a string.
- * @return A vector of bytes containing the raw packfile, or std::nullopt on a critical error.
- */
-std::optional<std::vector<std::byte>> extractPackfileData(const std::string& str);
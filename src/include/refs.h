@@ -0,0 +1,55 @@
+#pragma once
+#include "object_id.h"
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Resolves a revision name to an object id.
+ *
+ * Accepts a full 40-digit SHA, "HEAD", or a ref name, which is looked up the
+ * way Git does: as given, then under `refs/`, `refs/tags/`, `refs/heads/`
+ * and `refs/remotes/`. Each ref is read from its loose file under `.git/`,
+ * then from `.git/packed-refs`; symbolic refs such as HEAD are followed.
+ *
+ * @param name The revision, e.g. "HEAD", "main" or "refs/tags/v1.0".
+ * @return The object the name points to, or std::nullopt if it does not resolve.
+ */
+std::optional<ObjectId> resolveRevision(std::string_view name);
+
+/**
+ * @brief Lists every ref with its value: the loose files under `.git/refs` and `.git/packed-refs`.
+ *
+ * A loose ref takes precedence over a packed ref of the same name. HEAD is
+ * not included. Symbolic refs are resolved; dangling ones are skipped.
+ *
+ * @return (ref name, object id) pairs, sorted by name.
+ */
+std::vector<std::pair<std::string, ObjectId>> listRefs();
+
+/**
+ * @brief Resolves a revision to a tree: a tree itself, a commit's root tree, or the tree a tag points to.
+ *
+ * @param name Anything resolveRevision() accepts.
+ * @return The tree's SHA, or std::nullopt if the name does not resolve to a tree-ish object.
+ */
+std::optional<ObjectId> resolveTreeish(std::string_view name);
+
+/**
+ * @brief Resolves a revision to a commit, peeling annotated tags.
+ *
+ * @param name Anything resolveRevision() accepts.
+ * @return The commit's SHA, or std::nullopt if the name does not resolve to a commit.
+ */
+std::optional<ObjectId> resolveCommit(std::string_view name);
+
+/**
+ * @brief Peels annotated tags, nested ones included, until a commit is reached.
+ *
+ * @param id Any object id; a commit is returned as is.
+ * @return The commit, or std::nullopt if `id` leads to a tree or a blob, or to an object that cannot be read.
+ */
+std::optional<ObjectId> peelToCommit(const ObjectId& id);
@@ -0,0 +1,10 @@
+#pragma once
+
+/**
+ * @brief Handles the 'rev-list' command.
+ *
+ * Implements `git rev-list [-n <count>] <commit>...`, printing the SHA of
+ * every commit reachable from the given ones, newest first. The walk reads
+ * parents and dates from the commit graph when there is one (see RevWalk).
+ */
+int handleRevList(int argc, char* argv[]);
@@ -0,0 +1,144 @@
+#pragma once
+
+#include "bloom_filter.h"
+#include "commit_graph.h"
+#include "object_id.h"
+#include "output_buffer.h"
+
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/**
+ * @brief The arguments `rev-list` and `log` share: `[-n <count> | --max-count=<count>] [<commit>...] [-- <path>...]`.
+ */
+struct RevWalkArgs {
+    uint64_t maxCount = std::numeric_limits<uint64_t>::max();
+    std::vector<std::string> revisions;
+    std::vector<std::string> paths; ///< From the repository root, e.g. "./src/" becomes "src".
+};
+
+/**
+ * @brief Parses the arguments of a history command, starting at `argv[first]`.
+ * @return The arguments, or std::nullopt on an unknown option, a bad count, or a path naming the root.
+ */
+std::optional<RevWalkArgs> parseRevWalkArgs(int argc, char* argv[], int first);
+
+/// @brief Prints one commit of a walk. `index` counts the commits printed before it.
+using CommitPrinter = std::function<void(const ObjectId& id, uint64_t index, OutputBuffer& out)>;
+
+/**
+ * @brief Runs a history command: walks from `args`, newest first, and prints each commit to stdout.
+ *
+ * Opens the commit graph if there is one, limits the walk to `args.paths`
+ * and stops after `args.maxCount` commits. Commands only differ in `print`.
+ *
+ * @return EXIT_SUCCESS, or EXIT_FAILURE after a "Fatal: " message on a bad
+ *         revision, an unreadable commit or a failed write.
+ */
+int printRevWalk(RevWalkArgs args, const CommitPrinter& print);
+
+/**
+ * @class RevWalk
+ * @brief Walks the history reachable from a set of commits, newest first.
+ *
+ * Commits come out in the order `git rev-list` prints them by default:
+ * latest commit date first. Equal dates are broken by generation number,
+ * so a child still comes before its parent, then by the order in which the
+ * commits were reached.
+ *
+ * Commits found in the commit graph are walked straight from its mapping:
+ * their parents, dates and generations are read from fixed-size records and
+ * no commit object is inflated. Commits the graph does not cover, e.g. ones
+ * made since it was written, are read and parsed instead.
+ */
+class RevWalk {
+public:
+    /// @param graph The commit graph to walk, or nullptr to parse every commit.
+    explicit RevWalk(const CommitGraph* graph);
+
+    /**
+     * @brief Adds a starting point. Annotated tags are peeled to their commit.
+     * @throws std::runtime_error if `id` does not name a commit.
+     */
+    void push(const ObjectId& id);
+
+    /**
+     * @brief Limits the walk to the commits that change one of `paths`, like `git log -- <path>...`.
+     *
+     * A commit is shown unless it is TREESAME to a parent, i.e. all the
+     * paths are identical in both trees. A merge that is TREESAME to one of
+     * its parents is followed down that parent only, as Git's default history
+     * simplification does.
+     *
+     * Against a first parent, the commit's changed-path Bloom filter is asked
+     * first: when it rules out every path, no tree is read. Otherwise the
+     * trees are compared along each path only, down to the first level where
+     * both sides hold the same subtree.
+     *
+     * @param paths Paths from the repository root, without trailing slashes.
+     */
+    void setPaths(std::vector<std::string> paths);
+
+    /// @brief Returns the next commit of the walk, or std::nullopt once it is over.
+    std::optional<ObjectId> next();
+
+private:
+    // A queued commit: a graph position, or the SHA of a commit outside the graph.
+    struct Entry {
+        uint64_t date;
+        uint32_t generation;
+        uint32_t graphPos; // NOT_IN_GRAPH for parsed commits.
+        uint64_t sequence; // Insertion order, for ties.
+        ObjectId id;
+    };
+    struct Later {
+        bool operator()(const Entry& a, const Entry& b) const {
+            if (a.date != b.date) return a.date < b.date;
+            if (a.generation != b.generation) return a.generation < b.generation;
+            return a.sequence > b.sequence;
+        }
+    };
+    // A commit outside the graph, parsed once.
+    struct ParsedCommit {
+        ObjectId tree;
+        std::vector<ObjectId> parents;
+        uint64_t commitTime;
+    };
+    // A parent about to be queued. `id` is only set for parents outside the graph.
+    struct Parent {
+        uint32_t graphPos;
+        ObjectId id;
+    };
+
+    static constexpr uint32_t NOT_IN_GRAPH = UINT32_MAX;
+    static constexpr uint32_t GENERATION_INFINITY = UINT32_MAX;
+
+    void pushGraphCommit(uint32_t pos);
+    void pushParsedCommit(const ObjectId& id);
+    const ParsedCommit& parsedCommit(const ObjectId& id);
+    ObjectId parentTree(const Parent& parent);
+
+    // Returns true if the commit changes one of m_paths; otherwise keeps only the parent it matches.
+    bool simplify(const Entry& entry, const ObjectId& tree);
+    bool bloomRulesOut(uint32_t pos) const;
+    bool pathsDiffer(const std::optional<ObjectId>& oldTree, const ObjectId& newTree) const;
+
+    const CommitGraph* m_graph;
+    std::priority_queue<Entry, std::vector<Entry>, Later> m_queue;
+    uint64_t m_sequence = 0;
+    std::vector<bool> m_seenInGraph;
+    std::unordered_set<ObjectId> m_seen;
+    std::unordered_map<ObjectId, ParsedCommit> m_parsed;
+    std::vector<uint32_t> m_parentBuffer;
+    std::vector<Parent> m_parents;
+
+    std::vector<std::string> m_paths;
+    std::vector<std::vector<BloomKey>> m_bloomKeys; // Per path: the path and each of its leading directories.
+};
@@ -1,13 +1,41 @@
 #pragma once
+#include "object_id.h"
+
 #include <string>
 #include <vector>
 #include <span>
 
+struct evp_md_ctx_st; // OpenSSL's EVP_MD_CTX, kept out of this header.
+
 /**
- * @brief Calculates the raw 20-byte SHA-1 hash of a data span.
+ * @class Sha1Hasher
+ * @brief Computes a SHA-1 incrementally over data that arrives in pieces.
+ *
+ * Use it when the hashed content is never held in one buffer, e.g. when it
+ * is streamed from the network or from a large file.
+ */
+class Sha1Hasher {
+public:
+    Sha1Hasher();
+    ~Sha1Hasher();
+    Sha1Hasher(const Sha1Hasher&) = delete;
+    Sha1Hasher& operator=(const Sha1Hasher&) = delete;
+
+    /// @brief Feeds the next bytes of the content.
+    void update(std::span<const std::byte> data);
+
+    /// @brief Returns the SHA-1 of everything fed so far. The hasher cannot be reused.
+    ObjectId finish();
+
+private:
+    evp_md_ctx_st* m_ctx;
+};
+
+/**
+ * @brief Calculates the SHA-1 hash of a data span.
  * This is a low-level function that uses OpenSSL.
  */
-std::vector<std::byte> calculateSha1(std::span<const std::byte> data);
+ObjectId calculateSha1(std::span<const std::byte> data);
 
 /**
  * @brief Converts a span of raw bytes to its hexadecimal string representation.
@@ -18,9 +46,3 @@ std::string bytesToHex(std::span<const std::byte> bytes);
  * @brief A convenience function to calculate the SHA-1 hash and return it as a hex string.
  */
 std::string calculateSha1Hex(std::span<const std::byte> data);
-
-/**
- * @brief Converts a hexadecimal string back into a vector of raw bytes.
- * @throws std::invalid_argument if the hex string has an odd number of characters.
- */
-std::vector<std::byte> hexToBytes(const std::string& hex);
\ No newline at end of file
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <string_view>
+
+/**
+ * @brief Parses a byte count with an optional Git-style unit suffix.
+ *
+ * Accepts a decimal number optionally followed by `k`, `m` or `g` (case
+ * insensitive), meaning KiB, MiB and GiB, e.g. "512", "64k" or "256m".
+ *
+ * @param text The string to parse.
+ * @return The number of bytes, or std::nullopt if the string is malformed or overflows.
+ */
+std::optional<size_t> parseByteSize(std::string_view text);
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <functional>
+#include <optional>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Handles the 'sparse-checkout' command.
+ *
+ * Implements `git sparse-checkout set|add [<directory>...]`, `list` and
+ * `disable` in cone mode. `set` and `add` write `.git/info/sparse-checkout`
+ * and bring the working directory to the new cone; `disable` checks every
+ * file out again and removes the file.
+ */
+int handleSparseCheckout(int argc, char* argv[]);
+
+/**
+ * @class SparseCone
+ * @brief The directories a sparse checkout keeps, read from cone-mode patterns.
+ *
+ * In cone mode, `.git/info/sparse-checkout` lists directories rather than
+ * arbitrary patterns: a pattern for the files at the root, one per listed
+ * directory, and a pair for each of their ancestors that keeps the files
+ * directly in it but none of its subdirectories.
+ *
+ * So a file is checked out if it is at the root, directly in a parent of a
+ * listed directory, or anywhere under a listed directory. Every question is
+ * answered from a directory name alone, so a tree walk can skip a subtree
+ * outside the cone without reading it.
+ */
+class SparseCone {
+public:
+    /**
+     * @param directories The directories to check out in full, from the root
+     *        and without leading or trailing slashes, e.g. "src/utils". An
+     *        empty list keeps the files at the root only.
+     */
+    explicit SparseCone(const std::vector<std::string>& directories);
+
+    /**
+     * @brief Parses cone-mode patterns.
+     * @return The cone, or std::nullopt if a line is not one of the cone-mode forms.
+     */
+    static std::optional<SparseCone> parse(std::string_view patterns);
+
+    /**
+     * @brief Reads `.git/info/sparse-checkout`, whose presence turns sparse checkout on.
+     * @return The cone, or std::nullopt if the file does not exist.
+     * @throws std::runtime_error if the file is not in cone mode.
+     */
+    static std::optional<SparseCone> load();
+
+    /// @brief Writes the cone as Git's patterns to `.git/info/sparse-checkout`. Returns false on failure.
+    bool save() const;
+
+    /// @brief Returns the patterns, in the form Git writes them.
+    std::string toPatterns() const;
+
+    /// @brief Returns the directories checked out in full, sorted.
+    const std::set<std::string, std::less<>>& directories() const { return m_recursive; }
+
+    /// @brief Returns true if a walk must enter a directory, e.g. "src/utils", to find the files in the cone.
+    bool includesDirectory(std::string_view directory) const;
+
+    /// @brief Returns true if a file, e.g. "src/main.cpp", is checked out.
+    bool includesFile(std::string_view path) const;
+
+private:
+    SparseCone() = default;
+
+    // Returns true if the directory or one of its ancestors is checked out in full.
+    bool underRecursive(std::string_view directory) const;
+
+    std::set<std::string, std::less<>> m_recursive; // Directories checked out in full.
+    std::set<std::string, std::less<>> m_parents;   // Their ancestors: direct files only.
+};
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "mapped_file.h"
+#include "object_id.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/** @struct FileStat
+ *  @brief The subset of `stat()` that tells whether a file changed since it was hashed.
+ */
+struct FileStat {
+    int64_t ctimeSec = 0;
+    uint32_t ctimeNsec = 0;
+    int64_t mtimeSec = 0;
+    uint32_t mtimeNsec = 0;
+    uint64_t inode = 0;
+    uint64_t size = 0;
+    uint32_t mode = 0;
+
+    bool operator==(const FileStat&) const = default;
+};
+
+/**
+ * @brief Reads the stat data of a file.
+ * @return The file's stat data, or std::nullopt if it cannot be stat'ed.
+ */
+std::optional<FileStat> statFile(const std::filesystem::path& path);
+
+/**
+ * @class StatCache
+ * @brief A read-only view of `.git/stat-cache`, which lets write-tree skip unchanged files.
+ *
+ * Like Git's index, the cache records the stat data and blob SHA of every
+ * file seen by the last write-tree, plus the tree SHA of every directory
+ * (Git's "cache-tree"). A file whose stat data still matches is not read
+ * again; a directory whose entries all match reuses its tree SHA.
+ *
+ * The file is memory-mapped and only scanned once to build the path lookup.
+ * A file modified in the same instant as the cache was written cannot be
+ * told apart from its cached version, so such "racily clean" entries are
+ * never trusted.
+ */
+class StatCache {
+public:
+    /// @brief A directory's tree as recorded by the last write-tree.
+    struct CachedTree {
+        uint32_t entryCount;           ///< Number of entries of the tree object.
+        ObjectId sha;        ///< The tree's SHA-1.
+    };
+
+    /**
+     * @brief Maps and validates a cache file.
+     * @return The cache, or an empty cache if the file is missing or corrupt.
+     */
+    static StatCache load(const std::filesystem::path& path);
+
+    /**
+     * @brief Returns the cached blob SHA of a file if its stat data is unchanged.
+     * @param path The file's path relative to the working directory root, with '/' separators.
+     * @param stat The file's current stat data.
+     */
+    std::optional<ObjectId> findBlob(std::string_view path, const FileStat& stat) const;
+
+    /**
+     * @brief Returns the cached tree of a directory.
+     * @param path The directory's path relative to the root, with '/' separators; "" is the root.
+     */
+    std::optional<CachedTree> findTree(std::string_view path) const;
+
+private:
+    StatCache() = default;
+
+    std::optional<MappedFile> m_file;
+    std::unordered_map<std::string_view, const std::byte*> m_blobs; // Path -> record in the mapping.
+    std::unordered_map<std::string_view, const std::byte*> m_trees;
+    int64_t m_cacheMtimeSec = 0;
+    uint32_t m_cacheMtimeNsec = 0;
+};
+
+/**
+ * @class StatCacheWriter
+ * @brief Collects the state of a write-tree and saves it as a new `.git/stat-cache`.
+ */
+class StatCacheWriter {
+public:
+    /// @brief Records a file's stat data and blob SHA.
+    void addBlob(std::string path, const FileStat& stat, const ObjectId& sha);
+
+    /// @brief Records the tree written for a directory.
+    void addTree(std::string path, uint32_t entryCount, const ObjectId& sha);
+
+    /**
+     * @brief Writes the cache under a temporary name and renames it over `path`.
+     *
+     * Objects still pending under FsyncPolicy::Batch are flushed first (see
+     * flushObjectWrites()), so a cache never survives a crash that the
+     * objects it names did not. The cache itself is synced as the policy says.
+     * @return True on success, false if the file cannot be written.
+     */
+    bool write(const std::filesystem::path& path) const;
+
+private:
+    std::vector<std::byte> m_blobs;
+    std::vector<std::byte> m_trees;
+    uint32_t m_blobCount = 0;
+    uint32_t m_treeCount = 0;
+};
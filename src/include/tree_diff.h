@@ -0,0 +1,62 @@
+#pragma once
+#include "object_id.h"
+
+#include <functional>
+#include <optional>
+#include <string_view>
+
+/** @struct TreeChange
+ *  @brief One entry that differs between two trees.
+ */
+struct TreeChange {
+    char status;              ///< 'A' added, 'D' deleted, 'M' modified, 'T' changed type (e.g. file to symlink).
+    std::string_view path;    ///< The path from the root of the diff. Valid during the callback only.
+    std::string_view oldMode; ///< The mode on the old side as stored, e.g. "100644"; empty if added.
+    std::string_view newMode; ///< The mode on the new side; empty if deleted.
+    ObjectId oldId;           ///< The SHA on the old side; all zeros if added.
+    ObjectId newId;           ///< The SHA on the new side; all zeros if deleted.
+};
+
+/** @struct TreeDiffOptions
+ *  @brief Tunes a call to diffTrees().
+ */
+struct TreeDiffOptions {
+    bool recursive = true;  ///< Descend into subtrees that differ, instead of reporting them as one entry.
+    bool showTrees = false; ///< When recursive, also report the subtrees descended into.
+    /// When set and recursive, only the subtrees whose path it accepts are descended into;
+    /// any other changed subtree is reported as one entry, as without `recursive`.
+    std::function<bool(std::string_view path)> descendInto;
+};
+
+/// Receives each change in tree order. Returning false stops the diff.
+using TreeChangeCallback = std::function<bool(const TreeChange& change)>;
+
+/**
+ * @brief Compares two trees and reports the entries that differ.
+ *
+ * Both trees are walked side by side in Git's entry order. An entry with
+ * the same SHA and mode on both sides is skipped without being read, so a
+ * subtree that did not change is never descended, whatever its size. A
+ * name that is a file on one side and a directory on the other is reported
+ * as a deletion and an addition, as Git does.
+ *
+ * @param oldTree The old tree, or std::nullopt for an empty tree.
+ * @param newTree The new tree, or std::nullopt for an empty tree.
+ * @return False if the callback stopped the diff early.
+ * @throws std::runtime_error if a tree cannot be read.
+ */
+bool diffTrees(const std::optional<ObjectId>& oldTree, const std::optional<ObjectId>& newTree,
+               const TreeDiffOptions& options, const TreeChangeCallback& callback);
+
+/**
+ * @brief Returns true if a path, or anything below it, differs between two trees.
+ *
+ * Only the trees along the path are read, and the comparison stops at the
+ * first level where both sides hold the same SHA.
+ *
+ * @param oldTree The old tree, or std::nullopt for an empty tree.
+ * @param newTree The new tree, or std::nullopt for an empty tree.
+ * @param path A path from the root, e.g. "src/utils", without a trailing slash.
+ * @throws std::runtime_error if a tree cannot be read.
+ */
+bool pathDiffers(std::optional<ObjectId> oldTree, std::optional<ObjectId> newTree, std::string_view path);
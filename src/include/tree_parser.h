@@ -1,12 +1,95 @@
 #pragma once
-#include <string>
-#include <vector>
-#include "object_utils.h"
+#include "object_id.h"
+
+#include <cstddef>
+#include <iterator>
+#include <span>
+#include <string_view>
+
+/// @brief The kind of object a tree entry points to, derived from its mode.
+enum class TreeEntryType {
+    Blob,       ///< "100644", a regular file.
+    Executable, ///< "100755", an executable file.
+    Symlink,    ///< "120000", a symbolic link.
+    Tree,       ///< "40000", a subdirectory.
+    Submodule,  ///< "160000", a commit of another repository.
+    Unknown     ///< Any other mode.
+};
+
+/// @brief Classifies a tree entry mode such as "100644".
+TreeEntryType classifyTreeEntryMode(std::string_view mode);
+
+/** @struct TreeEntryView
+ *  @brief One entry of a tree object, pointing into the tree's inflated content.
+ *
+ *  Nothing is copied: the views stay valid as long as the tree's buffer does.
+ */
+struct TreeEntryView {
+    std::string_view mode;          ///< File mode as stored, e.g. "100644" or "40000".
+    std::string_view name;          ///< The name of the file or subdirectory.
+    std::span<const std::byte> sha; ///< The 20 raw bytes of the entry's SHA-1.
+    TreeEntryType type = TreeEntryType::Unknown; ///< The mode, classified.
+
+    /// @brief Copies the SHA out of the tree's buffer.
+    ObjectId id() const { return ObjectId::fromBytes(sha); }
+    bool isTree() const { return type == TreeEntryType::Tree; }
+};
 
 /**
- * @brief Parses the binary content of a Git tree object into a vector of TreeEntry structs.
- * 
- * @param treeContent A span representing the tree object's data (payload only, after the header).
- * @return A vector of TreeEntry structs, or std::nullopt if the content is malformed.
+ * @class TreeView
+ * @brief Iterates over the entries of a tree object without allocating.
+ *
+ * Each entry is "<mode> <name>\0<20-byte sha>". Entries are decoded one at a
+ * time as the iterator advances, with memchr() finding the separators.
+ * Malformed content (a missing separator or a truncated SHA) is reported
+ * when the iterator reaches it, by throwing std::runtime_error.
  */
-std::optional<std::vector<TreeEntry>> parseTreeObject(std::span<const std::byte> treeContent);
\ No newline at end of file
+class TreeView {
+public:
+    /// @param content The tree object's payload, after its "tree <size>\0" header.
+    explicit TreeView(std::span<const std::byte> content) : m_content(content) {}
+
+    class iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = TreeEntryView;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const TreeEntryView*;
+        using reference = const TreeEntryView&;
+
+        /// @brief The end iterator.
+        iterator() = default;
+
+        reference operator*() const { return m_entry; }
+        pointer operator->() const { return &m_entry; }
+
+        /// @throws std::runtime_error if the next entry is malformed.
+        iterator& operator++() {
+            advance();
+            return *this;
+        }
+        void operator++(int) { advance(); }
+
+        bool operator==(const iterator& other) const {
+            return m_atEnd == other.m_atEnd && (m_atEnd || m_rest.data() == other.m_rest.data());
+        }
+
+    private:
+        friend class TreeView;
+        explicit iterator(std::span<const std::byte> content) : m_rest(content), m_atEnd(false) { advance(); }
+
+        // Decodes the entry at the start of m_rest, or moves to the end if none is left.
+        void advance();
+
+        std::span<const std::byte> m_rest; // Content after the current entry.
+        TreeEntryView m_entry;
+        bool m_atEnd = true;
+    };
+
+    /// @throws std::runtime_error if the first entry is malformed.
+    iterator begin() const { return iterator(m_content); }
+    iterator end() const { return iterator(); }
+
+private:
+    std::span<const std::byte> m_content;
+};
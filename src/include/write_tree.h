@@ -1,19 +1,54 @@
 #pragma once
+#include "object_id.h"
+
 #include <vector>
 #include <filesystem>
 #include <optional>
 
+class StatCache;
+class StatCacheWriter;
+
 /**
  * @brief Handles the 'write-tree' command.
  * Creates a tree object from the current directory state.
  */
 int handleWriteTree(int argc, char* argv[]);
 
+/** @struct WriteTreeOptions
+ *  @brief Tunes a call to writeTreeFromDirectory().
+ */
+struct WriteTreeOptions {
+    unsigned int numThreads = 1;             ///< Number of threads that hash and compress objects.
+    const StatCache* cache = nullptr;        ///< If set, unchanged files and directories reuse their cached SHA.
+    StatCacheWriter* cacheWriter = nullptr;  ///< If set, receives the state of every file and directory.
+};
+
+/** @struct WriteTreeStats
+ *  @brief What a call to writeTreeFromDirectory() hashed.
+ */
+struct WriteTreeStats {
+    size_t files = 0;        ///< Number of regular files in the tree.
+    size_t hashedFiles = 0;  ///< Number of files read and hashed, i.e. not found in the cache.
+    size_t writtenTrees = 0; ///< Number of tree objects written, the root included.
+};
+
 /**
  * @brief Recursively creates a tree object from a directory's contents.
- * For each entry, it either creates a blob (for files) or recursively
- * calls itself (for subdirectories), then constructs and writes a tree object.
+ *
+ * The directory is listed first. Every file is then turned into a blob on a
+ * pool of threads, and the trees are written bottom-up once the SHAs of all
+ * their children are known. Entries are sorted by name, so the resulting SHA
+ * does not depend on the number of threads.
+ *
+ * With a stat cache, a file whose stat data is unchanged is not read, and a
+ * directory with no change below it keeps its cached tree SHA. The cache
+ * paths are relative to `dirPath`, which should be the working directory root.
+ *
  * @param dirPath The directory to create a tree from.
- * @return The 20-byte raw SHA-1 hash of the created tree object, or std::nullopt on failure.
+ * @param options The thread count and the optional stat cache to read and fill.
+ * @param stats If not null, receives the number of files hashed and trees written.
+ * @return The SHA-1 of the created tree object, or std::nullopt on failure.
  */
-std::optional<std::vector<std::byte>> writeTreeFromDirectory(const std::filesystem::path& dirPath);
\ No newline at end of file
+std::optional<ObjectId> writeTreeFromDirectory(const std::filesystem::path& dirPath,
+                                               const WriteTreeOptions& options = {},
+                                               WriteTreeStats* stats = nullptr);
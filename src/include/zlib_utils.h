@@ -2,10 +2,16 @@
 #include <vector>
 #include <string>
 #include <span>
+#include <functional>
+#include <memory>
+
+struct z_stream_s; // zlib's z_stream, kept out of this header.
 
 /**
  * @brief Decompresses a zlib-compressed data span.
- * This function handles dynamically resizing the output buffer to fit the decompressed data.
+ * The output buffer grows as needed while inflating; there is no size limit.
+ * When the decompressed size is known up front, ZlibInflateStream avoids
+ * the reallocations.
  * @param input The compressed data.
  * @param output A vector that will be cleared and filled with the decompressed data.
  * @return True on success, false if a zlib error occurs.
@@ -18,4 +24,77 @@ bool decompressZlib(std::span<const std::byte> input, std::vector<std::byte>& ou
  * @param output A vector that will be cleared and filled with the compressed data.
  * @return True on success, false if a zlib error occurs.
  */
-bool compressZlib(std::span<const std::byte> input, std::vector<std::byte>& output);
\ No newline at end of file
+bool compressZlib(std::span<const std::byte> input, std::vector<std::byte>& output);
+
+/**
+ * @class ZlibDeflateStream
+ * @brief Compresses data that arrives in pieces, with a fixed-size output buffer.
+ *
+ * Every time the output buffer fills up, its content is handed to the sink,
+ * so memory use does not depend on the size of the data. The output is the
+ * same as compressZlib() would produce for the whole input at once.
+ */
+class ZlibDeflateStream {
+public:
+    /// @brief Receives the next bytes of compressed output.
+    using Sink = std::function<void(std::span<const std::byte> compressed)>;
+
+    /// @throws std::runtime_error if zlib cannot be initialized.
+    explicit ZlibDeflateStream(Sink sink);
+    ~ZlibDeflateStream();
+    ZlibDeflateStream(const ZlibDeflateStream&) = delete;
+    ZlibDeflateStream& operator=(const ZlibDeflateStream&) = delete;
+
+    /// @brief Compresses the next bytes of input. @throws std::runtime_error on a zlib error.
+    void write(std::span<const std::byte> data);
+
+    /// @brief Flushes the end of the stream to the sink. @throws std::runtime_error on a zlib error.
+    void finish();
+
+private:
+    // Runs deflate over `data` with the given flush mode, draining the output into the sink.
+    void deflateInto(std::span<const std::byte> data, int flush);
+
+    Sink m_sink;
+    std::vector<std::byte> m_out;           // Output buffer handed to the sink when full.
+    std::unique_ptr<z_stream_s> m_zstream;
+};
+
+/**
+ * @class ZlibInflateStream
+ * @brief Decompresses an in-memory zlib stream into buffers chosen by the caller.
+ *
+ * The caller decides where each piece of output goes: a small buffer to
+ * peek at a header, the exact final buffer, or a reused chunk streamed
+ * elsewhere. The input is either one span or pulled from a source as
+ * needed, so neither side has to be held in memory at once.
+ */
+class ZlibInflateStream {
+public:
+    /// @brief Returns the next piece of compressed input, or an empty span once there is none left.
+    using InputSource = std::function<std::span<const std::byte>()>;
+
+    /// @throws std::runtime_error if zlib cannot be initialized.
+    explicit ZlibInflateStream(std::span<const std::byte> input);
+
+    /// @throws std::runtime_error if zlib cannot be initialized.
+    explicit ZlibInflateStream(InputSource source);
+    ~ZlibInflateStream();
+    ZlibInflateStream(const ZlibInflateStream&) = delete;
+    ZlibInflateStream& operator=(const ZlibInflateStream&) = delete;
+
+    /**
+     * @brief Inflates into `out` until it is full or the stream ends.
+     * @return The number of bytes written to `out`; less than its size only at the end of the stream.
+     * @throws std::runtime_error if the data is corrupt or truncated.
+     */
+    size_t read(std::span<std::byte> out);
+
+    /// @brief Returns true once the end of the zlib stream has been reached.
+    bool finished() const { return m_finished; }
+
+private:
+    InputSource m_source;
+    std::unique_ptr<z_stream_s> m_zstream;
+    bool m_finished = false;
+};
@@ -1,5 +1,6 @@
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <zlib.h>
 #include <vector>
 #include <iterator>
@@ -13,25 +14,18 @@
 #include "include/write_tree.h"
 #include "include/commit_tree.h"
 #include "include/clone.h"
+#include "include/index_pack.h"
+#include "include/commit_graph.h"
+#include "include/rev_list.h"
+#include "include/log.h"
+#include "include/diff_tree.h"
+#include "include/checkout.h"
+#include "include/sparse_checkout.h"
+#include "include/object_utils.h"
+#include "include/size_utils.h"
 
-/**
- * @brief Main entry point for the mygit application.
- * 
- * This function acts as a command dispatcher, parsing the first argument
- * to determine which Git command to execute and forwarding the arguments
- * to the appropriate handler.
- */
-int main(int argc, char* argv[]) {
-    // Ensure that cout/cerr flush immediately. This is crucial for debugging
-    // and for predictable output when the program is used in scripts.
-    std::cout << std::unitbuf;
-    std::cerr << std::unitbuf;
-
-    if (argc < 2) {
-        std::cerr << "Usage: mygit <command> [<args>...]\n";
-        return EXIT_FAILURE;
-    }
-
+// Runs the handler of `argv[1]`.
+static int runCommand(int argc, char* argv[]) {
     const std::string command = argv[1];
 
     if (command == "init") {
@@ -55,8 +49,85 @@ int main(int argc, char* argv[]) {
     if (command == "clone") {
         return handleClone(argc, argv);
     }
+    if (command == "index-pack") {
+        return handleIndexPack(argc, argv);
+    }
+    if (command == "commit-graph") {
+        return handleCommitGraph(argc, argv);
+    }
+    if (command == "rev-list") {
+        return handleRevList(argc, argv);
+    }
+    if (command == "log") {
+        return handleLog(argc, argv);
+    }
+    if (command == "diff-tree") {
+        return handleDiffTree(argc, argv);
+    }
+    if (command == "checkout") {
+        return handleCheckout(argc, argv);
+    }
+    if (command == "sparse-checkout") {
+        return handleSparseCheckout(argc, argv);
+    }
 
     std::cerr << "Unknown command: " << command << "\n";
     return EXIT_FAILURE;
 }
 
+/**
+ * @brief Main entry point for the mygit application.
+ * 
+ * This function acts as a command dispatcher, parsing the first argument
+ * to determine which Git command to execute and forwarding the arguments
+ * to the appropriate handler.
+ */
+int main(int argc, char* argv[]) {
+    // Ensure that cout/cerr flush immediately. This is crucial for debugging
+    // and for predictable output when the program is used in scripts.
+    std::cout << std::unitbuf;
+    std::cerr << std::unitbuf;
+
+    // Options before the command apply to the whole process. Handlers then
+    // see their arguments at the usual positions.
+    while (argc >= 2 && std::string_view(argv[1]).starts_with("--")) {
+        const std::string_view option = argv[1];
+        const std::string_view value = option.substr(option.find('=') + 1);
+        if (option.starts_with("--object-cache-size=")) {
+            auto size = parseByteSize(value);
+            if (!size) {
+                std::cerr << "Invalid object cache size: " << option << "\n";
+                return EXIT_FAILURE;
+            }
+            objectCache().setMaxBytes(*size);
+        } else if (option.starts_with("--fsync=")) {
+            auto policy = parseFsyncPolicy(value);
+            if (!policy) {
+                std::cerr << "Invalid fsync policy: " << option << " (expected none, per-object or batch)\n";
+                return EXIT_FAILURE;
+            }
+            setFsyncPolicy(*policy);
+        } else {
+            break;
+        }
+        ++argv;
+        --argc;
+    }
+
+    if (argc < 2) {
+        std::cerr << "Usage: mygit [--object-cache-size=<n>[k|m|g]] [--fsync=none|per-object|batch] <command> [<args>...]\n";
+        return EXIT_FAILURE;
+    }
+
+    int status = runCommand(argc, argv);
+
+    // Under --fsync=batch, the objects written by the command become durable
+    // with one sync here, and only then get their final names.
+    try {
+        flushObjectWrites();
+    } catch (const std::exception& e) {
+        std::cerr << "Fatal: " << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+    return status;
+}
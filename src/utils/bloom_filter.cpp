@@ -0,0 +1,118 @@
+#include "../include/bloom_filter.h"
+
+#include <algorithm>
+#include <bit>
+#include <unordered_set>
+
+namespace {
+    constexpr uint32_t SEED_0 = 0x293ae76f;
+    constexpr uint32_t SEED_1 = 0x7e646e2c;
+
+    // Reads a byte the way Git's version 1 does: as a sign-extended char.
+    uint32_t signedByte(char c) {
+        return static_cast<uint32_t>(static_cast<int32_t>(static_cast<signed char>(c)));
+    }
+
+    uint32_t bitCount(std::span<const std::byte> filter) {
+        return static_cast<uint32_t>(filter.size() * 8);
+    }
+}
+
+uint32_t murmur3SeededV1(uint32_t seed, std::string_view data) {
+    constexpr uint32_t c1 = 0xcc9e2d51;
+    constexpr uint32_t c2 = 0x1b873593;
+    constexpr uint32_t m = 5;
+    constexpr uint32_t n = 0xe6546b64;
+
+    const size_t blocks = data.size() / 4;
+    for (size_t i = 0; i < blocks; ++i) {
+        uint32_t k = signedByte(data[4 * i]) | (signedByte(data[4 * i + 1]) << 8) |
+                     (signedByte(data[4 * i + 2]) << 16) | (signedByte(data[4 * i + 3]) << 24);
+        k *= c1;
+        k = std::rotl(k, 15);
+        k *= c2;
+        seed ^= k;
+        seed = std::rotl(seed, 13) * m + n;
+    }
+
+    const std::string_view tail = data.substr(blocks * 4);
+    uint32_t k1 = 0;
+    switch (tail.size()) {
+        case 3: k1 ^= signedByte(tail[2]) << 16; [[fallthrough]];
+        case 2: k1 ^= signedByte(tail[1]) << 8; [[fallthrough]];
+        case 1:
+            k1 ^= signedByte(tail[0]);
+            k1 *= c1;
+            k1 = std::rotl(k1, 15);
+            k1 *= c2;
+            seed ^= k1;
+            break;
+        default: break;
+    }
+
+    seed ^= static_cast<uint32_t>(data.size());
+    seed ^= seed >> 16;
+    seed *= 0x85ebca6b;
+    seed ^= seed >> 13;
+    seed *= 0xc2b2ae35;
+    seed ^= seed >> 16;
+    return seed;
+}
+
+BloomKey::BloomKey(std::string_view path, const BloomSettings& settings) {
+    // Double hashing: the i-th position is h0 + i * h1.
+    const uint32_t hash0 = murmur3SeededV1(SEED_0, path);
+    const uint32_t hash1 = murmur3SeededV1(SEED_1, path);
+    m_hashes.reserve(settings.numHashes);
+    for (uint32_t i = 0; i < settings.numHashes; ++i) {
+        m_hashes.push_back(hash0 + i * hash1);
+    }
+}
+
+void BloomKey::addTo(std::span<std::byte> filter) const {
+    const uint32_t bits = bitCount(filter);
+    for (uint32_t hash : m_hashes) {
+        const uint32_t bit = hash % bits;
+        filter[bit / 8] |= static_cast<std::byte>(1u << (bit % 8));
+    }
+}
+
+bool BloomKey::mayBeIn(std::span<const std::byte> filter) const {
+    const uint32_t bits = bitCount(filter);
+    if (bits == 0) {
+        return true;
+    }
+    for (uint32_t hash : m_hashes) {
+        const uint32_t bit = hash % bits;
+        if ((filter[bit / 8] & static_cast<std::byte>(1u << (bit % 8))) == std::byte{0}) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<std::byte> buildChangedPathFilter(const std::vector<std::string>& paths, const BloomSettings& settings) {
+    std::unordered_set<std::string_view> entries;
+    if (paths.size() <= settings.maxChangedPaths) {
+        for (std::string_view path : paths) {
+            // "a/b/c" also adds "a/b" and "a".
+            while (entries.insert(path).second) {
+                const size_t slash = path.rfind('/');
+                if (slash == std::string_view::npos) {
+                    break;
+                }
+                path = path.substr(0, slash);
+            }
+        }
+    }
+    if (paths.size() > settings.maxChangedPaths || entries.size() > settings.maxChangedPaths) {
+        return {std::byte{0xFF}};
+    }
+
+    const size_t size = std::max<size_t>((entries.size() * settings.bitsPerEntry + 7) / 8, 1);
+    std::vector<std::byte> filter(size);
+    for (std::string_view entry : entries) {
+        BloomKey(entry, settings).addTo(filter);
+    }
+    return filter;
+}
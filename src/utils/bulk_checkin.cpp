@@ -0,0 +1,246 @@
+#include "../include/bulk_checkin.h"
+#include "../include/constants.h"
+#include "../include/mapped_file.h"
+#include "../include/object_utils.h"
+#include "../include/pack_store.h"
+#include "../include/sha1_utils.h"
+#include "../include/zlib_utils.h"
+
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+    constexpr size_t PACK_HEADER_SIZE = 12;
+    constexpr size_t MAX_ENTRY_HEADER_SIZE = 10;
+    constexpr size_t WRITE_BLOCK_SIZE = 1024 * 1024;
+    constexpr size_t STREAM_CHUNK_SIZE = 64 * 1024;
+
+    BulkCheckin* g_active = nullptr;
+
+    void writeAll(int fd, std::span<const std::byte> data, const std::filesystem::path& path) {
+        while (!data.empty()) {
+            ssize_t written = ::write(fd, data.data(), data.size());
+            if (written < 0) {
+                throw std::runtime_error("cannot write " + path.string());
+            }
+            data = data.subspan(static_cast<size_t>(written));
+        }
+    }
+
+    uint32_t updateCrc(uint32_t crc, std::span<const std::byte> data) {
+        return static_cast<uint32_t>(::crc32(crc, reinterpret_cast<const Bytef*>(data.data()), static_cast<uInt>(data.size())));
+    }
+}
+
+BulkCheckin::BulkCheckin() {
+    if (g_active) {
+        throw std::logic_error("a bulk checkin is already active");
+    }
+    std::filesystem::create_directories(constants::PACK_DIR);
+    std::string tmpName = (constants::PACK_DIR / "tmp_pack_XXXXXX").string();
+    m_fd = mkstemp(tmpName.data());
+    if (m_fd < 0) {
+        throw std::runtime_error("cannot create a temporary pack in " + constants::PACK_DIR.string());
+    }
+    m_tmpPath = tmpName;
+    fchmod(m_fd, 0444); // Packs are immutable, like loose objects.
+
+    // The object count is not known yet; commit() fills it in.
+    const std::array<std::byte, PACK_HEADER_SIZE> header{
+        std::byte{'P'}, std::byte{'A'}, std::byte{'C'}, std::byte{'K'},
+        std::byte{0}, std::byte{0}, std::byte{0}, std::byte{2},
+        std::byte{0}, std::byte{0}, std::byte{0}, std::byte{0}};
+    appendLocked(header);
+    g_active = this;
+}
+
+BulkCheckin::~BulkCheckin() {
+    if (g_active == this) {
+        g_active = nullptr;
+    }
+    if (m_fd >= 0) {
+        ::close(m_fd);
+    }
+    if (!m_committed) {
+        std::error_code ec;
+        std::filesystem::remove(m_tmpPath, ec);
+    }
+}
+
+BulkCheckin* BulkCheckin::active() {
+    return g_active;
+}
+
+ObjectId BulkCheckin::add(std::span<const std::byte> object) {
+    auto nullPos = findNullSeparator(object);
+    auto spacePos = std::find(object.begin(), nullPos, std::byte{' '});
+    auto type = nullPos == object.end() ? std::nullopt
+        : typeFromName(std::string_view(reinterpret_cast<const char*>(object.data()), std::distance(object.begin(), spacePos)));
+    if (!type) {
+        throw std::runtime_error("cannot pack an object without a valid header");
+    }
+    const auto content = object.subspan(std::distance(object.begin(), nullPos) + 1);
+
+    const ObjectId id = calculateSha1(object);
+    {
+        std::lock_guard lock(m_mutex);
+        if (knownLocked(id)) {
+            return id;
+        }
+    }
+
+    // The entry is built and compressed outside the lock, so writers only
+    // queue up for the append itself.
+    std::vector<std::byte> entry(MAX_ENTRY_HEADER_SIZE);
+    entry.resize(writePackEntryHeader(*type, content.size(), entry.data()));
+    std::vector<std::byte> compressed;
+    if (!compressZlib(content, compressed)) {
+        throw std::runtime_error("cannot compress object " + id.toHex());
+    }
+    entry.insert(entry.end(), compressed.begin(), compressed.end());
+
+    std::lock_guard lock(m_mutex);
+    if (knownLocked(id)) {
+        return id; // Another thread added the same content meanwhile.
+    }
+    m_objects.push_back({id, *type, content.size(), entry.size(), m_offset, updateCrc(0, entry), {}, 0});
+    m_ids.insert(id);
+    appendLocked(entry);
+    return id;
+}
+
+ObjectId BulkCheckin::addStreamed(std::string_view type, uint64_t size, const ContentSource& source) {
+    auto packType = typeFromName(type);
+    if (!packType) {
+        throw std::runtime_error("cannot pack an object of type " + std::string(type));
+    }
+
+    std::lock_guard lock(m_mutex);
+    const uint64_t start = m_offset;
+    uint32_t crc = 0;
+    auto appendEntry = [&](std::span<const std::byte> data) {
+        crc = updateCrc(crc, data);
+        appendLocked(data);
+    };
+
+    std::array<std::byte, MAX_ENTRY_HEADER_SIZE> entryHeader;
+    appendEntry(std::span(entryHeader).first(writePackEntryHeader(*packType, size, entryHeader.data())));
+
+    Sha1Hasher hasher;
+    std::string header = std::string(type) + " " + std::to_string(size) + '\0';
+    hasher.update(std::as_bytes(std::span{header}));
+
+    ZlibDeflateStream deflater(appendEntry);
+    std::vector<std::byte> chunk(STREAM_CHUNK_SIZE);
+    uint64_t total = 0;
+    try {
+        while (size_t read = source(chunk)) {
+            total += read;
+            hasher.update(std::span(chunk).first(read));
+            deflater.write(std::span(chunk).first(read));
+        }
+        if (total != size) {
+            throw std::runtime_error("object content is " + std::to_string(total) + " bytes, expected " +
+                                     std::to_string(size));
+        }
+        deflater.finish();
+    } catch (...) {
+        truncateLocked(start);
+        throw;
+    }
+
+    const ObjectId id = hasher.finish();
+    if (knownLocked(id)) {
+        truncateLocked(start);
+        return id;
+    }
+    m_objects.push_back({id, *packType, size, static_cast<size_t>(m_offset - start), start, crc, {}, 0});
+    m_ids.insert(id);
+    return id;
+}
+
+size_t BulkCheckin::commit() {
+    std::lock_guard lock(m_mutex);
+    g_active = nullptr;
+    flushLocked();
+    if (m_objects.empty()) {
+        return 0; // The destructor removes the empty temporary pack.
+    }
+
+    // Now that the count is known, patch it into the header and checksum the whole pack.
+    const uint32_t count = static_cast<uint32_t>(m_objects.size());
+    const std::array<std::byte, 4> countBytes{
+        static_cast<std::byte>(count >> 24), static_cast<std::byte>(count >> 16),
+        static_cast<std::byte>(count >> 8), static_cast<std::byte>(count)};
+    if (::pwrite(m_fd, countBytes.data(), countBytes.size(), 8) != static_cast<ssize_t>(countBytes.size())) {
+        throw std::runtime_error("cannot write " + m_tmpPath.string());
+    }
+    ObjectId checksum;
+    {
+        auto pack = MappedFile::open(m_tmpPath);
+        if (!pack) {
+            throw std::runtime_error("cannot read back " + m_tmpPath.string());
+        }
+        checksum = calculateSha1(pack->bytes());
+    }
+    writeAll(m_fd, checksum.span(), m_tmpPath);
+    if (fsyncPolicy() != FsyncPolicy::None && ::fsync(m_fd) != 0) {
+        throw std::runtime_error("cannot sync " + m_tmpPath.string());
+    }
+    if (::close(std::exchange(m_fd, -1)) != 0) {
+        throw std::runtime_error("cannot write " + m_tmpPath.string());
+    }
+
+    // Like clone, the index is written last under a temporary name: a pack
+    // only becomes visible to readers once its .idx exists.
+    const std::string packName = "pack-" + checksum.toHex();
+    const std::filesystem::path tmpIdxPath = m_tmpPath.string() + "_idx";
+    std::filesystem::rename(m_tmpPath, constants::PACK_DIR / (packName + ".pack"));
+    m_committed = true;
+    if (!writePackIndex(tmpIdxPath, m_objects, checksum.span())) {
+        std::error_code ec;
+        std::filesystem::remove(tmpIdxPath, ec);
+        throw std::runtime_error("cannot write " + tmpIdxPath.string());
+    }
+    syncFileForPolicy(tmpIdxPath);
+    std::filesystem::rename(tmpIdxPath, constants::PACK_DIR / (packName + ".idx"));
+    reloadPacks();
+    return m_objects.size();
+}
+
+bool BulkCheckin::knownLocked(const ObjectId& id) const {
+    return m_ids.contains(id) || hasObject(id);
+}
+
+void BulkCheckin::appendLocked(std::span<const std::byte> data) {
+    m_buffer.insert(m_buffer.end(), data.begin(), data.end());
+    m_offset += data.size();
+    if (m_buffer.size() >= WRITE_BLOCK_SIZE) {
+        flushLocked();
+    }
+}
+
+void BulkCheckin::flushLocked() {
+    writeAll(m_fd, m_buffer, m_tmpPath);
+    m_flushed += m_buffer.size();
+    m_buffer.clear();
+}
+
+void BulkCheckin::truncateLocked(uint64_t offset) {
+    if (offset >= m_flushed) {
+        m_buffer.resize(static_cast<size_t>(offset - m_flushed));
+    } else {
+        m_buffer.clear();
+        if (::ftruncate(m_fd, static_cast<off_t>(offset)) != 0 || ::lseek(m_fd, static_cast<off_t>(offset), SEEK_SET) < 0) {
+            throw std::runtime_error("cannot truncate " + m_tmpPath.string());
+        }
+        m_flushed = offset;
+    }
+    m_offset = offset;
+}
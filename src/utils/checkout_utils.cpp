@@ -1,60 +1,250 @@
 #include "../include/checkout_utils.h"
+#include "../include/commit_parser.h"
 #include "../include/object_utils.h"
 #include "../include/tree_parser.h"
-#include "../include/sha1_utils.h"
+#include "../include/tree_diff.h"
+#include "../include/parallel_utils.h"
 #include "../include/constants.h"
+#include "../include/mapped_file.h"
+#include "../include/sha1_utils.h"
+#include "../include/sparse_checkout.h"
 
 #include <iostream>
 #include <fstream>
 #include <vector>
 #include <string>
+#include <string_view>
 #include <optional>
-#include <regex>
 #include <iterator>
+#include <stdexcept>
+#include <algorithm>
+
+/** @struct CheckoutEntry
+ *  @brief A blob to write, collected while walking the trees of a commit.
+ */
+struct CheckoutEntry {
+    std::filesystem::path path; ///< Destination of the file in the working directory.
+    ObjectId blobSha;           ///< SHA of the blob holding its content.
+    TreeEntryType type;         ///< Blob, Executable or Symlink.
+};
 
-/// Forward declaration for the recursive helper function.
-static bool checkoutTree(const std::string& treeSha, const std::filesystem::path& currentPath, int depth);
+/// Forward declarations for the helpers below.
+static bool isCheckedOut(TreeEntryType type);
+static bool collectTree(const ObjectId& treeSha, const std::filesystem::path& currentPath,
+                        std::string& relativePath, const SparseCone* cone, std::vector<CheckoutEntry>& entries);
+static void writeBlob(const CheckoutEntry& entry);
+static bool holdsBlob(const std::filesystem::path& path, const ObjectId& blobSha, TreeEntryType type);
+static void removeEmptyParents(const std::filesystem::path& targetDir, std::string_view path);
+static bool replaceFiles(const std::filesystem::path& targetDir, const std::vector<std::string>& removals,
+                         const std::vector<CheckoutEntry>& writes, unsigned int numWorkers);
 
 // Entry point for checking out a commit.
-bool checkoutCommit(const std::string& commitSha, const std::filesystem::path& targetDir) {
+bool checkoutCommit(const ObjectId& commitId, const std::filesystem::path& targetDir, unsigned int numWorkers,
+                    const SparseCone* cone) {
     // 1. Read the commit object to find its root tree.
-    auto commitDataOpt = readGitObject(commitSha);
+    auto commitDataOpt = readCachedGitObject(commitId);
     if (!commitDataOpt) {
-        std::cerr << "Fatal: Could not read commit object " << commitSha << "\n";
+        std::cerr << "Fatal: Could not read commit object " << commitId.toHex() << "\n";
         return false;
     }
 
-    // 2. Parse the commit content to extract the root tree's SHA.
-    // The tree is specified on a line like "tree <sha>".
-    std::string commitContent(reinterpret_cast<const char*>(commitDataOpt->data()), commitDataOpt->size());
-    std::smatch match;
-    std::regex treeRegex(R"(tree ([0-9a-fA-F]{40}))");
-    
-    if (!std::regex_search(commitContent, match, treeRegex) || match.size() < 2) {
-        std::cerr << "Fatal: Could not find tree SHA in commit " << commitSha << "\n";
+    // 2. Parse the commit to find its root tree.
+    auto parts = splitObject(*commitDataOpt);
+    auto commit = parts && parts->first == "commit" ? parseCommit(parts->second) : std::nullopt;
+    if (!commit) {
+        std::cerr << "Fatal: Could not find tree SHA in commit " << commitId.toHex() << "\n";
         return false;
     }
-    std::string rootTreeSha = match[1].str();
     
-    // 3. Delegate to the recursive helper to write the tree's contents to disk.
-    return checkoutTree(rootTreeSha, targetDir, 0);
+    // 3. Walk the trees on this thread: create every directory and list the
+    // blobs to write. Trees are small and few compared to blobs, and those
+    // outside a sparse cone are not even read.
+    std::vector<CheckoutEntry> entries;
+    std::string relativePath;
+    if (!collectTree(commit->tree, targetDir, relativePath, cone, entries)) {
+        return false;
+    }
+
+    // 4. Inflate and write the blobs on the worker pool. Each file is written
+    // by exactly one worker and its directory already exists, so the
+    // workers share nothing but the object store.
+    try {
+        parallelFor(entries.size(), numWorkers, [&](size_t i) { writeBlob(entries[i]); });
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return false;
+    }
+    return true;
+}
+
+// Entry point for moving a working directory between two trees.
+bool checkoutTreeChanges(const std::optional<ObjectId>& fromTree, const ObjectId& toTree,
+                         const std::filesystem::path& targetDir, unsigned int numWorkers, bool force,
+                         const SparseCone* cone) {
+    // 1. Diff the trees. Unchanged subtrees, and those outside a sparse
+    // cone, are skipped without being read, so this only visits the paths
+    // that differ.
+    TreeDiffOptions options;
+    if (cone) {
+        options.descendInto = [cone](std::string_view path) { return cone->includesDirectory(path); };
+    }
+    std::vector<std::string> removals;     // Old files to unlink, in tree order.
+    std::vector<CheckoutEntry> writes;     // New files to write, in tree order.
+    std::vector<std::string> modified;     // Local changes that would be lost.
+    std::vector<std::string> untracked;    // Untracked files in the way of new ones.
+    std::vector<std::string> occupiedDirs; // Directories where new files go.
+    try {
+        diffTrees(fromTree, toTree, options, [&](const TreeChange& change) {
+            if (cone && !cone->includesFile(change.path)) {
+                return true; // Neither side is in the working directory.
+            }
+            const TreeEntryType oldType = change.oldMode.empty() ? TreeEntryType::Unknown : classifyTreeEntryMode(change.oldMode);
+            const TreeEntryType newType = change.newMode.empty() ? TreeEntryType::Unknown : classifyTreeEntryMode(change.newMode);
+            const std::filesystem::path path = targetDir / change.path;
+            if (isCheckedOut(oldType)) {
+                if (!force && !holdsBlob(path, change.oldId, oldType)) {
+                    modified.emplace_back(change.path);
+                }
+                // A file that stays a file is replaced when it is written.
+                if (!isCheckedOut(newType)) {
+                    removals.emplace_back(change.path);
+                }
+            } else if (isCheckedOut(newType) && !force) {
+                // Something already there is only safe to replace if it is
+                // the very same file, or a directory this checkout empties.
+                std::error_code ec;
+                const auto status = std::filesystem::symlink_status(path, ec);
+                if (std::filesystem::is_directory(status)) {
+                    occupiedDirs.emplace_back(change.path);
+                } else if (std::filesystem::exists(status) && !holdsBlob(path, change.newId, newType)) {
+                    untracked.emplace_back(change.path);
+                }
+            }
+            if (isCheckedOut(newType)) {
+                writes.push_back({path, change.newId, newType});
+            }
+            return true;
+        });
+    } catch (const std::exception& e) {
+        std::cerr << "Fatal: " << e.what() << "\n";
+        return false;
+    }
+
+    // A directory is in the way unless the old tree had files in it. Those
+    // come after the new file in tree order ("x" sorts before "x/"), so this
+    // is checked once the diff is complete. Removals are in tree order.
+    for (const std::string& dir : occupiedDirs) {
+        const std::string prefix = dir + '/';
+        auto it = std::ranges::lower_bound(removals, prefix);
+        if (it == removals.end() || !it->starts_with(prefix)) {
+            untracked.push_back(dir);
+        }
+    }
+
+    // 2. Refuse before touching anything if a file would be lost, as Git does.
+    if (!modified.empty() || !untracked.empty()) {
+        if (!modified.empty()) {
+            std::cerr << "error: Your local changes to the following files would be overwritten by checkout:\n";
+            for (const std::string& path : modified) {
+                std::cerr << "\t" << path << "\n";
+            }
+        }
+        if (!untracked.empty()) {
+            std::cerr << "error: The following untracked working tree files would be overwritten by checkout:\n";
+            for (const std::string& path : untracked) {
+                std::cerr << "\t" << path << "\n";
+            }
+        }
+        std::cerr << "Aborting\n";
+        return false;
+    }
+
+    // 3. Remove the old files, then write the new ones.
+    return replaceFiles(targetDir, removals, writes, numWorkers);
+}
+
+// Entry point for changing the sparse cone of a checked-out tree.
+bool applySparseCone(const ObjectId& tree, const SparseCone* oldCone, const SparseCone* newCone,
+                     const std::filesystem::path& targetDir, unsigned int numWorkers) {
+    // 1. List the tree against nothing, entering only the directories that
+    // either cone includes. A file changes state if exactly one cone has it.
+    const auto includesFile = [](const SparseCone* cone, std::string_view path) {
+        return !cone || cone->includesFile(path);
+    };
+    TreeDiffOptions options;
+    options.descendInto = [&](std::string_view path) {
+        return !oldCone || !newCone || oldCone->includesDirectory(path) || newCone->includesDirectory(path);
+    };
+    std::vector<std::string> removals;  // Files leaving the cone.
+    std::vector<CheckoutEntry> writes;  // Files entering it.
+    std::vector<std::string> modified;  // Files leaving the cone with local changes, which are kept.
+    std::vector<std::string> untracked; // Untracked files in the way of new ones.
+    try {
+        diffTrees(std::nullopt, tree, options, [&](const TreeChange& change) {
+            const TreeEntryType type = classifyTreeEntryMode(change.newMode);
+            const bool before = includesFile(oldCone, change.path);
+            const bool after = includesFile(newCone, change.path);
+            if (!isCheckedOut(type) || before == after) {
+                return true;
+            }
+            const std::filesystem::path path = targetDir / change.path;
+            if (!holdsBlob(path, change.newId, type)) {
+                (before ? modified : untracked).emplace_back(change.path);
+            } else if (before) {
+                removals.emplace_back(change.path);
+            } else {
+                writes.push_back({path, change.newId, type});
+            }
+            return true;
+        });
+    } catch (const std::exception& e) {
+        std::cerr << "Fatal: " << e.what() << "\n";
+        return false;
+    }
+
+    // 2. Refuse to overwrite an untracked file, as checkout does. A file
+    // with local changes is only left in place, as Git does.
+    if (!untracked.empty()) {
+        std::cerr << "error: The following untracked working tree files would be overwritten by checkout:\n";
+        for (const std::string& path : untracked) {
+            std::cerr << "\t" << path << "\n";
+        }
+        std::cerr << "Aborting\n";
+        return false;
+    }
+    if (!modified.empty()) {
+        std::cerr << "warning: The following paths are not up to date and were left despite sparse patterns:\n";
+        for (const std::string& path : modified) {
+            std::cerr << "\t" << path << "\n";
+        }
+    }
+
+    // 3. Remove the files leaving the cone, then write the ones entering it.
+    return replaceFiles(targetDir, removals, writes, numWorkers);
 }
 
 /**
- * @brief Recursively checks out the contents of a single tree object.
+ * @brief Recursively lists the blobs of a single tree object.
  *
- * This function iterates through a tree's entries. For each blob, it writes
- * the file. For each sub-tree, it creates the directory and calls itself.
+ * This function iterates through a tree's entries. For each sub-tree, it
+ * creates the directory and calls itself. For each blob, it records the
+ * destination path so the blob can be written later. With a sparse cone,
+ * sub-trees and blobs outside it are skipped.
  *
  * @param treeSha The SHA of the tree to process.
- * @param currentPath The directory to write the tree's contents into.
- * @param depth Current recursion depth, used for logging indentation.
+ * @param currentPath The directory the tree's contents belong to.
+ * @param relativePath That directory's path from the root, with '/' separators; "" for the root.
+ * @param cone The sparse cone, or nullptr to check out everything.
+ * @param entries Receives one entry per blob, in tree order.
  * @return True on success, false on failure.
  */
-static bool checkoutTree(const std::string& treeSha, const std::filesystem::path& currentPath, int depth) {
-    auto treeObjectDataOpt = readGitObject(treeSha);
+static bool collectTree(const ObjectId& treeSha, const std::filesystem::path& currentPath,
+                        std::string& relativePath, const SparseCone* cone, std::vector<CheckoutEntry>& entries) {
+    // Trees go through the object cache: the same subtree often appears
+    // under several paths, and later walks of this commit find it there.
+    auto treeObjectDataOpt = readCachedGitObject(treeSha);
     if (!treeObjectDataOpt) {
-        std::cerr << "Could not read tree object " << treeSha << "\n";
+        std::cerr << "Could not read tree object " << treeSha.toHex() << "\n";
         return false;
     }
     
@@ -62,50 +252,177 @@ static bool checkoutTree(const std::string& treeSha, const std::filesystem::path
     std::span<const std::byte> treeSpan(*treeObjectDataOpt);
     auto nullPosIt = findNullSeparator(treeSpan);
     if (nullPosIt == treeSpan.end()) {
-        std::cerr << "Invalid tree object format for " << treeSha << " (no header found)\n";
+        std::cerr << "Invalid tree object format for " << treeSha.toHex() << " (no header found)\n";
         return false;
     }
     auto treeContentSpan = treeSpan.subspan(std::distance(treeSpan.begin(), nullPosIt) + 1);
     
-    auto entriesOpt = parseTreeObject(treeContentSpan);
-    if (!entriesOpt) {
-        std::cerr << "Could not parse tree object " << treeSha << "\n";
+    try {
+        const size_t length = relativePath.size();
+        for (const auto& entry : TreeView(treeContentSpan)) {
+            if (cone) {
+                relativePath.resize(length);
+                relativePath.append(length == 0 ? "" : "/").append(entry.name);
+                const bool included = entry.isTree() ? cone->includesDirectory(relativePath)
+                                                     : cone->includesFile(relativePath);
+                if (!included) {
+                    continue;
+                }
+            }
+            std::filesystem::path entryPath = currentPath / entry.name;
+
+            if (entry.isTree()) {
+                std::filesystem::create_directory(entryPath);
+                // Recurse into the subdirectory.
+                if (!collectTree(entry.id(), entryPath, relativePath, cone, entries)) {
+                    return false; // Propagate failure up the call stack.
+                }
+            } else if (isCheckedOut(entry.type)) {
+                entries.push_back({std::move(entryPath), entry.id(), entry.type});
+            }
+            // Submodules are left as they are: their commits are not in this repository.
+        }
+        relativePath.resize(length);
+    } catch (const std::runtime_error&) {
+        std::cerr << "Could not parse tree object " << treeSha.toHex() << "\n";
+        return false;
+    }
+    
+    return true;
+}
+
+/// @brief Returns true for the entry types written to the working directory.
+static bool isCheckedOut(TreeEntryType type) {
+    return type == TreeEntryType::Blob || type == TreeEntryType::Executable || type == TreeEntryType::Symlink;
+}
+
+/**
+ * @brief Reads one blob and writes its content to its destination file.
+ *
+ * The content is streamed from the object store to the file, so a loose
+ * blob never has to fit in memory. A symlink's blob holds its target and
+ * is read whole. Runs on the worker pool, so failures are reported by
+ * throwing: the first one stops the remaining workers.
+ */
+static void writeBlob(const CheckoutEntry& entry) {
+    if (entry.type == TreeEntryType::Symlink) {
+        auto object = readGitObject(entry.blobSha);
+        std::span<const std::byte> bytes = object ? std::span<const std::byte>(*object) : std::span<const std::byte>{};
+        auto nullPos = findNullSeparator(bytes);
+        if (nullPos == bytes.end()) {
+            throw std::runtime_error("Could not read blob object " + entry.blobSha.toHex());
+        }
+        const std::string target(reinterpret_cast<const char*>(&*nullPos) + 1, std::distance(nullPos + 1, bytes.end()));
+        std::filesystem::create_symlink(target, entry.path);
+        return;
+    }
+
+    std::ofstream outFile(entry.path, std::ios::binary);
+    bool complete = streamGitObject(entry.blobSha, [&](std::span<const std::byte> data) {
+        outFile.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+    });
+    if (!complete) {
+        throw std::runtime_error("Could not read blob object " + entry.blobSha.toHex());
+    }
+    if (!outFile.flush()) {
+        throw std::runtime_error("Could not write " + entry.path.string());
+    }
+    if (entry.type == TreeEntryType::Executable) {
+        using std::filesystem::perms;
+        std::filesystem::permissions(entry.path, perms::owner_exec | perms::group_exec | perms::others_exec,
+                                     std::filesystem::perm_options::add);
+    }
+}
+
+/**
+ * @brief Returns true if a path holds exactly the given blob, or holds nothing.
+ *
+ * A regular file is compared by hashing its content as a blob, a symlink
+ * by hashing its target. Only the files a checkout replaces are read.
+ */
+static bool holdsBlob(const std::filesystem::path& path, const ObjectId& blobSha, TreeEntryType type) {
+    std::error_code ec;
+    const auto status = std::filesystem::symlink_status(path, ec);
+    if (!std::filesystem::exists(status)) {
+        return true; // Nothing to lose.
+    }
+    const auto hashBlob = [](std::span<const std::byte> content) {
+        Sha1Hasher hasher;
+        const std::string header = "blob " + std::to_string(content.size()) + '\0';
+        hasher.update(std::as_bytes(std::span{header}));
+        hasher.update(content);
+        return hasher.finish();
+    };
+    if (type == TreeEntryType::Symlink) {
+        if (!std::filesystem::is_symlink(status)) {
+            return false;
+        }
+        const std::string target = std::filesystem::read_symlink(path, ec).string();
+        return !ec && hashBlob(std::as_bytes(std::span{target})) == blobSha;
+    }
+    if (!std::filesystem::is_regular_file(status)) {
         return false;
     }
+    auto file = MappedFile::open(path);
+    return file && hashBlob(file->bytes()) == blobSha;
+}
 
-    for (const auto& entry : *entriesOpt) {
-        std::filesystem::path entryPath = currentPath / entry.filename;
-        std::string entrySha = bytesToHex(entry.sha1Bytes);
+/**
+ * @brief Removes the directories above a removed file, deepest first, as long as they are empty.
+ *
+ * A directory that still holds anything, e.g. an untracked file, is kept
+ * along with everything above it.
+ */
+static void removeEmptyParents(const std::filesystem::path& targetDir, std::string_view path) {
+    for (size_t slash = path.rfind('/'); slash != std::string_view::npos && slash > 0; slash = path.rfind('/')) {
+        path = path.substr(0, slash);
+        std::error_code ec;
+        if (!std::filesystem::remove(targetDir / path, ec)) {
+            return; // Not empty, or already gone.
+        }
+    }
+}
 
-        if (entry.mode == constants::MODE_TREE) {
-            std::filesystem::create_directory(entryPath);
-            // Recurse into the subdirectory.
-            if (!checkoutTree(entrySha, entryPath, depth + 1)) {
-                return false; // Propagate failure up the call stack.
-            }
-        } else if (entry.mode == constants::MODE_BLOB) {
-            // Read the blob object.
-            auto blobDataOpt = readGitObject(entrySha);
-            if (!blobDataOpt) {
-                std::cerr << "Could not read blob object " << entrySha << "\n";
-                return false;
-            }
-            
-            // Extract the blob's content (after its header).
-            std::span<const std::byte> blobSpan(*blobDataOpt);
-            auto blobNullPosIt = findNullSeparator(blobSpan);
-            if (blobNullPosIt == blobSpan.end()) {
-                 std::cerr << "Invalid blob object format for " << entrySha << "\n";
-                 return false;
-            }
-            auto blobContent = blobSpan.subspan(std::distance(blobSpan.begin(), blobNullPosIt) + 1);
+/**
+ * @brief Removes files, then writes files, in a working directory.
+ *
+ * Removals come first, with the directories they leave empty, so that a
+ * file can replace a directory and the other way around. The directories
+ * of the new files are then created on this thread and the files written
+ * on the worker pool, as checkoutCommit() does. Each new file replaces
+ * whatever is at its path instead of writing through it.
+ *
+ * @param removals Paths from the root of `targetDir`, in tree order.
+ * @param writes Files to write, in tree order.
+ * @return True on success; false after printing why.
+ */
+static bool replaceFiles(const std::filesystem::path& targetDir, const std::vector<std::string>& removals,
+                         const std::vector<CheckoutEntry>& writes, unsigned int numWorkers) {
+    try {
+        for (const std::string& path : removals) {
+            std::filesystem::remove(targetDir / path);
+        }
+        for (auto it = removals.rbegin(); it != removals.rend(); ++it) {
+            removeEmptyParents(targetDir, *it);
+        }
 
-            // Write the content to the destination file.
-            std::ofstream outFile(entryPath, std::ios::binary);
-            outFile.write(reinterpret_cast<const char*>(blobContent.data()), blobContent.size());
+        std::filesystem::path lastParent;
+        for (const CheckoutEntry& entry : writes) {
+            if (entry.path.parent_path() != lastParent) {
+                lastParent = entry.path.parent_path();
+                std::filesystem::create_directories(lastParent);
+            }
         }
-        // Other modes (like symlinks) are ignored in this implementation.
+        // Whatever is at a path is unlinked before the new file is created,
+        // as Git does: writing through it would follow a symlink out of the
+        // working tree, or change every other link of a hard-linked file.
+        parallelFor(writes.size(), numWorkers, [&](size_t i) {
+            std::filesystem::remove(writes[i].path);
+            writeBlob(writes[i]);
+        });
+    } catch (const std::exception& e) {
+        std::cerr << "Fatal: " << e.what() << "\n";
+        return false;
     }
-    
     return true;
-}
\ No newline at end of file
+}
@@ -0,0 +1,526 @@
+#include "../include/commit_graph.h"
+#include "../include/commit_parser.h"
+#include "../include/object_utils.h"
+#include "../include/refs.h"
+#include "../include/sha1_utils.h"
+#include "../include/tree_diff.h"
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace {
+    // Layout: header, chunk table, chunks, then a SHA-1 of everything before it.
+    // Header: "CGPH", version 1, hash version 1 (SHA-1), chunk count, base graph count.
+    // Chunk table: one (4-byte id, 8-byte offset) pair per chunk, then a terminating
+    // pair with id 0 whose offset is the end of the last chunk.
+    // CDAT record: tree SHA, parent 1, parent 2, then generation (30 bits) and commit date (34 bits).
+    constexpr unsigned char MAGIC[] = {'C', 'G', 'P', 'H'};
+    constexpr size_t HEADER_SIZE = 8;
+    constexpr size_t CHUNK_ENTRY_SIZE = 12;
+    constexpr size_t SHA_SIZE = ObjectId::SIZE;
+    constexpr size_t FANOUT_SIZE = 256 * 4;
+    constexpr size_t RECORD_SIZE = SHA_SIZE + 16;
+
+    constexpr uint32_t CHUNK_OID_FANOUT = 0x4f494446;  // "OIDF"
+    constexpr uint32_t CHUNK_OID_LOOKUP = 0x4f49444c;  // "OIDL"
+    constexpr uint32_t CHUNK_COMMIT_DATA = 0x43444154; // "CDAT"
+    constexpr uint32_t CHUNK_EXTRA_EDGES = 0x45444745; // "EDGE"
+    constexpr uint32_t CHUNK_BLOOM_INDEX = 0x42494458; // "BIDX"
+    constexpr uint32_t CHUNK_BLOOM_DATA = 0x42444154;  // "BDAT"
+    constexpr size_t BLOOM_DATA_HEADER_SIZE = 12;      // Hash version, hash count, bits per entry.
+    constexpr uint32_t MAX_BLOOM_HASHES = 32;          // Sanity bound on the hash count read from a file.
+
+    constexpr uint32_t PARENT_NONE = 0x70000000;
+    constexpr uint32_t PARENT_EXTRA_EDGES = 0x80000000; // In parent 2: the rest are in EDGE, from this index.
+    constexpr uint32_t EDGE_LAST = 0x80000000;          // In EDGE: the last parent of this commit.
+    constexpr uint64_t COMMIT_TIME_MASK = (uint64_t{1} << 34) - 1;
+
+    uint32_t readBigEndian32(const std::byte* p) {
+        return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+               (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+    }
+
+    uint64_t readBigEndian64(const std::byte* p) {
+        return (static_cast<uint64_t>(readBigEndian32(p)) << 32) | readBigEndian32(p + 4);
+    }
+
+    void appendBigEndian32(std::vector<std::byte>& out, uint32_t value) {
+        out.push_back(static_cast<std::byte>(value >> 24));
+        out.push_back(static_cast<std::byte>(value >> 16));
+        out.push_back(static_cast<std::byte>(value >> 8));
+        out.push_back(static_cast<std::byte>(value));
+    }
+
+    void appendBigEndian64(std::vector<std::byte>& out, uint64_t value) {
+        appendBigEndian32(out, static_cast<uint32_t>(value >> 32));
+        appendBigEndian32(out, static_cast<uint32_t>(value));
+    }
+
+    // A commit collected for the graph. Parents are indices into the collection.
+    struct GraphCommit {
+        ObjectId id;
+        ObjectId tree;
+        uint64_t commitTime = 0;
+        uint32_t firstParent = 0; // Index into the shared parent list.
+        uint32_t parentCount = 0;
+        uint32_t generation = 0;  // 0 until computed.
+    };
+
+    /**
+     * @class GraphBuilder
+     * @brief Collects the commits reachable from a set of tips and numbers their generations.
+     *
+     * Each commit object is read and parsed exactly once. The walk and the
+     * generation pass both use explicit stacks, so a history of a million
+     * commits in a straight line does not overflow the call stack.
+     */
+    class GraphBuilder {
+    public:
+        void addTip(const ObjectId& id) {
+            if (m_index.contains(id)) {
+                return;
+            }
+            // Annotated tags are peeled; a ref to a tree or a blob has no history to add.
+            const std::optional<ObjectId> commit = peelToCommit(id);
+            if (!commit || m_index.contains(*commit)) {
+                return;
+            }
+            m_stack.push_back(*commit);
+            collect();
+        }
+
+        // Returns the collected commits sorted by SHA, with parents renumbered to match.
+        std::vector<GraphCommit> finish(std::vector<uint32_t>& parents) {
+            computeGenerations();
+
+            std::vector<uint32_t> order(m_commits.size());
+            for (uint32_t i = 0; i < order.size(); ++i) {
+                order[i] = i;
+            }
+            std::sort(order.begin(), order.end(),
+                      [&](uint32_t a, uint32_t b) { return m_commits[a].id < m_commits[b].id; });
+            std::vector<uint32_t> position(m_commits.size());
+            for (uint32_t pos = 0; pos < order.size(); ++pos) {
+                position[order[pos]] = pos;
+            }
+
+            std::vector<GraphCommit> sorted;
+            sorted.reserve(m_commits.size());
+            parents.clear();
+            parents.reserve(m_parents.size());
+            for (uint32_t index : order) {
+                GraphCommit commit = m_commits[index];
+                const uint32_t first = commit.firstParent;
+                commit.firstParent = static_cast<uint32_t>(parents.size());
+                for (uint32_t i = 0; i < commit.parentCount; ++i) {
+                    parents.push_back(position[m_parents[first + i]]);
+                }
+                sorted.push_back(commit);
+            }
+            return sorted;
+        }
+
+    private:
+        // Reads every commit reachable from m_stack that is not collected yet.
+        void collect() {
+            while (!m_stack.empty()) {
+                const ObjectId id = m_stack.back();
+                m_stack.pop_back();
+                if (m_index.contains(id)) {
+                    continue;
+                }
+                auto object = readGitObject(id);
+                auto parts = object ? splitObject(*object) : std::nullopt;
+                auto commit = parts && parts->first == "commit" ? parseCommit(parts->second) : std::nullopt;
+                if (!commit) {
+                    throw std::runtime_error("could not read commit " + id.toHex());
+                }
+
+                GraphCommit entry;
+                entry.id = id;
+                entry.tree = commit->tree;
+                entry.commitTime = commit->commitTime;
+                entry.firstParent = static_cast<uint32_t>(m_parents.size());
+                entry.parentCount = static_cast<uint32_t>(commit->parents.size());
+                m_index.emplace(id, static_cast<uint32_t>(m_commits.size()));
+                m_commits.push_back(entry);
+                for (const ObjectId& parent : commit->parents) {
+                    // Parent indices are filled in once every commit has one.
+                    m_pendingParents.emplace_back(static_cast<uint32_t>(m_parents.size()), parent);
+                    m_parents.push_back(0);
+                    m_stack.push_back(parent);
+                }
+            }
+            for (const auto& [slot, parent] : m_pendingParents) {
+                m_parents[slot] = m_index.at(parent);
+            }
+            m_pendingParents.clear();
+        }
+
+        // Numbers each commit with 1 + the highest generation of its parents, roots being 1.
+        void computeGenerations() {
+            std::vector<uint32_t> stack;
+            for (uint32_t start = 0; start < m_commits.size(); ++start) {
+                if (m_commits[start].generation != 0) {
+                    continue;
+                }
+                stack.push_back(start);
+                while (!stack.empty()) {
+                    GraphCommit& commit = m_commits[stack.back()];
+                    uint32_t highest = 0;
+                    bool ready = true;
+                    for (uint32_t i = 0; i < commit.parentCount; ++i) {
+                        const uint32_t parent = m_parents[commit.firstParent + i];
+                        if (m_commits[parent].generation == 0) {
+                            stack.push_back(parent);
+                            ready = false;
+                        } else {
+                            highest = std::max(highest, m_commits[parent].generation);
+                        }
+                    }
+                    if (ready) {
+                        commit.generation = std::min(highest + 1, CommitGraph::GENERATION_MAX);
+                        stack.pop_back();
+                    }
+                }
+            }
+        }
+
+        std::vector<GraphCommit> m_commits;
+        std::vector<uint32_t> m_parents;
+        std::vector<std::pair<uint32_t, ObjectId>> m_pendingParents; // (slot in m_parents, parent SHA)
+        std::unordered_map<ObjectId, uint32_t> m_index;
+        std::vector<ObjectId> m_stack;
+    };
+
+    // Builds the changed-path filter of every commit, from a diff of its tree against its first parent's.
+    std::vector<std::vector<std::byte>> buildBloomFilters(const std::vector<GraphCommit>& commits,
+                                                          const std::vector<uint32_t>& parents,
+                                                          const BloomSettings& settings) {
+        std::vector<std::vector<std::byte>> filters;
+        filters.reserve(commits.size());
+        std::vector<std::string> paths;
+        for (const GraphCommit& commit : commits) {
+            std::optional<ObjectId> parentTree;
+            if (commit.parentCount > 0) {
+                parentTree = commits[parents[commit.firstParent]].tree;
+            }
+            // Once there are more paths than a filter may hold, the rest do not matter.
+            paths.clear();
+            diffTrees(parentTree, commit.tree, {}, [&](const TreeChange& change) {
+                paths.emplace_back(change.path);
+                return paths.size() <= settings.maxChangedPaths;
+            });
+            filters.push_back(buildChangedPathFilter(paths, settings));
+        }
+        return filters;
+    }
+
+    // Serializes the graph, checksum included. `filters` is empty when the graph has no Bloom filters.
+    std::vector<std::byte> serializeGraph(const std::vector<GraphCommit>& commits, const std::vector<uint32_t>& parents,
+                                          const std::vector<std::vector<std::byte>>& filters,
+                                          const BloomSettings& settings) {
+        // Parents beyond the first go to EDGE for octopus merges only.
+        std::vector<uint32_t> edges;
+        for (const GraphCommit& commit : commits) {
+            if (commit.parentCount > 2) {
+                for (uint32_t i = 1; i < commit.parentCount; ++i) {
+                    edges.push_back(parents[commit.firstParent + i] | (i + 1 == commit.parentCount ? EDGE_LAST : 0));
+                }
+            }
+        }
+
+        std::vector<std::pair<uint32_t, size_t>> chunks = {
+            {CHUNK_OID_FANOUT, FANOUT_SIZE},
+            {CHUNK_OID_LOOKUP, commits.size() * SHA_SIZE},
+            {CHUNK_COMMIT_DATA, commits.size() * RECORD_SIZE},
+        };
+        if (!edges.empty()) {
+            chunks.emplace_back(CHUNK_EXTRA_EDGES, edges.size() * 4);
+        }
+        size_t bloomDataSize = 0;
+        for (const auto& filter : filters) {
+            bloomDataSize += filter.size();
+        }
+        if (!filters.empty()) {
+            chunks.emplace_back(CHUNK_BLOOM_INDEX, commits.size() * 4);
+            chunks.emplace_back(CHUNK_BLOOM_DATA, BLOOM_DATA_HEADER_SIZE + bloomDataSize);
+        }
+
+        std::vector<std::byte> out;
+        size_t total = HEADER_SIZE + (chunks.size() + 1) * CHUNK_ENTRY_SIZE;
+        for (const auto& chunk : chunks) {
+            total += chunk.second;
+        }
+        out.reserve(total + SHA_SIZE);
+
+        for (unsigned char c : MAGIC) {
+            out.push_back(static_cast<std::byte>(c));
+        }
+        out.push_back(std::byte{1}); // Version.
+        out.push_back(std::byte{1}); // Hash version: SHA-1.
+        out.push_back(static_cast<std::byte>(chunks.size()));
+        out.push_back(std::byte{0}); // No base graphs.
+
+        uint64_t offset = HEADER_SIZE + (chunks.size() + 1) * CHUNK_ENTRY_SIZE;
+        for (const auto& [chunkId, size] : chunks) {
+            appendBigEndian32(out, chunkId);
+            appendBigEndian64(out, offset);
+            offset += size;
+        }
+        appendBigEndian32(out, 0);
+        appendBigEndian64(out, offset);
+
+        std::array<uint32_t, 256> fanout{};
+        for (const GraphCommit& commit : commits) {
+            ++fanout[static_cast<uint8_t>(commit.id.bytes[0])];
+        }
+        uint32_t running = 0;
+        for (uint32_t count : fanout) {
+            running += count;
+            appendBigEndian32(out, running);
+        }
+
+        for (const GraphCommit& commit : commits) {
+            out.insert(out.end(), commit.id.bytes.begin(), commit.id.bytes.end());
+        }
+
+        uint32_t nextEdge = 0;
+        for (const GraphCommit& commit : commits) {
+            out.insert(out.end(), commit.tree.bytes.begin(), commit.tree.bytes.end());
+            const uint32_t* own = parents.data() + commit.firstParent;
+            appendBigEndian32(out, commit.parentCount > 0 ? own[0] : PARENT_NONE);
+            if (commit.parentCount > 2) {
+                appendBigEndian32(out, PARENT_EXTRA_EDGES | nextEdge);
+                nextEdge += commit.parentCount - 1;
+            } else {
+                appendBigEndian32(out, commit.parentCount == 2 ? own[1] : PARENT_NONE);
+            }
+            const uint64_t time = std::min(commit.commitTime, COMMIT_TIME_MASK);
+            appendBigEndian64(out, (static_cast<uint64_t>(commit.generation) << 34) | time);
+        }
+
+        for (uint32_t edge : edges) {
+            appendBigEndian32(out, edge);
+        }
+
+        // BIDX holds the cumulative end offset of each filter in BDAT, past its header.
+        if (!filters.empty()) {
+            uint32_t end = 0;
+            for (const auto& filter : filters) {
+                end += static_cast<uint32_t>(filter.size());
+                appendBigEndian32(out, end);
+            }
+            appendBigEndian32(out, settings.hashVersion);
+            appendBigEndian32(out, settings.numHashes);
+            appendBigEndian32(out, settings.bitsPerEntry);
+            for (const auto& filter : filters) {
+                out.insert(out.end(), filter.begin(), filter.end());
+            }
+        }
+
+        const ObjectId checksum = calculateSha1(out);
+        out.insert(out.end(), checksum.bytes.begin(), checksum.bytes.end());
+        return out;
+    }
+}
+
+std::optional<CommitGraph> CommitGraph::open(const std::filesystem::path& path) {
+    auto file = MappedFile::open(path);
+    if (!file) {
+        return std::nullopt;
+    }
+    CommitGraph graph(std::move(*file));
+    auto bytes = graph.m_file.bytes();
+    if (bytes.size() < HEADER_SIZE + CHUNK_ENTRY_SIZE + SHA_SIZE || std::memcmp(bytes.data(), MAGIC, 4) != 0 ||
+        bytes[4] != std::byte{1} || bytes[5] != std::byte{1}) {
+        return std::nullopt;
+    }
+
+    // Every chunk must lie between the chunk table and the trailing checksum.
+    const size_t chunkCount = static_cast<uint8_t>(bytes[6]);
+    const size_t tableEnd = HEADER_SIZE + (chunkCount + 1) * CHUNK_ENTRY_SIZE;
+    const size_t dataEnd = bytes.size() - SHA_SIZE;
+    if (tableEnd > dataEnd) {
+        return std::nullopt;
+    }
+    size_t fanoutSize = 0, idsSize = 0, dataSize = 0, edgesSize = 0, bloomIndexSize = 0;
+    for (size_t i = 0; i < chunkCount; ++i) {
+        const std::byte* entry = bytes.data() + HEADER_SIZE + i * CHUNK_ENTRY_SIZE;
+        const uint32_t chunkId = readBigEndian32(entry);
+        const uint64_t start = readBigEndian64(entry + 4);
+        const uint64_t end = readBigEndian64(entry + 4 + CHUNK_ENTRY_SIZE);
+        if (start < tableEnd || end < start || end > dataEnd) {
+            return std::nullopt;
+        }
+        const std::byte* chunk = bytes.data() + start;
+        const size_t size = static_cast<size_t>(end - start);
+        switch (chunkId) {
+            case CHUNK_OID_FANOUT: graph.m_fanout = chunk; fanoutSize = size; break;
+            case CHUNK_OID_LOOKUP: graph.m_ids = chunk; idsSize = size; break;
+            case CHUNK_COMMIT_DATA: graph.m_data = chunk; dataSize = size; break;
+            case CHUNK_EXTRA_EDGES: graph.m_edges = chunk; edgesSize = size; break;
+            case CHUNK_BLOOM_INDEX: graph.m_bloomIndex = chunk; bloomIndexSize = size; break;
+            case CHUNK_BLOOM_DATA: graph.m_bloomData = {chunk, size}; break;
+            default: break; // Chunks this reader does not use, e.g. generation data v2.
+        }
+    }
+    if (!graph.m_fanout || !graph.m_ids || !graph.m_data || fanoutSize != FANOUT_SIZE) {
+        return std::nullopt;
+    }
+    graph.m_count = readBigEndian32(graph.m_fanout + 255 * 4);
+    if (idsSize != static_cast<size_t>(graph.m_count) * SHA_SIZE ||
+        dataSize != static_cast<size_t>(graph.m_count) * RECORD_SIZE) {
+        return std::nullopt;
+    }
+    graph.m_edgeCount = edgesSize / 4;
+
+    // Bloom filters are optional: without both chunks and a known header, the graph has none.
+    if (graph.m_bloomIndex && bloomIndexSize == static_cast<size_t>(graph.m_count) * 4 &&
+        graph.m_bloomData.size() >= BLOOM_DATA_HEADER_SIZE && readBigEndian32(graph.m_bloomData.data()) == 1 &&
+        readBigEndian32(graph.m_bloomData.data() + 4) - 1 < MAX_BLOOM_HASHES) {
+        const std::byte* header = graph.m_bloomData.data();
+        graph.m_bloomSettings.hashVersion = readBigEndian32(header);
+        graph.m_bloomSettings.numHashes = readBigEndian32(header + 4);
+        graph.m_bloomSettings.bitsPerEntry = readBigEndian32(header + 8);
+        graph.m_bloomData = graph.m_bloomData.subspan(BLOOM_DATA_HEADER_SIZE);
+    } else {
+        graph.m_bloomIndex = nullptr;
+        graph.m_bloomData = {};
+    }
+    return graph;
+}
+
+std::optional<uint32_t> CommitGraph::find(const ObjectId& id) const {
+    // The fanout table narrows the search to SHAs sharing the first byte.
+    const uint8_t first = static_cast<uint8_t>(id.bytes[0]);
+    uint32_t lo = first == 0 ? 0 : readBigEndian32(m_fanout + (first - 1) * 4);
+    uint32_t hi = readBigEndian32(m_fanout + first * 4);
+    if (hi > m_count || lo > hi) {
+        return std::nullopt;
+    }
+    while (lo < hi) {
+        const uint32_t mid = lo + (hi - lo) / 2;
+        const int cmp = std::memcmp(m_ids + static_cast<size_t>(mid) * SHA_SIZE, id.bytes.data(), SHA_SIZE);
+        if (cmp == 0) {
+            return mid;
+        }
+        if (cmp < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return std::nullopt;
+}
+
+ObjectId CommitGraph::id(uint32_t pos) const {
+    return ObjectId::fromBytes({m_ids + static_cast<size_t>(pos) * SHA_SIZE, SHA_SIZE});
+}
+
+ObjectId CommitGraph::tree(uint32_t pos) const {
+    return ObjectId::fromBytes({record(pos), SHA_SIZE});
+}
+
+uint32_t CommitGraph::generation(uint32_t pos) const {
+    return readBigEndian32(record(pos) + SHA_SIZE + 8) >> 2;
+}
+
+uint64_t CommitGraph::commitTime(uint32_t pos) const {
+    return readBigEndian64(record(pos) + SHA_SIZE + 8) & COMMIT_TIME_MASK;
+}
+
+bool CommitGraph::parents(uint32_t pos, std::vector<uint32_t>& out) const {
+    const std::byte* data = record(pos) + SHA_SIZE;
+    const uint32_t first = readBigEndian32(data);
+    if (first == PARENT_NONE) {
+        return true;
+    }
+    if (first >= m_count) {
+        return false;
+    }
+    out.push_back(first);
+
+    const uint32_t second = readBigEndian32(data + 4);
+    if (second == PARENT_NONE) {
+        return true;
+    }
+    if (!(second & PARENT_EXTRA_EDGES)) {
+        if (second >= m_count) {
+            return false;
+        }
+        out.push_back(second);
+        return true;
+    }
+    for (size_t edge = second & ~PARENT_EXTRA_EDGES; edge < m_edgeCount; ++edge) {
+        const uint32_t value = readBigEndian32(m_edges + edge * 4);
+        const uint32_t parent = value & ~EDGE_LAST;
+        if (parent >= m_count) {
+            return false;
+        }
+        out.push_back(parent);
+        if (value & EDGE_LAST) {
+            return true;
+        }
+    }
+    return false; // The edge list ended without marking its last parent.
+}
+
+std::span<const std::byte> CommitGraph::bloomFilter(uint32_t pos) const {
+    if (!m_bloomIndex) {
+        return {};
+    }
+    const uint32_t start = pos == 0 ? 0 : readBigEndian32(m_bloomIndex + static_cast<size_t>(pos - 1) * 4);
+    const uint32_t end = readBigEndian32(m_bloomIndex + static_cast<size_t>(pos) * 4);
+    if (start > end || end > m_bloomData.size()) {
+        return {};
+    }
+    return m_bloomData.subspan(start, end - start);
+}
+
+const std::byte* CommitGraph::record(uint32_t pos) const {
+    return m_data + static_cast<size_t>(pos) * RECORD_SIZE;
+}
+
+size_t writeCommitGraph(const std::vector<ObjectId>& tips, const CommitGraphWriteOptions& options,
+                        const std::filesystem::path& path) {
+    GraphBuilder builder;
+    for (const ObjectId& tip : tips) {
+        builder.addTip(tip);
+    }
+    std::vector<uint32_t> parents;
+    const std::vector<GraphCommit> commits = builder.finish(parents);
+    const BloomSettings settings;
+    const auto filters = options.changedPaths ? buildBloomFilters(commits, parents, settings)
+                                              : std::vector<std::vector<std::byte>>{};
+    const std::vector<std::byte> content = serializeGraph(commits, parents, filters, settings);
+
+    // Written aside and renamed, so a concurrent reader never maps a half-written graph.
+    std::filesystem::create_directories(path.parent_path());
+    std::string tmpName = (path.parent_path() / "tmp_graph_XXXXXX").string();
+    int fd = mkstemp(tmpName.data());
+    if (fd < 0) {
+        throw std::runtime_error("cannot create a temporary file in " + path.parent_path().string());
+    }
+    fchmod(fd, 0444);
+    std::span<const std::byte> remaining = content;
+    while (!remaining.empty()) {
+        const ssize_t written = ::write(fd, remaining.data(), remaining.size());
+        if (written < 0) {
+            ::close(fd);
+            std::filesystem::remove(tmpName);
+            throw std::runtime_error("cannot write " + tmpName);
+        }
+        remaining = remaining.subspan(static_cast<size_t>(written));
+    }
+    ::close(fd);
+    syncFileForPolicy(tmpName);
+    std::filesystem::rename(tmpName, path);
+    return commits.size();
+}
@@ -0,0 +1,91 @@
+#include "../include/commit_parser.h"
+
+#include <charconv>
+
+namespace {
+    // Returns the value of a "<key> <value>" header line, if the line has that key.
+    std::optional<std::string_view> headerValue(std::string_view line, std::string_view key) {
+        if (line.size() > key.size() && line.starts_with(key) && line[key.size()] == ' ') {
+            return line.substr(key.size() + 1);
+        }
+        return std::nullopt;
+    }
+}
+
+std::optional<CommitView> parseCommit(std::span<const std::byte> content) {
+    std::string_view text(reinterpret_cast<const char*>(content.data()), content.size());
+    CommitView commit;
+    bool hasTree = false;
+
+    // Headers come one per line until an empty line; continuation lines of
+    // multi-line headers such as "gpgsig" start with a space and are skipped.
+    while (!text.empty()) {
+        const size_t end = text.find('\n');
+        const std::string_view line = text.substr(0, end);
+        text = end == std::string_view::npos ? std::string_view{} : text.substr(end + 1);
+        if (line.empty()) {
+            commit.message = text;
+            break;
+        }
+
+        if (auto value = headerValue(line, "tree")) {
+            auto id = ObjectId::fromHex(*value);
+            if (!id || hasTree) {
+                return std::nullopt;
+            }
+            commit.tree = *id;
+            hasTree = true;
+        } else if (auto value = headerValue(line, "parent")) {
+            auto id = ObjectId::fromHex(*value);
+            if (!id) {
+                return std::nullopt;
+            }
+            commit.parents.push_back(*id);
+        } else if (auto value = headerValue(line, "author")) {
+            commit.author = *value;
+        } else if (auto value = headerValue(line, "committer")) {
+            commit.committer = *value;
+            if (auto signature = parseSignature(*value); signature && signature->timestamp > 0) {
+                commit.commitTime = static_cast<uint64_t>(signature->timestamp);
+            }
+        }
+    }
+
+    if (!hasTree) {
+        return std::nullopt;
+    }
+    return commit;
+}
+
+std::optional<Signature> parseSignature(std::string_view line) {
+    // The name may contain spaces, so the timestamp and zone are taken from the end.
+    const size_t emailEnd = line.rfind('>');
+    if (emailEnd == std::string_view::npos || emailEnd + 1 >= line.size() || line[emailEnd + 1] != ' ') {
+        return std::nullopt;
+    }
+    Signature signature;
+    signature.name = line.substr(0, emailEnd + 1);
+
+    std::string_view rest = line.substr(emailEnd + 2);
+    const size_t space = rest.find(' ');
+    if (space == std::string_view::npos) {
+        return std::nullopt;
+    }
+    auto [end, ec] = std::from_chars(rest.data(), rest.data() + space, signature.timestamp);
+    if (ec != std::errc{} || end != rest.data() + space) {
+        return std::nullopt;
+    }
+
+    signature.timezone = rest.substr(space + 1);
+    const std::string_view tz = signature.timezone;
+    if (tz.size() != 5 || (tz[0] != '+' && tz[0] != '-')) {
+        return std::nullopt;
+    }
+    int hhmm = 0;
+    auto [tzEnd, tzEc] = std::from_chars(tz.data() + 1, tz.data() + tz.size(), hhmm);
+    if (tzEc != std::errc{} || tzEnd != tz.data() + tz.size()) {
+        return std::nullopt;
+    }
+    signature.timezoneMinutes = (hhmm / 100 * 60 + hhmm % 100) * (tz[0] == '-' ? -1 : 1);
+    return signature;
+}
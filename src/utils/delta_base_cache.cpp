@@ -0,0 +1,50 @@
+#include "../include/delta_base_cache.h"
+
+DeltaBaseCache::DeltaBaseCache(size_t max_bytes) : m_max_bytes(max_bytes) {}
+
+DeltaBaseCache::Value DeltaBaseCache::get(const void* pack, uint64_t offset) {
+    std::lock_guard lock(m_mutex);
+    auto it = m_index.find({pack, offset});
+    if (it == m_index.end()) {
+        return nullptr;
+    }
+    m_lru.splice(m_lru.begin(), m_lru, it->second);
+    return it->second->second;
+}
+
+void DeltaBaseCache::put(const void* pack, uint64_t offset, Value object) {
+    size_t size = object->data.size();
+    if (size > m_max_bytes) {
+        return;
+    }
+
+    std::lock_guard lock(m_mutex);
+    if (auto it = m_index.find({pack, offset}); it != m_index.end()) {
+        evictLocked(it->second);
+    }
+    while (!m_lru.empty() && m_bytes_used + size > m_max_bytes) {
+        evictLocked(std::prev(m_lru.end()));
+    }
+
+    m_lru.emplace_front(Key{pack, offset}, std::move(object));
+    m_index[{pack, offset}] = m_lru.begin();
+    m_bytes_used += size;
+}
+
+void DeltaBaseCache::erase(const void* pack, uint64_t offset) {
+    std::lock_guard lock(m_mutex);
+    if (auto it = m_index.find({pack, offset}); it != m_index.end()) {
+        evictLocked(it->second);
+    }
+}
+
+size_t DeltaBaseCache::bytesUsed() const {
+    std::lock_guard lock(m_mutex);
+    return m_bytes_used;
+}
+
+void DeltaBaseCache::evictLocked(LruList::iterator it) {
+    m_bytes_used -= it->second->data.size();
+    m_index.erase(it->first);
+    m_lru.erase(it);
+}
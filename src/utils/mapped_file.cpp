@@ -0,0 +1,55 @@
+#include "../include/mapped_file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <utility>
+
+std::optional<MappedFile> MappedFile::open(const std::filesystem::path& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return std::nullopt;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        return std::nullopt;
+    }
+
+    // mmap() rejects zero-length mappings; an empty file maps to an empty span.
+    if (st.st_size == 0) {
+        ::close(fd);
+        return MappedFile(nullptr, 0);
+    }
+
+    void* addr = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // The mapping keeps its own reference to the file.
+    if (addr == MAP_FAILED) {
+        return std::nullopt;
+    }
+
+    return MappedFile(static_cast<const std::byte*>(addr), static_cast<size_t>(st.st_size));
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : m_data(std::exchange(other.m_data, nullptr)), m_size(std::exchange(other.m_size, 0)) {}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        if (m_data) {
+            munmap(const_cast<std::byte*>(m_data), m_size);
+        }
+        m_data = std::exchange(other.m_data, nullptr);
+        m_size = std::exchange(other.m_size, 0);
+    }
+    return *this;
+}
+
+MappedFile::~MappedFile() {
+    if (m_data) {
+        munmap(const_cast<std::byte*>(m_data), m_size);
+    }
+}
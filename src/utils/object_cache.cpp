@@ -0,0 +1,77 @@
+#include "../include/object_cache.h"
+
+#include <algorithm>
+
+ObjectCache::ObjectCache(size_t max_bytes, size_t shards) : m_shards(std::max<size_t>(1, shards)) {
+    setMaxBytes(max_bytes);
+}
+
+ObjectCache::Value ObjectCache::get(const ObjectId& id) {
+    Shard& shard = shardFor(id);
+    std::lock_guard lock(shard.mutex);
+    auto it = shard.index.find(id);
+    if (it == shard.index.end()) {
+        ++shard.misses;
+        return nullptr;
+    }
+    ++shard.hits;
+    shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+    return it->second->second;
+}
+
+void ObjectCache::put(const ObjectId& id, Value object) {
+    size_t size = object->size();
+    Shard& shard = shardFor(id);
+
+    std::lock_guard lock(shard.mutex);
+    if (size > shard.max_bytes) {
+        return;
+    }
+    if (auto it = shard.index.find(id); it != shard.index.end()) {
+        shard.bytes_used -= it->second->second->size();
+        shard.lru.erase(it->second);
+        shard.index.erase(it);
+    }
+    shard.shrinkLocked(size);
+
+    shard.lru.emplace_front(id, std::move(object));
+    shard.index[id] = shard.lru.begin();
+    shard.bytes_used += size;
+}
+
+void ObjectCache::setMaxBytes(size_t max_bytes) {
+    for (Shard& shard : m_shards) {
+        std::lock_guard lock(shard.mutex);
+        shard.max_bytes = max_bytes / m_shards.size();
+        shard.shrinkLocked(0);
+    }
+}
+
+size_t ObjectCache::bytesUsed() const {
+    return stats().bytes_used;
+}
+
+ObjectCache::Stats ObjectCache::stats() const {
+    Stats total;
+    for (const Shard& shard : m_shards) {
+        std::lock_guard lock(shard.mutex);
+        total.hits += shard.hits;
+        total.misses += shard.misses;
+        total.evictions += shard.evictions;
+        total.bytes_used += shard.bytes_used;
+    }
+    return total;
+}
+
+void ObjectCache::Shard::evictLocked(LruList::iterator it) {
+    bytes_used -= it->second->size();
+    index.erase(it->first);
+    lru.erase(it);
+    ++evictions;
+}
+
+void ObjectCache::Shard::shrinkLocked(size_t incoming) {
+    while (!lru.empty() && bytes_used + incoming > max_bytes) {
+        evictLocked(std::prev(lru.end()));
+    }
+}
@@ -1,61 +1,347 @@
 #include "../include/object_utils.h"
+#include "../include/bulk_checkin.h"
 #include "../include/constants.h"
 #include "../include/sha1_utils.h"
 #include "../include/zlib_utils.h"
+#include "../include/pack_store.h"
+#include "../include/mapped_file.h"
+
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 #include <fstream>
 #include <filesystem>
 #include <iostream>
 #include <algorithm>
+#include <stdexcept>
+#include <cstdlib>
+#include <utility>
+#include <array>
+#include <charconv>
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+#include <tuple>
+
+namespace {
+    // "<type> <size>\0" for the longest type name and a 20-digit size fits in this.
+    constexpr size_t MAX_HEADER_SIZE = 32;
+    constexpr size_t STREAM_CHUNK_SIZE = 64 * 1024;
+
+    // The start of an inflated loose object: its header plus the first content bytes.
+    struct LooseObjectPrefix {
+        std::array<std::byte, MAX_HEADER_SIZE> bytes; // Inflated bytes, header first.
+        size_t length = 0;                            // Valid bytes in `bytes`.
+        size_t headerSize = 0;                        // Length of "<type> <size>\0".
+        uint64_t contentSize = 0;                     // The size announced in the header.
+    };
+
+    // Returns the path of an object in the loose layout `.git/objects/xx/yyyy`.
+    std::filesystem::path looseObjectPath(const ObjectId& id) {
+        // Construct path from SHA: e.g., "ff/123..." for SHA "ff123...".
+        char hex[ObjectId::HEX_SIZE];
+        id.toHex(hex);
+        return constants::OBJECTS_DIR / std::string_view(hex, 2) / std::string_view(hex + 2, ObjectId::HEX_SIZE - 2);
+    }
+
+    FsyncPolicy g_fsyncPolicy = FsyncPolicy::None;
+
+    // Objects written under FsyncPolicy::Batch, waiting for flushObjectWrites() to move them into place.
+    struct PendingObject {
+        std::filesystem::path tmpPath;
+        std::filesystem::path finalPath;
+    };
+    std::mutex g_pendingMutex;
+    std::vector<PendingObject> g_pending;
+
+    // Creates a read-only temporary file in .git/objects. Returns its descriptor and path.
+    std::pair<int, std::filesystem::path> createTemporaryObject() {
+        const std::string pattern = (constants::OBJECTS_DIR / "tmp_obj_XXXXXX").string();
+        std::string tmpName = pattern;
+        int fd = mkstemp(tmpName.data());
+        if (fd < 0 && errno == ENOENT) {
+            // Only the first object of a fresh repository pays for this.
+            std::filesystem::create_directories(constants::OBJECTS_DIR);
+            tmpName = pattern;
+            fd = mkstemp(tmpName.data());
+        }
+        if (fd < 0) {
+            throw std::runtime_error("cannot create a temporary object in " + constants::OBJECTS_DIR.string());
+        }
+        fchmod(fd, 0444); // Objects are immutable; Git stores them read-only too.
+        return {fd, tmpName};
+    }
+
+    // Renames a finished object into place, creating its `xx` directory on first use.
+    void renameIntoPlace(const std::filesystem::path& tmpPath, const std::filesystem::path& finalPath) {
+        if (::rename(tmpPath.c_str(), finalPath.c_str()) == 0) {
+            return;
+        }
+        if (errno == ENOENT) {
+            std::filesystem::create_directories(finalPath.parent_path());
+            if (::rename(tmpPath.c_str(), finalPath.c_str()) == 0) {
+                return;
+            }
+        }
+        throw std::runtime_error("cannot store " + finalPath.string() + ": " + std::strerror(errno));
+    }
 
-std::optional<std::vector<std::byte>> readGitObject(const std::string& sha1Hex) {
-    if (sha1Hex.length() != 40) {
+    /**
+     * Finishes a temporary object file according to the fsync policy and
+     * closes `fd`. The object only ever appears under its final name
+     * complete, so a crash can lose an object but never leave a truncated one.
+     */
+    void storeLooseObject(int fd, const std::filesystem::path& tmpPath, const ObjectId& id) {
+        if (g_fsyncPolicy == FsyncPolicy::PerObject && ::fsync(fd) != 0) {
+            ::close(fd);
+            throw std::runtime_error("cannot sync " + tmpPath.string());
+        }
+        if (::close(fd) != 0) {
+            throw std::runtime_error("cannot write " + tmpPath.string());
+        }
+        if (g_fsyncPolicy == FsyncPolicy::Batch) {
+            std::lock_guard lock(g_pendingMutex);
+            g_pending.push_back({tmpPath, looseObjectPath(id)});
+            return;
+        }
+        renameIntoPlace(tmpPath, looseObjectPath(id));
+    }
+
+    // Moves what is left into place at exit, in case a command did not call flushObjectWrites().
+    struct PendingObjectsFlusher {
+        ~PendingObjectsFlusher() {
+            try {
+                flushObjectWrites();
+            } catch (const std::exception& e) {
+                std::cerr << "Error: " << e.what() << '\n';
+            }
+        }
+    } g_pendingFlusher;
+
+    // Like ZlibInflateStream::read(), but reports corrupt data as std::nullopt.
+    std::optional<size_t> tryRead(ZlibInflateStream& stream, std::span<std::byte> out) {
+        try {
+            return stream.read(out);
+        } catch (const std::runtime_error&) {
+            return std::nullopt;
+        }
+    }
+
+    // Inflates just enough of a loose object to parse its header.
+    std::optional<LooseObjectPrefix> readLoosePrefix(ZlibInflateStream& stream) {
+        LooseObjectPrefix prefix;
+        auto length = tryRead(stream, prefix.bytes);
+        if (!length) {
+            return std::nullopt;
+        }
+        prefix.length = *length;
+        std::span<const std::byte> inflated(prefix.bytes.data(), prefix.length);
+
+        auto nullPos = findNullSeparator(inflated);
+        auto spacePos = std::find(inflated.begin(), nullPos, std::byte{' '});
+        if (nullPos == inflated.end() || spacePos == nullPos) {
+            return std::nullopt;
+        }
+        const char* sizeBegin = reinterpret_cast<const char*>(&*spacePos) + 1;
+        const char* sizeEnd = reinterpret_cast<const char*>(&*nullPos);
+        auto [end, ec] = std::from_chars(sizeBegin, sizeEnd, prefix.contentSize);
+        if (ec != std::errc{} || end != sizeEnd) {
+            return std::nullopt;
+        }
+
+        prefix.headerSize = static_cast<size_t>(std::distance(inflated.begin(), nullPos)) + 1;
+        if (prefix.length - prefix.headerSize > prefix.contentSize) {
+            return std::nullopt; // More content than the header announced.
+        }
+        return prefix;
+    }
+
+    // Returns true if the stream holds no more output, i.e. the object was exactly its announced size.
+    bool isAtEnd(ZlibInflateStream& stream) {
+        std::byte extra;
+        return tryRead(stream, std::span<std::byte>(&extra, 1)) == 0;
+    }
+}
+
+// Reads an object from the loose layout `.git/objects/xx/yyyy`.
+// The header is inflated first so that the object's buffer is allocated
+// once, at its final size, and the rest is inflated straight into it.
+static std::optional<std::vector<std::byte>> readLooseObject(const ObjectId& id) {
+    auto file = MappedFile::open(looseObjectPath(id));
+    if (!file) {
         return std::nullopt;
     }
-    
-    // Construct path from SHA: e.g., "ff/123..." for SHA "ff123...".
-    const auto objectPath = constants::OBJECTS_DIR / sha1Hex.substr(0, 2) / sha1Hex.substr(2);
-    if (!std::filesystem::exists(objectPath)) {
+
+    ZlibInflateStream stream(file->bytes());
+    auto prefix = readLoosePrefix(stream);
+    if (!prefix) {
         return std::nullopt;
     }
 
-    std::ifstream objectFile(objectPath, std::ios::binary);
-    if (!objectFile) {
+    std::vector<std::byte> object(prefix->headerSize + prefix->contentSize);
+    std::copy_n(prefix->bytes.begin(), prefix->length, object.begin());
+    auto produced = tryRead(stream, std::span<std::byte>(object).subspan(prefix->length));
+    if (!produced || prefix->length + *produced != object.size() || !isAtEnd(stream)) {
         return std::nullopt;
     }
+    return object;
+}
+
+// Streams the content of a loose object to a sink, one chunk at a time.
+// The compressed file is read in chunks too, so memory use stays fixed.
+static bool streamLooseObject(std::ifstream& objectFile, const ObjectContentSink& sink) {
+    std::vector<std::byte> input(STREAM_CHUNK_SIZE);
+    ZlibInflateStream stream([&]() {
+        objectFile.read(reinterpret_cast<char*>(input.data()), static_cast<std::streamsize>(input.size()));
+        return std::span<const std::byte>(input.data(), static_cast<size_t>(objectFile.gcount()));
+    });
+    auto prefix = readLoosePrefix(stream);
+    if (!prefix) {
+        return false;
+    }
+
+    uint64_t remaining = prefix->contentSize - (prefix->length - prefix->headerSize);
+    if (prefix->length > prefix->headerSize) {
+        sink(std::span<const std::byte>(prefix->bytes.data() + prefix->headerSize, prefix->length - prefix->headerSize));
+    }
+    std::vector<std::byte> chunk(static_cast<size_t>(std::min<uint64_t>(remaining, STREAM_CHUNK_SIZE)));
+    while (remaining > 0) {
+        size_t want = static_cast<size_t>(std::min<uint64_t>(remaining, chunk.size()));
+        auto produced = tryRead(stream, std::span<std::byte>(chunk.data(), want));
+        if (!produced || *produced == 0) {
+            return false; // Corrupt, or the stream ended before the announced size.
+        }
+        sink(std::span<const std::byte>(chunk.data(), *produced));
+        remaining -= *produced;
+    }
+    return isAtEnd(stream);
+}
+
+// Rebuilds the "<type> <size>\0" header in front of a packed object's content.
+static std::vector<std::byte> toFullObject(const PackedObject& object) {
+    std::string header = typeToStringMap.at(object.type) + " " + std::to_string(object.data.size()) + '\0';
+    std::vector<std::byte> fullObject;
+    fullObject.reserve(header.size() + object.data.size());
+    auto headerBytes = std::as_bytes(std::span{header});
+    fullObject.insert(fullObject.end(), headerBytes.begin(), headerBytes.end());
+    fullObject.insert(fullObject.end(), object.data.begin(), object.data.end());
+    return fullObject;
+}
+
+std::optional<std::vector<std::byte>> readGitObject(const ObjectId& id) {
+    // Packs hold most objects of a cloned repository, so they are searched first.
+    if (auto packed = readPackedObject(id)) {
+        return toFullObject(*packed);
+    }
+    if (auto loose = readLooseObject(id)) {
+        return loose;
+    }
+
+    // The object may live in a pack written after the pack directory was scanned.
+    if (reloadPacks()) {
+        if (auto packed = readPackedObject(id)) {
+            return toFullObject(*packed);
+        }
+    }
+    return std::nullopt;
+}
+
+bool hasObject(const ObjectId& id) {
+    return std::filesystem::exists(looseObjectPath(id)) || hasPackedObject(id);
+}
+
+ObjectCache& objectCache() {
+    static ObjectCache cache(constants::DEFAULT_OBJECT_CACHE_SIZE);
+    return cache;
+}
+
+ObjectCache::Value readCachedGitObject(const ObjectId& id) {
+    if (auto cached = objectCache().get(id)) {
+        return cached;
+    }
+    auto object = readGitObject(id);
+    if (!object) {
+        return nullptr;
+    }
+    auto shared = std::make_shared<const std::vector<std::byte>>(std::move(*object));
+    objectCache().put(id, shared);
+    return shared;
+}
 
-    // Read the entire compressed file into a buffer.
-    objectFile.seekg(0, std::ios::end);
-    std::streamsize size = objectFile.tellg();
-    objectFile.seekg(0, std::ios::beg);
 
-    std::vector<std::byte> compressedData(size);
-    if (!objectFile.read(reinterpret_cast<char*>(compressedData.data()), size)) {
+// Reads the type and size of a loose object from its header alone.
+static std::optional<ObjectInfo> readLooseObjectInfo(const ObjectId& id) {
+    auto file = MappedFile::open(looseObjectPath(id));
+    if (!file) {
         return std::nullopt;
     }
 
-    // Decompress the data using zlib.
-    std::vector<std::byte> decompressedData;
-    if (!decompressZlib(compressedData, decompressedData)) {
+    ZlibInflateStream stream(file->bytes());
+    auto prefix = readLoosePrefix(stream);
+    if (!prefix) {
         return std::nullopt;
     }
+    auto spacePos = std::find(prefix->bytes.begin(), prefix->bytes.begin() + prefix->headerSize, std::byte{' '});
+    std::string type(reinterpret_cast<const char*>(prefix->bytes.data()), std::distance(prefix->bytes.begin(), spacePos));
+    return ObjectInfo{std::move(type), prefix->contentSize};
+}
 
-    return decompressedData;
+std::optional<ObjectInfo> readGitObjectInfo(const ObjectId& id) {
+    auto fromPacked = [](const PackedObjectInfo& info) {
+        return ObjectInfo{typeToStringMap.at(info.type), info.size};
+    };
+    if (auto packed = readPackedObjectInfo(id)) {
+        return fromPacked(*packed);
+    }
+    if (auto loose = readLooseObjectInfo(id)) {
+        return loose;
+    }
+    if (reloadPacks()) {
+        if (auto packed = readPackedObjectInfo(id)) {
+            return fromPacked(*packed);
+        }
+    }
+    return std::nullopt;
 }
 
 
-std::optional<std::vector<std::byte>> writeGitObject(std::span<const std::byte> content) {
-    // 1. Calculate the object's SHA-1 hash from its full content.
-    std::vector<std::byte> sha1Bytes = calculateSha1(content);
-    std::string sha1Hex = bytesToHex(sha1Bytes);
+bool streamGitObject(const ObjectId& id, const ObjectContentSink& sink) {
+    // Packed objects are resolved in memory, then handed over in one piece.
+    if (auto packed = readPackedObject(id)) {
+        sink(packed->data);
+        return true;
+    }
+    if (std::ifstream objectFile(looseObjectPath(id), std::ios::binary); objectFile) {
+        return streamLooseObject(objectFile, sink);
+    }
+    if (reloadPacks()) {
+        if (auto packed = readPackedObject(id)) {
+            sink(packed->data);
+            return true;
+        }
+    }
+    return false;
+}
 
-    // 2. Determine the path for the object file.
-    const auto dir = constants::OBJECTS_DIR / sha1Hex.substr(0, 2);
-    const auto filePath = dir / sha1Hex.substr(2);
+std::optional<ObjectId> writeGitObject(std::span<const std::byte> content) {
+    // In a bulk checkin, the object goes into the command's new pack instead.
+    if (auto* bulk = BulkCheckin::active()) {
+        try {
+            return bulk->add(content);
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << '\n';
+            return std::nullopt;
+        }
+    }
+
+    // 1. Calculate the object's SHA-1 hash from its full content.
+    const ObjectId id = calculateSha1(content);
 
-    // Optimization: if the object already exists, do nothing.
-    if (std::filesystem::exists(filePath)) {
-        return sha1Bytes;
+    // 2. If the object already exists, loose or packed, do nothing. Objects only
+    // appear under their final name once complete, so an existing file can be trusted.
+    if (hasObject(id)) {
+        return id;
     }
 
     // 3. Compress the content using zlib.
@@ -64,22 +350,144 @@ std::optional<std::vector<std::byte>> writeGitObject(std::span<const std::byte>
         std::cerr << "Compression failed\n";
         return std::nullopt;
     }
-    
-    // 4. Write the compressed data to disk.
+
+    // 4. Write the compressed data to a temporary file, then move it into place.
+    std::filesystem::path tmpPath;
     try {
-        std::filesystem::create_directories(dir);
-        std::ofstream outFile(filePath, std::ios::binary | std::ios::trunc);
-        if (!outFile) {
-             return std::nullopt;
-        }
-        outFile.write(reinterpret_cast<const char*>(compressedData.data()), compressedData.size());
-    } catch (const std::filesystem::filesystem_error& e) {
-        std::cerr << "Filesystem error: " << e.what() << '\n';
+        auto [fd, path] = createTemporaryObject();
+        tmpPath = std::move(path);
+        std::span<const std::byte> remaining(compressedData);
+        while (!remaining.empty()) {
+            ssize_t written = ::write(fd, remaining.data(), remaining.size());
+            if (written < 0) {
+                ::close(fd);
+                throw std::runtime_error("cannot write " + tmpPath.string());
+            }
+            remaining = remaining.subspan(static_cast<size_t>(written));
+        }
+        storeLooseObject(fd, tmpPath, id);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << '\n';
+        if (!tmpPath.empty()) {
+            std::error_code ec;
+            std::filesystem::remove(tmpPath, ec);
+        }
         return std::nullopt;
     }
 
-    // Return the raw SHA-1 hash on success.
-    return sha1Bytes;
+    // Return the SHA-1 on success.
+    return id;
+}
+
+FsyncPolicy fsyncPolicy() {
+    return g_fsyncPolicy;
+}
+
+void setFsyncPolicy(FsyncPolicy policy) {
+    g_fsyncPolicy = policy;
+}
+
+std::optional<FsyncPolicy> parseFsyncPolicy(std::string_view name) {
+    if (name == "none") return FsyncPolicy::None;
+    if (name == "per-object") return FsyncPolicy::PerObject;
+    if (name == "batch") return FsyncPolicy::Batch;
+    return std::nullopt;
+}
+
+void syncFileForPolicy(const std::filesystem::path& path) {
+    if (g_fsyncPolicy == FsyncPolicy::None) {
+        return;
+    }
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("cannot open " + path.string());
+    }
+    const int synced = ::fsync(fd);
+    ::close(fd);
+    if (synced != 0) {
+        throw std::runtime_error("cannot sync " + path.string());
+    }
+}
+
+void flushObjectWrites() {
+    std::lock_guard lock(g_pendingMutex);
+    if (g_pending.empty()) {
+        return;
+    }
+
+    // One syncfs() makes every pending file durable at once, instead of one
+    // fsync() per object. Only then do the objects get their final names.
+    int dirFd = ::open(constants::OBJECTS_DIR.c_str(), O_RDONLY | O_DIRECTORY);
+    if (dirFd < 0) {
+        throw std::runtime_error("cannot open " + constants::OBJECTS_DIR.string());
+    }
+    const int synced = ::syncfs(dirFd);
+    ::close(dirFd);
+    if (synced != 0) {
+        throw std::runtime_error("cannot sync " + constants::OBJECTS_DIR.string());
+    }
+
+    for (const auto& object : g_pending) {
+        renameIntoPlace(object.tmpPath, object.finalPath);
+    }
+    g_pending.clear();
+}
+
+LooseObjectWriter::LooseObjectWriter(std::string_view type, uint64_t size) : m_expectedSize(size) {
+    std::tie(m_fd, m_tmpPath) = createTemporaryObject();
+
+    m_hasher = std::make_unique<Sha1Hasher>();
+    m_deflater = std::make_unique<ZlibDeflateStream>([this](std::span<const std::byte> compressed) {
+        writeCompressed(compressed);
+    });
+
+    std::string header = std::string(type) + " " + std::to_string(size) + '\0';
+    auto headerBytes = std::as_bytes(std::span{header});
+    m_hasher->update(headerBytes);
+    m_deflater->write(headerBytes);
+}
+
+LooseObjectWriter::~LooseObjectWriter() {
+    if (m_fd >= 0) {
+        ::close(m_fd);
+    }
+    if (!m_committed && !m_tmpPath.empty()) {
+        std::error_code ec;
+        std::filesystem::remove(m_tmpPath, ec);
+    }
+}
+
+void LooseObjectWriter::write(std::span<const std::byte> data) {
+    m_writtenSize += data.size();
+    m_hasher->update(data);
+    m_deflater->write(data);
+}
+
+void LooseObjectWriter::writeCompressed(std::span<const std::byte> data) {
+    while (!data.empty()) {
+        ssize_t written = ::write(m_fd, data.data(), data.size());
+        if (written < 0) {
+            throw std::runtime_error("cannot write " + m_tmpPath.string());
+        }
+        data = data.subspan(static_cast<size_t>(written));
+    }
+}
+
+ObjectId LooseObjectWriter::commit() {
+    if (m_writtenSize != m_expectedSize) {
+        throw std::runtime_error("object content is " + std::to_string(m_writtenSize) + " bytes, expected " +
+                                 std::to_string(m_expectedSize));
+    }
+    m_deflater->finish();
+    const ObjectId id = m_hasher->finish();
+
+    // The temporary file is dropped by the destructor if the object already exists.
+    if (hasObject(id)) {
+        return id;
+    }
+    storeLooseObject(std::exchange(m_fd, -1), m_tmpPath, id);
+    m_committed = true;
+    return id;
 }
 
 // Finds the first null byte, which separates the header from the content.
@@ -87,6 +495,16 @@ std::span<const std::byte>::iterator findNullSeparator(std::span<const std::byte
     return std::find(data.begin(), data.end(), std::byte{0});
 }
 
+std::optional<std::pair<std::string_view, std::span<const std::byte>>> splitObject(std::span<const std::byte> object) {
+    auto nullPos = findNullSeparator(object);
+    auto spacePos = std::find(object.begin(), nullPos, std::byte{' '});
+    if (nullPos == object.end() || spacePos == nullPos) {
+        return std::nullopt;
+    }
+    std::string_view type(reinterpret_cast<const char*>(object.data()), std::distance(object.begin(), spacePos));
+    return std::pair{type, object.subspan(std::distance(object.begin(), nullPos) + 1)};
+}
+
 // Pads the mode to 6 digits for display, e.g., "40000" -> "040000".
 std::string formatModeForDisplay(std::string_view mode) {
     if (mode.length() < 6) {
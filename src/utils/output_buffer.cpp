@@ -0,0 +1,28 @@
+#include "../include/output_buffer.h"
+
+#include <charconv>
+
+OutputBuffer::OutputBuffer(std::ostream& out, size_t capacity) : m_out(out), m_capacity(capacity) {
+    m_buffer.reserve(capacity);
+}
+
+OutputBuffer::~OutputBuffer() {
+    flush();
+}
+
+void OutputBuffer::appendNumber(uint64_t value, size_t width) {
+    char digits[20];
+    auto [end, ec] = std::to_chars(digits, digits + sizeof(digits), value);
+    size_t length = static_cast<size_t>(end - digits);
+    for (size_t i = length; i < width; ++i) {
+        *this << ' ';
+    }
+    *this << std::string_view(digits, length);
+}
+
+void OutputBuffer::flush() {
+    if (!m_buffer.empty()) {
+        m_out.write(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size()));
+        m_buffer.clear();
+    }
+}
@@ -0,0 +1,504 @@
+#include "../include/pack_store.h"
+#include "../include/object_utils.h"
+#include "../include/sha1_utils.h"
+#include "../include/constants.h"
+#include "../include/delta_base_cache.h"
+#include "../include/zlib_utils.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+
+namespace {
+    // Layout of a version 2 index: magic, version, fanout, then per-object tables.
+    constexpr size_t IDX_HEADER_SIZE = 8;
+    constexpr size_t IDX_FANOUT_SIZE = 256 * 4;
+    constexpr size_t SHA_SIZE = 20;
+    constexpr size_t PACK_HEADER_SIZE = 12;
+
+    // Guards against corrupt packs whose delta chains loop back on themselves.
+    constexpr size_t MAX_DELTA_CHAIN = 10000;
+
+    // Two base-128 sizes of at most 10 bytes each open every delta's instructions.
+    constexpr size_t DELTA_SIZES_PREFIX = 20;
+
+    uint32_t readBigEndian32(const std::byte* p) {
+        return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+               (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+    }
+
+    uint64_t readBigEndian64(const std::byte* p) {
+        return (static_cast<uint64_t>(readBigEndian32(p)) << 32) | readBigEndian32(p + 4);
+    }
+
+    // Splits a full "<type> <size>\0<content>" object into its type and content.
+    std::optional<PackedObject> splitFullObject(std::span<const std::byte> object) {
+        auto nullPos = findNullSeparator(object);
+        auto spacePos = std::find(object.begin(), nullPos, std::byte{' '});
+        if (nullPos == object.end() || spacePos == nullPos) {
+            return std::nullopt;
+        }
+
+        std::string_view typeName(reinterpret_cast<const char*>(object.data()), std::distance(object.begin(), spacePos));
+        auto type = typeFromName(typeName);
+        if (!type) {
+            return std::nullopt;
+        }
+        return PackedObject{*type, std::vector<std::byte>(nullPos + 1, object.end())};
+    }
+}
+
+// =========================================================================
+// PackIndex
+// =========================================================================
+
+std::optional<PackIndex> PackIndex::open(const std::filesystem::path& path) {
+    auto file = MappedFile::open(path);
+    if (!file) {
+        return std::nullopt;
+    }
+
+    auto bytes = file->bytes();
+    if (bytes.size() < IDX_HEADER_SIZE + IDX_FANOUT_SIZE + 2 * SHA_SIZE) {
+        return std::nullopt;
+    }
+
+    // A v2 index starts with the magic "\377tOc" followed by the version number.
+    static constexpr unsigned char magic[] = {0xff, 't', 'O', 'c'};
+    if (std::memcmp(bytes.data(), magic, 4) != 0 || readBigEndian32(bytes.data() + 4) != 2) {
+        return std::nullopt;
+    }
+
+    // The last fanout entry is the total number of objects.
+    uint32_t count = readBigEndian32(bytes.data() + IDX_HEADER_SIZE + 255 * 4);
+
+    // SHA table, CRC32 table and 32-bit offset table are mandatory; the 64-bit table is optional.
+    size_t minimum_size = IDX_HEADER_SIZE + IDX_FANOUT_SIZE + static_cast<size_t>(count) * (SHA_SIZE + 4 + 4) + 2 * SHA_SIZE;
+    if (bytes.size() < minimum_size) {
+        return std::nullopt;
+    }
+
+    PackIndex index(std::move(*file));
+    index.m_object_count = count;
+    return index;
+}
+
+std::span<const std::byte> PackIndex::packChecksum() const {
+    auto bytes = m_file.bytes();
+    return bytes.subspan(bytes.size() - 2 * SHA_SIZE, SHA_SIZE);
+}
+
+uint64_t PackIndex::offsetAt(uint32_t position) const {
+    const std::byte* base = m_file.bytes().data() + IDX_HEADER_SIZE + IDX_FANOUT_SIZE;
+    const std::byte* offsets32 = base + static_cast<size_t>(m_object_count) * (SHA_SIZE + 4);
+    uint32_t offset = readBigEndian32(offsets32 + static_cast<size_t>(position) * 4);
+
+    // Offsets above 2 GiB live in a separate 64-bit table, referenced by the low 31 bits.
+    if ((offset & 0x80000000u) == 0) {
+        return offset;
+    }
+    const std::byte* offsets64 = offsets32 + static_cast<size_t>(m_object_count) * 4;
+    size_t slot = offset & 0x7fffffffu;
+    if (offsets64 + (slot + 1) * 8 > m_file.bytes().data() + m_file.bytes().size() - 2 * SHA_SIZE) {
+        throw std::runtime_error("Pack index 64-bit offset is out of bounds.");
+    }
+    return readBigEndian64(offsets64 + slot * 8);
+}
+
+std::optional<uint64_t> PackIndex::findOffset(const ObjectId& id) const {
+    // The fanout table narrows the search to names sharing the first byte.
+    const std::byte* fanout = m_file.bytes().data() + IDX_HEADER_SIZE;
+    uint8_t first = static_cast<uint8_t>(id.bytes[0]);
+    uint32_t lo = first == 0 ? 0 : readBigEndian32(fanout + (first - 1) * 4);
+    uint32_t hi = readBigEndian32(fanout + first * 4);
+    if (hi > m_object_count || lo > hi) {
+        return std::nullopt;
+    }
+
+    // Binary search over the sorted SHA table.
+    const std::byte* shas = fanout + IDX_FANOUT_SIZE;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        int cmp = std::memcmp(shas + static_cast<size_t>(mid) * SHA_SIZE, id.bytes.data(), SHA_SIZE);
+        if (cmp == 0) {
+            return offsetAt(mid);
+        }
+        if (cmp < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return std::nullopt;
+}
+
+// =========================================================================
+// Packfile
+// =========================================================================
+
+std::optional<Packfile> Packfile::open(const std::filesystem::path& idxPath) {
+    auto index = PackIndex::open(idxPath);
+    if (!index) {
+        return std::nullopt;
+    }
+
+    auto packPath = idxPath;
+    packPath.replace_extension(".pack");
+    auto pack = MappedFile::open(packPath);
+    if (!pack) {
+        return std::nullopt;
+    }
+
+    // Check the "PACK" signature, the object count and the trailing checksum
+    // against the index, so a mismatched pair is never used.
+    auto bytes = pack->bytes();
+    if (bytes.size() < PACK_HEADER_SIZE + SHA_SIZE || std::memcmp(bytes.data(), "PACK", 4) != 0) {
+        return std::nullopt;
+    }
+    if (readBigEndian32(bytes.data() + 8) != index->objectCount()) {
+        return std::nullopt;
+    }
+    auto trailer = bytes.subspan(bytes.size() - SHA_SIZE);
+    if (!std::equal(trailer.begin(), trailer.end(), index->packChecksum().begin())) {
+        return std::nullopt;
+    }
+
+    return Packfile(std::move(*index), std::move(*pack));
+}
+
+// Bases reconstructed while reading packed objects, shared by every pack of the process.
+static DeltaBaseCache& baseCache() {
+    static DeltaBaseCache cache(constants::DEFAULT_DELTA_CACHE_SIZE);
+    return cache;
+}
+
+std::optional<PackedObject> Packfile::readObject(uint64_t offset) const {
+    auto pack = m_pack.bytes();
+    // Entries live between the header and the trailing checksum.
+    auto entries = pack.first(pack.size() - SHA_SIZE);
+
+    // Delta entries collected while walking towards the base, innermost last.
+    struct PendingDelta {
+        uint64_t offset;
+        std::vector<std::byte> instructions;
+    };
+    std::vector<PendingDelta> deltas;
+    PackedObject result;
+
+    try {
+        while (true) {
+            if (offset < PACK_HEADER_SIZE || offset >= entries.size() || deltas.size() > MAX_DELTA_CHAIN) {
+                return std::nullopt;
+            }
+
+            // A base shared with earlier reads may still be cached.
+            if (!deltas.empty()) {
+                if (auto cached = baseCache().get(this, offset)) {
+                    result = *cached;
+                    break;
+                }
+            }
+
+            size_t cursor = offset;
+            auto [type, size] = readPackEntryHeader(entries, cursor);
+
+            if (type == GitObjectType::OFS_DELTA) {
+                uint64_t distance = readOfsDeltaOffset(entries, cursor);
+                if (distance == 0 || distance > offset) {
+                    return std::nullopt;
+                }
+                deltas.push_back({offset, inflatePackEntry(entries.subspan(cursor), size).first});
+                offset -= distance;
+                continue;
+            }
+
+            if (type == GitObjectType::REF_DELTA) {
+                if (cursor + SHA_SIZE > entries.size()) {
+                    return std::nullopt;
+                }
+                auto baseSha = ObjectId::fromBytes(entries.subspan(cursor, SHA_SIZE));
+                cursor += SHA_SIZE;
+                deltas.push_back({offset, inflatePackEntry(entries.subspan(cursor), size).first});
+
+                // The base is usually in the same pack; otherwise ask the whole object store.
+                if (auto baseOffset = findOffset(baseSha)) {
+                    offset = *baseOffset;
+                    continue;
+                }
+                auto baseObject = readGitObject(baseSha);
+                auto parsed = baseObject ? splitFullObject(*baseObject) : std::nullopt;
+                if (!parsed) {
+                    return std::nullopt;
+                }
+                result = std::move(*parsed);
+                break;
+            }
+
+            if (type != GitObjectType::COMMIT && type != GitObjectType::TREE &&
+                type != GitObjectType::BLOB && type != GitObjectType::TAG) {
+                return std::nullopt;
+            }
+            result.type = type;
+            result.data = inflatePackEntry(entries.subspan(cursor), size).first;
+            if (!deltas.empty()) {
+                baseCache().put(this, offset, std::make_shared<PackedObject>(result));
+            }
+            break;
+        }
+
+        // Replay the deltas from the one closest to the base outwards. Every
+        // intermediate result is the base of the next delta, so it is cached.
+        for (auto it = deltas.rbegin(); it != deltas.rend(); ++it) {
+            result.data = applyDelta(result.data, it->instructions);
+            if (std::next(it) != deltas.rend()) {
+                baseCache().put(this, it->offset, std::make_shared<PackedObject>(result));
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error reading packed object: " << e.what() << '\n';
+        return std::nullopt;
+    }
+
+    return result;
+}
+
+std::optional<PackedObjectInfo> Packfile::readObjectInfo(uint64_t offset) const {
+    auto pack = m_pack.bytes();
+    auto entries = pack.first(pack.size() - SHA_SIZE);
+
+    // The outermost entry gives the size; the end of its chain gives the type.
+    std::optional<uint64_t> resultSize;
+
+    try {
+        for (size_t depth = 0; depth <= MAX_DELTA_CHAIN; ++depth) {
+            if (offset < PACK_HEADER_SIZE || offset >= entries.size()) {
+                return std::nullopt;
+            }
+
+            size_t cursor = offset;
+            auto [type, size] = readPackEntryHeader(entries, cursor);
+
+            if (type != GitObjectType::OFS_DELTA && type != GitObjectType::REF_DELTA) {
+                if (type != GitObjectType::COMMIT && type != GitObjectType::TREE &&
+                    type != GitObjectType::BLOB && type != GitObjectType::TAG) {
+                    return std::nullopt;
+                }
+                return PackedObjectInfo{type, resultSize.value_or(size)};
+            }
+
+            std::optional<uint64_t> ofsDistance;
+            ObjectId baseSha;
+            if (type == GitObjectType::OFS_DELTA) {
+                ofsDistance = readOfsDeltaOffset(entries, cursor);
+                if (*ofsDistance == 0 || *ofsDistance > offset) {
+                    return std::nullopt;
+                }
+            } else {
+                if (cursor + SHA_SIZE > entries.size()) {
+                    return std::nullopt;
+                }
+                baseSha = ObjectId::fromBytes(entries.subspan(cursor, SHA_SIZE));
+                cursor += SHA_SIZE;
+            }
+
+            // Only the outermost delta's instructions are opened, and only
+            // as far as the two sizes they start with.
+            if (!resultSize) {
+                std::array<std::byte, DELTA_SIZES_PREFIX> prefix;
+                ZlibInflateStream stream(entries.subspan(cursor));
+                size_t length = stream.read(std::span(prefix).first(std::min<uint64_t>(prefix.size(), size)));
+                resultSize = readDeltaTargetSize(std::span(prefix).first(length));
+            }
+
+            if (ofsDistance) {
+                offset -= *ofsDistance;
+                continue;
+            }
+            if (auto baseOffset = findOffset(baseSha)) {
+                offset = *baseOffset;
+                continue;
+            }
+            // A thin pack's base lives elsewhere in the object store.
+            auto baseInfo = readGitObjectInfo(baseSha);
+            auto baseType = baseInfo ? typeFromName(baseInfo->type) : std::nullopt;
+            if (!baseType) {
+                return std::nullopt;
+            }
+            return PackedObjectInfo{*baseType, *resultSize};
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error reading packed object: " << e.what() << '\n';
+    }
+    return std::nullopt;
+}
+
+// =========================================================================
+// Process-wide pack registry
+// =========================================================================
+
+namespace {
+    std::shared_mutex g_packs_mutex;
+    std::vector<std::unique_ptr<Packfile>> g_packs;
+    std::set<std::filesystem::path> g_loaded_paths;
+    bool g_packs_scanned = false;
+
+    // Maps every pack of the pack directory that is not loaded yet.
+    // The caller must hold g_packs_mutex exclusively.
+    bool scanPackDirectory() {
+        g_packs_scanned = true;
+        std::error_code ec;
+        if (!std::filesystem::is_directory(constants::PACK_DIR, ec)) {
+            return false;
+        }
+
+        bool found = false;
+        for (const auto& entry : std::filesystem::directory_iterator(constants::PACK_DIR, ec)) {
+            const auto& path = entry.path();
+            if (path.extension() != ".idx" || g_loaded_paths.contains(path)) {
+                continue;
+            }
+            if (auto pack = Packfile::open(path)) {
+                g_packs.push_back(std::make_unique<Packfile>(std::move(*pack)));
+                g_loaded_paths.insert(path);
+                found = true;
+            }
+        }
+        return found;
+    }
+}
+
+bool reloadPacks() {
+    std::unique_lock lock(g_packs_mutex);
+    return scanPackDirectory();
+}
+
+namespace {
+    // Finds the pack holding an object and the offset of its entry.
+    std::optional<std::pair<const Packfile*, uint64_t>> locatePackedObject(const ObjectId& id) {
+        // The first lookup in this process maps the pack directory.
+        {
+            std::unique_lock lock(g_packs_mutex);
+            if (!g_packs_scanned) {
+                scanPackDirectory();
+            }
+        }
+
+        // Packs are never unloaded, so the pointer stays valid once the lock is
+        // released. Reading happens unlocked because resolving a REF_DELTA may
+        // recurse into the object store.
+        std::shared_lock lock(g_packs_mutex);
+        for (const auto& pack : g_packs) {
+            if (auto found = pack->findOffset(id)) {
+                return std::pair<const Packfile*, uint64_t>{pack.get(), *found};
+            }
+        }
+        return std::nullopt;
+    }
+}
+
+std::optional<PackedObject> readPackedObject(const ObjectId& id) {
+    auto location = locatePackedObject(id);
+    if (!location) {
+        return std::nullopt;
+    }
+    return location->first->readObject(location->second);
+}
+
+bool hasPackedObject(const ObjectId& id) {
+    return locatePackedObject(id).has_value();
+}
+
+std::optional<PackedObjectInfo> readPackedObjectInfo(const ObjectId& id) {
+    auto location = locatePackedObject(id);
+    if (!location) {
+        return std::nullopt;
+    }
+    return location->first->readObjectInfo(location->second);
+}
+
+// =========================================================================
+// Index writer
+// =========================================================================
+
+namespace {
+    void appendBigEndian32(std::vector<std::byte>& out, uint32_t value) {
+        out.push_back(static_cast<std::byte>(value >> 24));
+        out.push_back(static_cast<std::byte>(value >> 16));
+        out.push_back(static_cast<std::byte>(value >> 8));
+        out.push_back(static_cast<std::byte>(value));
+    }
+
+    void appendBigEndian64(std::vector<std::byte>& out, uint64_t value) {
+        appendBigEndian32(out, static_cast<uint32_t>(value >> 32));
+        appendBigEndian32(out, static_cast<uint32_t>(value));
+    }
+}
+
+bool writePackIndex(const std::filesystem::path& idxPath, const std::vector<PackObjectInfo>& objects,
+                    std::span<const std::byte> packChecksum) {
+    // The index stores the objects sorted by SHA.
+    std::vector<const PackObjectInfo*> sorted;
+    sorted.reserve(objects.size());
+    for (const auto& object : objects) {
+        sorted.push_back(&object);
+    }
+    std::sort(sorted.begin(), sorted.end(), [](const auto* a, const auto* b) { return a->sha1 < b->sha1; });
+
+    std::vector<std::byte> out;
+    out.reserve(IDX_HEADER_SIZE + IDX_FANOUT_SIZE + sorted.size() * (SHA_SIZE + 4 + 4) + 2 * SHA_SIZE);
+
+    // Header: magic "\377tOc" and version 2.
+    static constexpr unsigned char magic[] = {0xff, 't', 'O', 'c'};
+    for (unsigned char c : magic) out.push_back(static_cast<std::byte>(c));
+    appendBigEndian32(out, 2);
+
+    // Fanout: entry i counts the objects whose first byte is <= i.
+    size_t position = 0;
+    for (int byte = 0; byte < 256; ++byte) {
+        while (position < sorted.size() && static_cast<uint8_t>(sorted[position]->sha1.bytes[0]) <= byte) {
+            ++position;
+        }
+        appendBigEndian32(out, static_cast<uint32_t>(position));
+    }
+
+    for (const auto* info : sorted) {
+        out.insert(out.end(), info->sha1.bytes.begin(), info->sha1.bytes.end());
+    }
+    for (const auto* info : sorted) {
+        appendBigEndian32(out, info->crc32);
+    }
+
+    // Small offsets are stored inline; large ones become an index into the 64-bit table.
+    std::vector<uint64_t> large_offsets;
+    for (const auto* info : sorted) {
+        uint64_t offset = info->offset_in_packfile;
+        if (offset < 0x80000000u) {
+            appendBigEndian32(out, static_cast<uint32_t>(offset));
+        } else {
+            appendBigEndian32(out, 0x80000000u | static_cast<uint32_t>(large_offsets.size()));
+            large_offsets.push_back(offset);
+        }
+    }
+    for (uint64_t offset : large_offsets) {
+        appendBigEndian64(out, offset);
+    }
+
+    // Trailer: the pack's checksum, then a checksum of the index so far.
+    out.insert(out.end(), packChecksum.begin(), packChecksum.end());
+    auto idxChecksum = calculateSha1(out);
+    out.insert(out.end(), idxChecksum.bytes.begin(), idxChecksum.bytes.end());
+
+    std::ofstream outFile(idxPath, std::ios::binary | std::ios::trunc);
+    if (!outFile) {
+        return false;
+    }
+    outFile.write(reinterpret_cast<const char*>(out.data()), out.size());
+    return static_cast<bool>(outFile);
+}
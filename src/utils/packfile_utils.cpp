@@ -1,5 +1,7 @@
 #include "../include/packfile_utils.h"
 #include "../include/sha1_utils.h"
+#include "../include/delta_base_cache.h"
+#include "../include/parallel_utils.h"
 #include <zlib.h>
 
 #include <iostream>
@@ -11,175 +13,387 @@
 #include <optional>
 #include <algorithm>
 #include <span>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <tuple>
+#include <climits>
+
+// Computes the SHA-1 of an object from its type and content, as Git does: over "<type> <size>\0<content>".
+static ObjectId hashObject(GitObjectType type, std::span<const std::byte> data) {
+    std::string header = typeToStringMap.at(type) + " " + std::to_string(data.size()) + '\0';
+    Sha1Hasher hasher;
+    hasher.update(std::as_bytes(std::span{header}));
+    hasher.update(data);
+    return hasher.finish();
+}
+
+PackfileParser::PackfileParser(std::span<const std::byte> packfile_data, unsigned int num_threads, size_t delta_cache_size)
+    : m_packfile(packfile_data), m_num_threads(std::max(1u, num_threads)),
+      m_delta_base_cache(std::make_unique<DeltaBaseCache>(delta_cache_size)) {}
 
-PackfileParser::PackfileParser(const std::vector<std::byte>& packfile_data): m_packfile(packfile_data), m_cursor(0) {}
+PackfileParser::~PackfileParser() = default;
 
-const std::map<std::string, std::vector<std::byte>>& PackfileParser::getResolvedObjectsData() const {
-    return m_object_data_cache;
+void PackfileParser::setObjectHandler(ObjectHandler handler) {
+    m_object_handler = std::move(handler);
 }
 
-std::optional<std::vector<PackObjectInfo>> PackfileParser::parseAndResolve() {
-    if (m_packfile.size() < 12 || !verify_header()) {
-        return std::nullopt;
+// A header is at most a 10-byte size varint plus a 20-byte base SHA; anything longer is corrupt.
+static constexpr size_t MAX_ENTRY_HEADER_SIZE = 32;
+static constexpr size_t INFLATE_CHUNK_SIZE = 64 * 1024;
+
+PackStreamScanner::PackStreamScanner()
+    : m_scratch(INFLATE_CHUNK_SIZE), m_zstream(std::make_unique<z_stream>()),
+      m_pack_hasher(std::make_unique<Sha1Hasher>()) {
+    if (inflateInit(m_zstream.get()) != Z_OK) {
+        throw std::runtime_error("zlib inflateInit failed.");
     }
-    
-    uint32_t num_objects = read_big_endian_32();
+}
 
-    m_object_data_cache.clear();
-    m_object_type_cache.clear();
-    m_offset_to_sha_map.clear();
+PackStreamScanner::~PackStreamScanner() {
+    inflateEnd(m_zstream.get());
+}
 
-    std::vector<PackObjectInfo> final_objects;
-    std::vector<PendingDeltaObject> pending_deltas;
+void PackStreamScanner::setObjectHandler(ObjectHandler handler) {
+    m_object_handler = std::move(handler);
+}
 
-    // =========================================================================
-    // PASS 1: PARSE ALL OBJECTS, CACHE BASE OBJECTS, QUEUE DELTAS
-    // =========================================================================
-    // This pass iterates through the packfile, fully processing base objects
-    // (commit, tree, blob) and storing delta objects in a queue to be
-    // resolved later, once their base objects are available.
-    for (uint32_t i = 0; i < num_objects; ++i) {
-        PackObjectInfo info;
-        info.offset_in_packfile = m_cursor;
-
-        // 1. Decode the object header (type and size).
-        size_t header_start_cursor = m_cursor;
-        
-        // The type and size are encoded in a variable-length format.
-        std::byte first_byte = m_packfile[m_cursor++];
-        info.type = static_cast<GitObjectType>((static_cast<uint8_t>(first_byte) >> 4) & 0x7);
-        
-        uint64_t size = static_cast<uint8_t>(first_byte) & 0x0F;
-        int shift = 4;
-        while ((static_cast<uint8_t>(first_byte) & 0x80) != 0) {
-            first_byte = m_packfile[m_cursor++];
-            size |= (static_cast<uint64_t>(static_cast<uint8_t>(first_byte) & 0x7F)) << shift;
-            shift += 7;
+void PackStreamScanner::feed(std::span<const std::byte> data) {
+    while (!data.empty()) {
+        switch (m_state) {
+        case State::PackHeader: {
+            // "PACK", a 32-bit version and a 32-bit object count, all big-endian.
+            size_t take = std::min(data.size(), 12 - m_pending.size());
+            m_pending.insert(m_pending.end(), data.begin(), data.begin() + take);
+            data = data.subspan(take);
+            if (m_pending.size() < 12) break;
+
+            auto be32 = [&](size_t at) {
+                return static_cast<uint32_t>(m_pending[at]) << 24 | static_cast<uint32_t>(m_pending[at + 1]) << 16 |
+                       static_cast<uint32_t>(m_pending[at + 2]) << 8 | static_cast<uint32_t>(m_pending[at + 3]);
+            };
+            if (m_pending[0] != std::byte{'P'} || m_pending[1] != std::byte{'A'} ||
+                m_pending[2] != std::byte{'C'} || m_pending[3] != std::byte{'K'} || be32(4) != 2) {
+                throw std::runtime_error("Not a version 2 packfile.");
+            }
+            m_object_count = m_remaining = be32(8);
+            m_objects.reserve(m_remaining);
+            m_pack_hasher->update(m_pending);
+            m_offset += m_pending.size();
+            m_pending.clear();
+            m_state = m_remaining ? State::EntryHeader : State::Trailer;
+            break;
         }
-        info.uncompressed_size = size;
-        
-        // 2. For deltas, read the reference to the base object.
-        if (info.type == GitObjectType::REF_DELTA) {
-            std::span<const std::byte> sha1_ref_span(&m_packfile[m_cursor], 20);
-            info.delta_ref = bytesToHex(sha1_ref_span);
-            m_cursor += 20;
-        } else if (info.type == GitObjectType::OFS_DELTA) {
-            uint64_t offset_delta = read_variable_length_integer(m_cursor, m_packfile);
-            size_t base_offset = info.offset_in_packfile - offset_delta;
-            // Store the base offset as a string to reuse the delta_ref field.
-            info.delta_ref = std::to_string(base_offset);
+        case State::EntryHeader: {
+            // Headers are tiny but may be split across chunks: buffer a few
+            // bytes, then keep only the ones the header actually spans.
+            size_t already_buffered = m_pending.size();
+            size_t take = std::min(data.size(), MAX_ENTRY_HEADER_SIZE - already_buffered);
+            m_pending.insert(m_pending.end(), data.begin(), data.begin() + take);
+            size_t header_size = tryParseEntryHeader();
+            if (header_size == 0) {
+                if (m_pending.size() >= MAX_ENTRY_HEADER_SIZE) {
+                    throw std::runtime_error("Corrupt packfile entry header.");
+                }
+                data = data.subspan(take);
+                break;
+            }
+            m_pending.resize(header_size);
+            data = data.subspan(header_size - already_buffered);
+
+            m_current.crc32 = ::crc32(0L, reinterpret_cast<const Bytef*>(m_pending.data()), static_cast<uInt>(header_size));
+            m_pack_hasher->update(m_pending);
+            m_offset += header_size;
+            m_pending.clear();
+
+            if (inflateReset(m_zstream.get()) != Z_OK) {
+                throw std::runtime_error("zlib inflateReset failed.");
+            }
+            m_produced = 0;
+            if (m_current.type != GitObjectType::OFS_DELTA && m_current.type != GitObjectType::REF_DELTA) {
+                std::string header = typeToStringMap.at(m_current.type) + " " + std::to_string(m_current.uncompressed_size) + '\0';
+                m_object_hasher = std::make_unique<Sha1Hasher>();
+                m_object_hasher->update(std::as_bytes(std::span{header}));
+                if (m_object_handler) {
+                    m_content.resize(m_current.uncompressed_size);
+                }
+            }
+            m_state = State::EntryData;
+            break;
         }
+        case State::EntryData:
+            data = data.subspan(inflateEntryData(data));
+            break;
+        case State::Trailer: {
+            size_t take = std::min(data.size(), 20 - m_pending.size());
+            m_pending.insert(m_pending.end(), data.begin(), data.begin() + take);
+            data = data.subspan(take);
+            if (m_pending.size() < 20) break;
+
+            // The trailing 20 bytes are a SHA-1 of everything before them.
+            m_checksum = m_pack_hasher->finish();
+            if (!std::equal(m_pending.begin(), m_pending.end(), m_checksum.bytes.begin())) {
+                throw std::runtime_error("Packfile checksum mismatch.");
+            }
+            m_pending.clear();
+            m_offset += 20;
+            m_state = State::Done;
+            break;
+        }
+        case State::Done:
+            throw std::runtime_error("Unexpected data after the packfile checksum.");
+        }
+    }
+}
 
-        // 3. Decompress the object data (or delta instructions).
-        size_t data_start_cursor = m_cursor;
-        auto [data, bytes_consumed] = decompress_data(info.uncompressed_size);
-        m_cursor = data_start_cursor + bytes_consumed;
-        info.size_in_packfile = m_cursor - info.offset_in_packfile;
-
-        // 4. If it's a base object, process and cache it. If it's a delta, queue it.
-        if (info.type != GitObjectType::OFS_DELTA && info.type != GitObjectType::REF_DELTA) {
-            // It's a base object. Calculate its SHA and cache it.
-            std::string header = typeToStringMap.at(info.type) + " " + std::to_string(data.size()) + '\0';
-            std::vector<std::byte> full_object_data;
-            full_object_data.reserve(header.size() + data.size());
-            std::transform(header.begin(), header.end(), std::back_inserter(full_object_data), 
-                            [](char c){ return static_cast<std::byte>(c); });
-            full_object_data.insert(full_object_data.end(), data.begin(), data.end());
-            
-            info.sha1 = calculateSha1Hex(full_object_data);
-            
-            // Cache data and metadata for this object so it can serve as a base for others.
-            m_object_data_cache[info.sha1] = data;
-            m_object_type_cache[info.sha1] = info.type;
-            m_offset_to_sha_map[info.offset_in_packfile] = info.sha1;
+size_t PackStreamScanner::tryParseEntryHeader() {
+    std::span<const std::byte> header = m_pending;
 
-            final_objects.push_back(info);
-        } else {
-             // It's a delta object. Add it to the pending queue for the next pass.
-            pending_deltas.push_back({info, data});
+    // Make sure both variable-length numbers are complete before decoding them.
+    size_t end = 0;
+    while (end < header.size() && (static_cast<uint8_t>(header[end]) & 0x80)) ++end;
+    if (end++ >= header.size()) return 0;
+
+    auto type = static_cast<GitObjectType>((static_cast<uint8_t>(header[0]) >> 4) & 0x7);
+    if (type == GitObjectType::REF_DELTA) {
+        end += 20;
+    } else if (type == GitObjectType::OFS_DELTA) {
+        while (end < header.size() && (static_cast<uint8_t>(header[end]) & 0x80)) ++end;
+        ++end;
+    }
+    if (end > header.size()) return 0;
+
+    size_t cursor = 0;
+    m_current = PackObjectInfo{};
+    m_current.offset_in_packfile = m_offset;
+    std::tie(m_current.type, m_current.uncompressed_size) = readPackEntryHeader(header, cursor);
+    switch (m_current.type) {
+    case GitObjectType::COMMIT:
+    case GitObjectType::TREE:
+    case GitObjectType::BLOB:
+    case GitObjectType::TAG:
+        break;
+    case GitObjectType::REF_DELTA:
+        m_current.delta_ref = ObjectId::fromBytes(header.subspan(cursor, 20));
+        break;
+    case GitObjectType::OFS_DELTA: {
+        uint64_t offset_delta = readOfsDeltaOffset(header, cursor);
+        if (offset_delta == 0 || offset_delta > m_offset) {
+            throw std::runtime_error("Delta error: base offset points outside the packfile.");
         }
+        m_current.base_offset = m_offset - offset_delta;
+        break;
     }
+    default:
+        throw std::runtime_error("Unknown packfile entry type.");
+    }
+    return end;
+}
 
-    // =========================================================================
-    // PASS 2: RESOLVE ALL PENDING DELTAS
-    // =========================================================================
-    // This loop continues as long as there are unresolved deltas. It may take
-    // multiple passes if there are chains of deltas (delta based on another delta).
-    size_t passes = 0;
-    while (!pending_deltas.empty()) {
-        if (passes++ > num_objects) { // Safety break to prevent infinite loops.
-            std::cerr << "Error: Could not resolve all deltas, possible missing base or circular dependency." << std::endl;
-            break;
+size_t PackStreamScanner::inflateEntryData(std::span<const std::byte> data) {
+    z_stream& strm = *m_zstream;
+    strm.next_in = reinterpret_cast<Bytef*>(const_cast<std::byte*>(data.data()));
+    const size_t given = std::min<size_t>(data.size(), UINT32_MAX);
+    strm.avail_in = static_cast<uInt>(given);
+
+    const bool keep_content = !m_content.empty();
+    int ret = Z_OK;
+    while (ret == Z_OK) {
+        // Inflate straight into the object when it is kept, otherwise into the scratch buffer.
+        std::byte* out = keep_content ? m_content.data() + m_produced : m_scratch.data();
+        size_t out_size = keep_content ? m_content.size() - m_produced : m_scratch.size();
+        std::byte dummy_buffer[1]; // zlib wants a valid pointer even with no room left.
+        strm.next_out = reinterpret_cast<Bytef*>(out_size ? out : dummy_buffer);
+        strm.avail_out = static_cast<uInt>(out_size);
+
+        ret = inflate(&strm, Z_NO_FLUSH);
+        if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR) {
+            throw std::runtime_error("zlib inflate failed: error code " + std::to_string(ret));
         }
-        
-        size_t resolved_count_this_pass = 0;
-        std::vector<PendingDeltaObject> next_pending_deltas;
+        size_t produced = out_size - strm.avail_out;
+        if (m_object_hasher) {
+            m_object_hasher->update(std::span<const std::byte>(out, produced));
+        }
+        m_produced += produced;
+        if (m_produced > m_current.uncompressed_size) {
+            throw std::runtime_error("zlib inflate produced an unexpected number of bytes.");
+        }
+        // Z_BUF_ERROR means no progress was possible. That is expected when the
+        // input ran out mid-entry; with input left, the object is larger than announced.
+        if (ret == Z_BUF_ERROR && strm.avail_in != 0) {
+            throw std::runtime_error("zlib inflate produced an unexpected number of bytes.");
+        }
+        if (ret == Z_BUF_ERROR || (strm.avail_in == 0 && strm.avail_out != 0)) break;
+    }
 
-        for (const auto& pending : pending_deltas) {
-            std::string base_sha1;
-            
-            // Find the SHA-1 of the base object.
-            if (pending.info.type == GitObjectType::OFS_DELTA) {
-                size_t base_offset = std::stoull(pending.info.delta_ref);
-                auto it = m_offset_to_sha_map.find(base_offset);
-                if (it == m_offset_to_sha_map.end()) {
-                    next_pending_deltas.push_back(pending); // Base not ready, try again next pass.
-                    continue;
-                }
-                base_sha1 = it->second;
-            } else { // REF_DELTA
-                base_sha1 = pending.info.delta_ref;
+    size_t consumed = given - strm.avail_in;
+    m_current.crc32 = ::crc32(m_current.crc32, reinterpret_cast<const Bytef*>(data.data()), static_cast<uInt>(consumed));
+    m_pack_hasher->update(data.first(consumed));
+    m_offset += consumed;
+
+    if (ret == Z_STREAM_END) {
+        if (m_produced != m_current.uncompressed_size) {
+            throw std::runtime_error("zlib inflate produced an unexpected number of bytes.");
+        }
+        m_current.size_in_packfile = m_offset - m_current.offset_in_packfile;
+        if (m_object_hasher) {
+            m_current.sha1 = m_object_hasher->finish();
+            m_object_hasher.reset();
+            if (m_object_handler) {
+                m_object_handler(m_current, m_content);
             }
+            m_content.clear();
+        }
+        m_objects.push_back(std::move(m_current));
+        m_state = --m_remaining ? State::EntryHeader : State::Trailer;
+    }
+    return consumed;
+}
 
-           // Retrieve the base object's data and type from the cache
-            auto base_data_it = m_object_data_cache.find(base_sha1);
-            auto base_type_it = m_object_type_cache.find(base_sha1);
+std::optional<std::vector<PackObjectInfo>> PackfileParser::parseAndResolve() {
+    // =========================================================================
+    // PASS 1: PARSE ALL OBJECTS, HASH BASE OBJECTS, RECORD DELTA BASES
+    // =========================================================================
+    // The scanner walks the packfile to find where each entry ends. Base
+    // objects (commit, tree, blob) are hashed and handed to the object handler
+    // right away. Delta data is dropped and inflated again in PASS 2, so
+    // memory does not grow with the size of the pack.
+    PackStreamScanner scanner;
+    scanner.setObjectHandler(m_object_handler);
+    try {
+        scanner.feed(m_packfile);
+    } catch (const std::runtime_error& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return std::nullopt;
+    }
+    if (!scanner.isComplete()) {
+        std::cerr << "Error: Packfile is truncated." << std::endl;
+        return std::nullopt;
+    }
+    return resolveDeltas(scanner.takeObjects());
+}
 
-            if (base_data_it == m_object_data_cache.end() || base_type_it == m_object_type_cache.end()) {
-                next_pending_deltas.push_back(pending); // Base not ready.
+std::optional<std::vector<PackObjectInfo>> PackfileParser::resolveDeltas(std::vector<PackObjectInfo> objects) {
+    // =========================================================================
+    // PASS 2: RESOLVE DELTAS BY WALKING THE DEPENDENCY GRAPH
+    // =========================================================================
+    // Build the base -> children adjacency once. OFS_DELTA children hang off
+    // their base's offset; REF_DELTA children off their base's SHA-1.
+    std::unordered_map<size_t, std::vector<size_t>> children_by_offset;
+    std::unordered_map<ObjectId, std::vector<size_t>> children_by_sha;
+    std::vector<size_t> roots;
+    for (size_t i = 0; i < objects.size(); ++i) {
+        const auto& info = objects[i];
+        if (info.type == GitObjectType::OFS_DELTA) {
+            children_by_offset[info.base_offset].push_back(i);
+        } else if (info.type == GitObjectType::REF_DELTA) {
+            children_by_sha[info.delta_ref].push_back(i);
+        } else {
+            roots.push_back(i);
+        }
+    }
+
+    // Collects the deltas built directly on top of an object.
+    auto children_of = [&](const PackObjectInfo& base) {
+        std::vector<size_t> children;
+        if (auto it = children_by_offset.find(base.offset_in_packfile); it != children_by_offset.end()) {
+            children = it->second;
+        }
+        if (auto it = children_by_sha.find(base.sha1); it != children_by_sha.end()) {
+            children.insert(children.end(), it->second.begin(), it->second.end());
+        }
+        return children;
+    };
+
+    // Walk each base object's delta tree depth-first. Every delta is applied
+    // exactly once, and a base is dropped from the cache as soon as its last
+    // child is done. Distinct trees share nothing, so they are spread across
+    // threads. The stack only records which objects form the current chain;
+    // their content lives in the byte-budgeted cache and is rebuilt from the
+    // pack if it was evicted.
+    std::atomic<size_t> resolved_count{0};
+    parallelFor(roots.size(), m_num_threads, [&](size_t r) {
+        std::vector<ChainLink> stack;
+        if (auto children = children_of(objects[roots[r]]); !children.empty()) {
+            stack.push_back({roots[r], std::move(children)});
+        }
+
+        while (!stack.empty()) {
+            ChainLink& top = stack.back();
+            if (top.children.empty()) {
+                // Last child done: release the base.
+                m_delta_base_cache->erase(this, objects[top.object].offset_in_packfile);
+                stack.pop_back();
                 continue;
             }
-            
-            // Apply the delta instructions to the base object.
-            const auto& base_data = base_data_it->second;
-            const auto& base_type = base_type_it->second;
-            std::vector<std::byte> resolved_data = apply_delta(base_data, pending.delta_data);
-
-            PackObjectInfo resolved_info = pending.info;
-            resolved_info.type = base_type;  // The resolved object has the same type as its base.
-
-            // Calculate the SHA-1 of the newly reconstructed object.
-            std::string header = typeToStringMap.at(resolved_info.type) + " " + std::to_string(resolved_data.size()) + '\0';
-            std::vector<std::byte> full_object_data;
-            std::transform(header.begin(), header.end(), std::back_inserter(full_object_data), 
-                            [](char c){ return static_cast<std::byte>(c); });
-            full_object_data.insert(full_object_data.end(), resolved_data.begin(), resolved_data.end());
-
-            resolved_info.sha1 = calculateSha1Hex(full_object_data);
-            
-            // Add the newly resolved object to the caches, so it can serve as a base for others.
-            m_object_data_cache[resolved_info.sha1] = resolved_data;
-            m_object_type_cache[resolved_info.sha1] = resolved_info.type;
-            m_offset_to_sha_map[resolved_info.offset_in_packfile] = resolved_info.sha1;
-            
-            final_objects.push_back(resolved_info);
-            resolved_count_this_pass++;
-        }
+            size_t child = top.children.back();
+            top.children.pop_back();
+
+            // Each delta belongs to exactly one tree, so only this worker writes to it.
+            auto base = loadBase(objects, stack, stack.size() - 1);
+            auto& info = objects[child];
+            auto resolved = std::make_shared<PackedObject>();
+            resolved->type = base->type; // The resolved object has the same type as its base.
+            resolved->data = applyDelta(base->data, inflateEntryAt(info.offset_in_packfile));
+            base.reset();
+
+            info.type = resolved->type;
+            info.sha1 = hashObject(info.type, resolved->data);
+            if (m_object_handler) {
+                m_object_handler(info, resolved->data);
+            }
+            resolved_count++;
 
-        if (resolved_count_this_pass == 0 && !next_pending_deltas.empty()) {
-             std::cerr << "Error: Made no progress in resolving deltas on this pass." << std::endl;
-             break;
+            if (auto grandchildren = children_of(info); !grandchildren.empty()) {
+                m_delta_base_cache->put(this, info.offset_in_packfile, std::move(resolved));
+                stack.push_back({child, std::move(grandchildren)});
+            }
         }
+    });
 
-        pending_deltas = next_pending_deltas;
+    // Anything left over has a base that is not in this pack (or a cycle).
+    if (roots.size() + resolved_count != objects.size()) {
+        std::cerr << "Error: Could not resolve all deltas, possible missing base or circular dependency." << std::endl;
+        return std::nullopt;
     }
-    
-    // Sort the final list by offset to match the original packfile order for display.
-    std::sort(final_objects.begin(), final_objects.end(), [](const auto& a, const auto& b){
-        return a.offset_in_packfile < b.offset_in_packfile;
-    });
 
-    return final_objects;
+    return objects;
+}
+
+// Returns the content of the object at `depth` in the current chain, from the
+// cache if possible. On a miss, the object is rebuilt from the pack: a base
+// object is inflated again, a delta is re-applied on top of its own parent.
+std::shared_ptr<const PackedObject> PackfileParser::loadBase(const std::vector<PackObjectInfo>& objects,
+                                                             const std::vector<ChainLink>& chain, size_t depth) {
+    const auto& info = objects[chain[depth].object];
+    if (auto cached = m_delta_base_cache->get(this, info.offset_in_packfile)) {
+        return cached;
+    }
+
+    auto object = std::make_shared<PackedObject>();
+    object->type = info.type;
+    if (depth == 0) {
+        object->data = inflateEntryAt(info.offset_in_packfile);
+    } else {
+        auto parent = loadBase(objects, chain, depth - 1);
+        object->data = applyDelta(parent->data, inflateEntryAt(info.offset_in_packfile));
+    }
+    m_delta_base_cache->put(this, info.offset_in_packfile, object);
+    return object;
+}
+
+// Inflates the data (or delta instructions) of the entry starting at an offset.
+std::vector<std::byte> PackfileParser::inflateEntryAt(size_t offset) const {
+    size_t cursor = offset;
+    auto [type, size] = readPackEntryHeader(m_packfile, cursor);
+    if (type == GitObjectType::REF_DELTA) {
+        cursor += 20;
+    } else if (type == GitObjectType::OFS_DELTA) {
+        readOfsDeltaOffset(m_packfile, cursor);
+    }
+    return inflatePackEntry(m_packfile.subspan(cursor), size).first;
 }
 
 /**
@@ -187,13 +401,14 @@ std::optional<std::vector<PackObjectInfo>> PackfileParser::parseAndResolve() {
  *
  * This encoding scheme uses the most significant bit (MSB) of each byte as a
  * continuation flag. If the MSB is 1, another byte follows. The lower 7 bits
- * of each byte contain the actual data.
+ * of each byte contain the actual data, least significant group first.
+ * It is used for the base and target sizes at the start of delta data.
  *
  * @param cursor A reference to the current position in the data stream. It will be advanced.
  * @param data The raw byte stream to read from.
  * @return The decoded 64-bit integer.
  */
-uint64_t PackfileParser::read_variable_length_integer(size_t& cursor, const std::vector<std::byte>& data) {
+static uint64_t read_variable_length_integer(size_t& cursor, std::span<const std::byte> data) {
     uint64_t value = 0;
     int shift = 0;
     std::byte current_byte;
@@ -210,97 +425,123 @@ uint64_t PackfileParser::read_variable_length_integer(size_t& cursor, const std:
     return value;
 }
 
-/**
- * @brief Reads a standard 32-bit big-endian (network byte order) integer.
- * Advances the internal member cursor `m_cursor` by 4 bytes.
- */
-uint32_t PackfileParser::read_big_endian_32() {
-    uint32_t value = 0;
-    value |= static_cast<uint32_t>(m_packfile[m_cursor++]) << 24;
-    value |= static_cast<uint32_t>(m_packfile[m_cursor++]) << 16;
-    value |= static_cast<uint32_t>(m_packfile[m_cursor++]) << 8;
-    value |= static_cast<uint32_t>(m_packfile[m_cursor++]);
-    return value;
-}
-
-/**
- * @brief Verifies the 12-byte packfile header.
- * The header must consist of the magic signature "PACK" followed by a 32-bit
- * version number (which must be 2).
- */
-bool PackfileParser::verify_header() {
-    // Check for "PACK" signature.
-    if (m_packfile[0] != std::byte{'P'} || m_packfile[1] != std::byte{'A'} ||
-        m_packfile[2] != std::byte{'C'} || m_packfile[3] != std::byte{'K'}) {
-        return false;
+std::pair<GitObjectType, uint64_t> readPackEntryHeader(std::span<const std::byte> pack, size_t& cursor) {
+    if (cursor >= pack.size()) {
+        throw std::runtime_error("Unexpected end of packfile while reading an entry header.");
     }
-    m_cursor += 4;
 
-    // Check for version number 2.
-    uint32_t version = read_big_endian_32();
-    if (version != 2) {
-       return false;
-    }
+    // The type and size are encoded in a variable-length format.
+    std::byte current_byte = pack[cursor++];
+    auto type = static_cast<GitObjectType>((static_cast<uint8_t>(current_byte) >> 4) & 0x7);
 
-    return true;
+    uint64_t size = static_cast<uint8_t>(current_byte) & 0x0F;
+    int shift = 4;
+    while ((static_cast<uint8_t>(current_byte) & 0x80) != 0) {
+        if (cursor >= pack.size()) {
+            throw std::runtime_error("Unexpected end of packfile while reading an entry header.");
+        }
+        current_byte = pack[cursor++];
+        size |= (static_cast<uint64_t>(static_cast<uint8_t>(current_byte) & 0x7F)) << shift;
+        shift += 7;
+    }
+    return {type, size};
 }
 
+size_t writePackEntryHeader(GitObjectType type, uint64_t size, std::byte* out) {
+    // The first byte holds the type and the low 4 bits of the size; each
+    // following byte adds 7 more bits, and the high bit marks a continuation.
+    size_t length = 0;
+    uint8_t current = static_cast<uint8_t>((static_cast<uint8_t>(type) << 4) | (size & 0x0F));
+    size >>= 4;
+    while (size != 0) {
+        out[length++] = static_cast<std::byte>(current | 0x80);
+        current = static_cast<uint8_t>(size & 0x7F);
+        size >>= 7;
+    }
+    out[length++] = static_cast<std::byte>(current);
+    return length;
+}
 
-std::pair<std::vector<std::byte>, size_t> PackfileParser::decompress_data(size_t uncompressed_size) {
-    // A zero-size object still consumes a small, compressed representation in the packfile.
-    // We must initialize zlib to determine how many input bytes are consumed.
-    if (uncompressed_size == 0) {
-        // Provide a non-null buffer pointer to satisfy zlib, but with zero available space.
-        std::byte dummy_buffer[1];
-        z_stream strm = {};
-        strm.avail_in = m_packfile.size() - m_cursor;
-        strm.next_in = reinterpret_cast<Bytef*>(const_cast<std::byte*>(&m_packfile[m_cursor]));
-        strm.avail_out = 0;
-        strm.next_out = reinterpret_cast<Bytef*>(dummy_buffer); 
-
-        if (inflateInit(&strm) != Z_OK) {
-            throw std::runtime_error("zlib inflateInit failed for zero-size object.");
+std::optional<GitObjectType> typeFromName(std::string_view typeName) {
+    for (const auto& [type, name] : typeToStringMap) {
+        if (name == typeName) {
+            return type;
         }
-        int ret = inflate(&strm, Z_FINISH);
-        size_t bytes_consumed = strm.total_in;
-        inflateEnd(&strm);
+    }
+    return std::nullopt;
+}
 
-        // For an empty object, Z_STREAM_END is expected. Any other result indicates a corrupt packfile.
-        if (ret != Z_STREAM_END) {
-             throw std::runtime_error("zlib inflate failed for zero-size object: error code " + std::to_string(ret));
+uint64_t readOfsDeltaOffset(std::span<const std::byte> pack, size_t& cursor) {
+    if (cursor >= pack.size()) {
+        throw std::runtime_error("Unexpected end of packfile while reading a delta offset.");
+    }
+    std::byte current_byte = pack[cursor++];
+    uint64_t offset = static_cast<uint8_t>(current_byte) & 0x7F;
+    while ((static_cast<uint8_t>(current_byte) & 0x80) != 0) {
+        if (cursor >= pack.size()) {
+            throw std::runtime_error("Unexpected end of packfile while reading a delta offset.");
         }
-        
-        // Return an empty vector and the number of bytes consumed.
-        return {{}, bytes_consumed};
+        current_byte = pack[cursor++];
+        offset = ((offset + 1) << 7) | (static_cast<uint8_t>(current_byte) & 0x7F);
     }
+    return offset;
+}
 
-    // --- General case for sizes > 0 ---
+std::pair<std::vector<std::byte>, size_t> inflatePackEntry(std::span<const std::byte> input, size_t uncompressed_size) {
+    // A zero-size object still consumes a small, compressed representation in the packfile,
+    // so zlib always runs to learn how many input bytes belong to this entry.
+    // Provide a non-null output pointer to satisfy zlib even when there is no space.
     std::vector<std::byte> out_buffer(uncompressed_size);
+    std::byte dummy_buffer[1];
+
     z_stream strm = {};
-    strm.avail_in = m_packfile.size() - m_cursor;
-    strm.next_in = reinterpret_cast<Bytef*>(const_cast<std::byte*>(&m_packfile[m_cursor]));
-    strm.avail_out = uncompressed_size;
-    strm.next_out = reinterpret_cast<Bytef*>(out_buffer.data());
+    strm.next_in = reinterpret_cast<Bytef*>(const_cast<std::byte*>(input.data()));
+    strm.next_out = reinterpret_cast<Bytef*>(uncompressed_size ? out_buffer.data() : dummy_buffer);
 
     if (inflateInit(&strm) != Z_OK) {
         throw std::runtime_error("zlib inflateInit failed.");
     }
-    
-    int ret = inflate(&strm, Z_FINISH);
-    
-    size_t bytes_consumed = strm.total_in;
+
+    // zlib counts available bytes in 32 bits, but the input runs to the end
+    // of the pack and the object may be larger than 4 GiB: both are handed
+    // over in windows of at most UINT32_MAX bytes, as inflateEntryData() does.
+    size_t in_left = input.size();
+    size_t out_left = uncompressed_size;
+    int ret = Z_OK;
+    while (ret == Z_OK) {
+        const uInt in_window = static_cast<uInt>(std::min<size_t>(in_left, UINT32_MAX));
+        const uInt out_window = static_cast<uInt>(std::min<size_t>(out_left, UINT32_MAX));
+        strm.avail_in = in_window;
+        strm.avail_out = out_window;
+        ret = inflate(&strm, Z_NO_FLUSH);
+        in_left -= in_window - strm.avail_in;
+        out_left -= out_window - strm.avail_out;
+        if (out_left == 0) {
+            strm.next_out = reinterpret_cast<Bytef*>(dummy_buffer); // Only the end of the stream is left to read.
+        }
+    }
+
+    size_t bytes_consumed = input.size() - in_left;
+    size_t bytes_produced = uncompressed_size - out_left;
     inflateEnd(&strm);
 
     if (ret != Z_STREAM_END) {
         throw std::runtime_error("zlib inflate failed: error code " + std::to_string(ret));
     }
+    if (bytes_produced != uncompressed_size) {
+        throw std::runtime_error("zlib inflate produced an unexpected number of bytes.");
+    }
 
-    return {out_buffer, bytes_consumed};
+    return {std::move(out_buffer), bytes_consumed};
 }
 
+uint64_t readDeltaTargetSize(std::span<const std::byte> delta_prefix) {
+    size_t cursor = 0;
+    read_variable_length_integer(cursor, delta_prefix); // The base size.
+    return read_variable_length_integer(cursor, delta_prefix);
+}
 
-
-std::vector<std::byte> PackfileParser::apply_delta(const std::vector<std::byte>& base, const std::vector<std::byte>& delta_instructions) {
+std::vector<std::byte> applyDelta(std::span<const std::byte> base, std::span<const std::byte> delta_instructions) {
     size_t cursor = 0;
 
     // 1. Read the expected base object size from the delta header.
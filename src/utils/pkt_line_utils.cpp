@@ -8,77 +8,118 @@
 #include <iomanip> 
 #include <optional>
 #include <span>
-
-PktLineReader::PktLineReader(std::istream& stream) : m_stream(stream), m_is_finished(false){}
-
-std::optional<std::vector<std::byte>> PktLineReader::readNextPacket(){
-    if (m_is_finished) return std::nullopt;
-
-    char length_hex[4];
-    m_stream.read(length_hex, 4);
-
-    // check if we read 4 characters with read()
-    if(m_stream.gcount() < 4){
-        m_is_finished = true;
+#include <array>
+#include <cstdint>
+#include <algorithm>
+
+// Maps an ASCII character to its hex value, or to 0x80 if it is not a hex digit.
+static constexpr std::array<uint8_t, 256> HEX_VALUES = [] {
+    std::array<uint8_t, 256> table{};
+    table.fill(0x80);
+    for (int c = 0; c < 10; ++c) table['0' + c] = static_cast<uint8_t>(c);
+    for (int c = 0; c < 6; ++c) {
+        table['a' + c] = static_cast<uint8_t>(10 + c);
+        table['A' + c] = static_cast<uint8_t>(10 + c);
+    }
+    return table;
+}();
+
+// The largest packet Git sends or accepts (LARGE_PACKET_MAX), prefix included.
+static constexpr uint32_t MAX_PKT_LENGTH = 65520;
+
+/**
+ * @brief Decodes a 4-digit hex length prefix without branching on each digit.
+ * Invalid digits set the 0x80 bit, which is checked once at the end.
+ * @return The length, or std::nullopt if a character is not a hex digit.
+ */
+static std::optional<uint32_t> decodePktLength(const std::byte* prefix) {
+    uint8_t d0 = HEX_VALUES[static_cast<uint8_t>(prefix[0])];
+    uint8_t d1 = HEX_VALUES[static_cast<uint8_t>(prefix[1])];
+    uint8_t d2 = HEX_VALUES[static_cast<uint8_t>(prefix[2])];
+    uint8_t d3 = HEX_VALUES[static_cast<uint8_t>(prefix[3])];
+    if ((d0 | d1 | d2 | d3) & 0x80) {
         return std::nullopt;
     }
+    return static_cast<uint32_t>(d0) << 12 | static_cast<uint32_t>(d1) << 8 | static_cast<uint32_t>(d2) << 4 | d3;
+}
 
-    // convert the size
-    unsigned int length = 0;
-    try {
-        std::string hex_str(length_hex, 4);
-        length = std::stoul(hex_str, nullptr, 16);
-    } catch (const std::invalid_argument& e) {
-        m_is_finished = true;
-        return std::nullopt;
+// Builds the packet for a validated length prefix; `packet` spans the prefix and the payload.
+static PktLine makePacket(uint32_t length, std::span<const std::byte> packet) {
+    switch (length) {
+    case 0: return {PktLine::Type::Flush, {}};
+    case 1: return {PktLine::Type::Delim, {}};
+    case 2: return {PktLine::Type::ResponseEnd, {}};
+    default: return {PktLine::Type::Data, packet.subspan(4)};
     }
+}
+
+bool PktLineDecoder::fillPartial(size_t size) {
+    size_t take = std::min(m_input.size(), size - m_partial.size());
+    m_partial.insert(m_partial.end(), m_input.begin(), m_input.begin() + take);
+    m_input = m_input.subspan(take);
+    return m_partial.size() == size;
+}
 
-    // flush packet or empty packet
-    if (length == 0 || length == 4) {
-        return std::vector<std::byte>{};
+std::optional<PktLine> PktLineDecoder::next() {
+    if (m_error) return std::nullopt;
+
+    auto validLength = [this](std::optional<uint32_t> length) {
+        // "0003" is reserved, and nothing may exceed the largest packet.
+        m_error = !length || *length == 3 || *length > MAX_PKT_LENGTH;
+        return !m_error;
+    };
+
+    if (!m_partial.empty()) {
+        // Finish the packet an earlier chunk ended in: its prefix first, then its payload.
+        if (m_partial.size() < 4 && !fillPartial(4)) return std::nullopt;
+        auto length = decodePktLength(m_partial.data());
+        if (!validLength(length)) return std::nullopt;
+        if (*length > 4 && !fillPartial(*length)) return std::nullopt;
+        m_assembled.swap(m_partial);
+        m_partial.clear();
+        return makePacket(*length, m_assembled);
     }
-    
-    if (length < 4) {
-        m_is_finished = true;
+
+    // The usual case: the whole packet is in the current chunk and is returned as a view.
+    if (m_input.size() < 4) {
+        m_partial.assign(m_input.begin(), m_input.end());
+        m_input = {};
         return std::nullopt;
     }
-
-    // Read data
-    size_t content_length = length - 4;
-    std::vector<std::byte> content(content_length);
-    m_stream.read(reinterpret_cast<char*>(content.data()), content_length);
-
-    if (m_stream.gcount() < content_length) {
-        m_is_finished = true;
+    auto length = decodePktLength(m_input.data());
+    if (!validLength(length)) return std::nullopt;
+    size_t packet_size = std::max<size_t>(*length, 4);
+    if (m_input.size() < packet_size) {
+        m_partial.assign(m_input.begin(), m_input.end());
+        m_input = {};
         return std::nullopt;
     }
-    
-    return content;
+    auto packet = m_input.first(packet_size);
+    m_input = m_input.subspan(packet_size);
+    return makePacket(*length, packet);
 }
 
-
 std::optional<std::string> findMainBranchSha1(const std::string& str){
-    std::istringstream data_stream(str);
-    PktLineReader pktLineReader(data_stream);
-
-    pktLineReader.readNextPacket(); //skip header
+    PktLineDecoder decoder(std::as_bytes(std::span(str.data(), str.size())));
 
-    while (auto packet_opt = pktLineReader.readNextPacket()){
-        std::vector<std::byte>& packet_data = *packet_opt;
+    decoder.next(); //skip header
 
-        std::string packet_line(reinterpret_cast<const char*>(packet_data.data()), packet_data.size());
+    while (auto packet = decoder.next()){
+        std::string_view packet_line(reinterpret_cast<const char*>(packet->payload.data()), packet->payload.size());
 
+        // The first ref is followed by "\0<capabilities>".
+        packet_line = packet_line.substr(0, packet_line.find('\0'));
         if (!packet_line.empty() && packet_line.back() == '\n') {
-            packet_line.pop_back();
+            packet_line.remove_suffix(1);
         }
 
         size_t space_pos = packet_line.find(' ');
-        if (space_pos == std::string::npos) {
+        if (space_pos == std::string_view::npos) {
             continue;
         }
 
-        std::string_view sha1(packet_line.c_str(), space_pos);
-        std::string_view ref_name(packet_line.c_str() + space_pos + 1);
+        std::string_view sha1 = packet_line.substr(0, space_pos);
+        std::string_view ref_name = packet_line.substr(space_pos + 1);
 
         if (ref_name == "refs/heads/main" || ref_name == "refs/heads/master") {
             return std::string(sha1); 
@@ -100,36 +141,33 @@ std::string createPktLine(const std::string& line) {
 }
 
 
-std::optional<std::vector<std::byte>> extractPackfileData(const std::string& str){
-    std::istringstream data_stream(str);
-    PktLineReader pktLineReader(data_stream);
+SideBandDemuxer::SideBandDemuxer(DataHandler on_pack_data) : m_on_pack_data(std::move(on_pack_data)) {}
 
-    std::vector<std::byte> packfile;
+bool SideBandDemuxer::feed(std::string_view chunk) {
+    m_decoder.feed(std::as_bytes(std::span(chunk.data(), chunk.size())));
 
-    while (auto packet_opt = pktLineReader.readNextPacket()){
-        std::vector<std::byte>& packet_data = *packet_opt;
-
-        if (packet_data.empty()) {
-            continue; 
+    while (auto packet = m_decoder.next()) {
+        if (packet->payload.empty()) {
+            continue;
         }
 
-        std::byte band_id = packet_data[0]; //check first byte 
-        auto content_span = std::span(packet_data).subspan(1);
+        std::byte band_id = packet->payload[0]; //check first byte
+        auto content_span = packet->payload.subspan(1);
 
         if (band_id == std::byte{1}) { // \x01 : mean packfile data
-            packfile.insert(packfile.end(), content_span.begin(), content_span.end());
-
+            m_on_pack_data(content_span);
         } else if (band_id == std::byte{2}) { // \x02 progress messages
-            std::string message(reinterpret_cast<const char*>(content_span.data()), content_span.size());
-             std::cerr << "remote: " << message;
-        } else if (band_id == std::byte{3}) { // \x03 error 
-            std::string error_message(reinterpret_cast<const char*>(content_span.data()), content_span.size());
-            std::cerr << "Error from remote: " << error_message;
-            return std::nullopt;
-        }
-        else{
-            continue;
+            std::cerr << "remote: " << std::string_view(reinterpret_cast<const char*>(content_span.data()), content_span.size());
+        } else if (band_id == std::byte{3}) { // \x03 error
+            std::cerr << "Error from remote: " << std::string_view(reinterpret_cast<const char*>(content_span.data()), content_span.size());
+            return false;
         }
+        // Anything else (e.g. "NAK") is not multiplexed and is skipped.
     }
-    return packfile;
-}
\ No newline at end of file
+
+    if (m_decoder.hasError()) {
+        std::cerr << "Error: invalid pkt-line length in the server response.\n";
+        return false;
+    }
+    return true;
+}
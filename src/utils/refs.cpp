@@ -0,0 +1,133 @@
+#include "../include/refs.h"
+#include "../include/commit_parser.h"
+#include "../include/constants.h"
+#include "../include/object_utils.h"
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+
+namespace {
+    // Symbolic refs pointing at symbolic refs are followed this many times at most.
+    constexpr int MAX_SYMREF_DEPTH = 5;
+
+    // Nested tags are followed this many times at most.
+    constexpr int MAX_PEEL_DEPTH = 32;
+
+    // Reads `.git/packed-refs`: "<sha> <name>" lines, plus "^<sha>" peel lines that are skipped.
+    std::map<std::string, ObjectId, std::less<>> readPackedRefs() {
+        std::map<std::string, ObjectId, std::less<>> refs;
+        std::ifstream file(constants::GIT_DIR / "packed-refs");
+        std::string line;
+        while (std::getline(file, line)) {
+            if (line.size() < ObjectId::HEX_SIZE + 2 || line[0] == '#' || line[0] == '^') {
+                continue;
+            }
+            if (auto id = ObjectId::fromHex(std::string_view(line).substr(0, ObjectId::HEX_SIZE))) {
+                refs.emplace(line.substr(ObjectId::HEX_SIZE + 1), *id);
+            }
+        }
+        return refs;
+    }
+
+    // Reads a ref by its full name ("HEAD", "refs/heads/main"), following symbolic refs.
+    std::optional<ObjectId> readRef(std::string_view name, int depth = 0) {
+        if (depth > MAX_SYMREF_DEPTH || name.find("..") != std::string_view::npos) {
+            return std::nullopt;
+        }
+        std::ifstream file(constants::GIT_DIR / name);
+        std::string line;
+        if (file && std::getline(file, line)) {
+            if (line.starts_with("ref: ")) {
+                return readRef(std::string_view(line).substr(5), depth + 1);
+            }
+            return ObjectId::fromHex(std::string_view(line).substr(0, std::min(line.size(), ObjectId::HEX_SIZE)));
+        }
+        if (!name.starts_with("refs/")) {
+            return std::nullopt;
+        }
+        auto packed = readPackedRefs();
+        auto it = packed.find(name);
+        return it == packed.end() ? std::nullopt : std::optional<ObjectId>(it->second);
+    }
+
+    // Follows tags, and commits when looking for a tree, until an object of type `wanted` is reached.
+    std::optional<ObjectId> peel(std::optional<ObjectId> id, std::string_view wanted) {
+        for (int depth = 0; id && depth < MAX_PEEL_DEPTH; ++depth) {
+            auto object = readCachedGitObject(*id);
+            if (!object) {
+                return std::nullopt;
+            }
+            auto parts = splitObject(*object);
+            if (!parts) {
+                return std::nullopt;
+            }
+            const auto& [type, content] = *parts;
+            if (type == wanted) {
+                return id;
+            }
+            if (type == "commit" && wanted == "tree") {
+                auto commit = parseCommit(content);
+                return commit ? std::optional(commit->tree) : std::nullopt;
+            }
+            if (type != "tag") {
+                return std::nullopt;
+            }
+            // An annotated tag names its target on its first line: "object <sha>".
+            const std::string_view text(reinterpret_cast<const char*>(content.data()), content.size());
+            id = text.starts_with("object ") ? ObjectId::fromHex(text.substr(7, ObjectId::HEX_SIZE)) : std::nullopt;
+        }
+        return std::nullopt;
+    }
+}
+
+std::optional<ObjectId> resolveRevision(std::string_view name) {
+    if (auto id = ObjectId::fromHex(name)) {
+        return id;
+    }
+    if (name.empty()) {
+        return std::nullopt;
+    }
+    const std::string full(name);
+    for (const std::string& candidate : {full, "refs/" + full, "refs/tags/" + full, "refs/heads/" + full,
+                                         "refs/remotes/" + full, "refs/remotes/" + full + "/HEAD"}) {
+        // Only HEAD-like names live directly in .git; anything else must be under refs/.
+        if (candidate == full && !full.starts_with("refs/") && full != constants::HEAD_FILE_NAME) {
+            continue;
+        }
+        if (auto id = readRef(candidate)) {
+            return id;
+        }
+    }
+    return std::nullopt;
+}
+
+std::vector<std::pair<std::string, ObjectId>> listRefs() {
+    std::map<std::string, ObjectId, std::less<>> refs = readPackedRefs();
+
+    const auto refsDir = constants::GIT_DIR / constants::REFS_DIR_NAME;
+    std::error_code ec;
+    for (auto it = std::filesystem::recursive_directory_iterator(refsDir, ec);
+         !ec && it != std::filesystem::recursive_directory_iterator(); it.increment(ec)) {
+        if (!it->is_regular_file()) {
+            continue;
+        }
+        std::string name = it->path().lexically_relative(constants::GIT_DIR).generic_string();
+        if (auto id = readRef(name)) {
+            refs[name] = *id;
+        }
+    }
+    return {refs.begin(), refs.end()};
+}
+
+std::optional<ObjectId> resolveTreeish(std::string_view name) {
+    return peel(resolveRevision(name), "tree");
+}
+
+std::optional<ObjectId> resolveCommit(std::string_view name) {
+    return peel(resolveRevision(name), "commit");
+}
+
+std::optional<ObjectId> peelToCommit(const ObjectId& id) {
+    return peel(id, "commit");
+}
@@ -0,0 +1,256 @@
+#include "../include/rev_walk.h"
+#include "../include/commit_parser.h"
+#include "../include/object_utils.h"
+#include "../include/refs.h"
+#include "../include/tree_diff.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string_view>
+
+namespace {
+    std::optional<uint64_t> parseCount(std::string_view text) {
+        uint64_t value = 0;
+        auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+        if (ec != std::errc{} || end != text.data() + text.size()) {
+            return std::nullopt;
+        }
+        return value;
+    }
+
+    // Turns a path argument into a path from the root: "./src/" becomes "src". The root itself is rejected.
+    std::optional<std::string> normalizePath(std::string_view path) {
+        while (path.starts_with("./")) {
+            path.remove_prefix(2);
+        }
+        while (path.ends_with('/')) {
+            path.remove_suffix(1);
+        }
+        if (path.empty() || path == ".") {
+            return std::nullopt;
+        }
+        return std::string(path);
+    }
+}
+
+std::optional<RevWalkArgs> parseRevWalkArgs(int argc, char* argv[], int first) {
+    RevWalkArgs args;
+    for (int i = first; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        std::optional<uint64_t> count;
+        if (arg == "--") {
+            // Everything after "--" is a path.
+            for (++i; i < argc; ++i) {
+                auto path = normalizePath(argv[i]);
+                if (!path) {
+                    return std::nullopt;
+                }
+                args.paths.push_back(std::move(*path));
+            }
+            break;
+        } else if (arg == "-n" && i + 1 < argc) {
+            count = parseCount(argv[++i]);
+        } else if (arg.starts_with("--max-count=")) {
+            count = parseCount(arg.substr(12));
+        } else if (arg.starts_with("-n")) {
+            count = parseCount(arg.substr(2));
+        } else if (arg.starts_with("-")) {
+            return std::nullopt;
+        } else {
+            args.revisions.emplace_back(arg);
+            continue;
+        }
+        if (!count) {
+            return std::nullopt;
+        }
+        args.maxCount = *count;
+    }
+    return args;
+}
+
+int printRevWalk(RevWalkArgs args, const CommitPrinter& print) {
+    const std::optional<CommitGraph> graph = CommitGraph::open();
+    RevWalk walk(graph ? &*graph : nullptr);
+    if (!args.paths.empty()) {
+        walk.setPaths(std::move(args.paths));
+    }
+    OutputBuffer out(std::cout);
+    try {
+        for (const std::string& revision : args.revisions) {
+            auto id = resolveRevision(revision);
+            if (!id) {
+                throw std::runtime_error("bad revision '" + revision + "'");
+            }
+            walk.push(*id);
+        }
+
+        // The walk itself runs on the graph; only what `print` needs is read.
+        for (uint64_t printed = 0; printed < args.maxCount; ++printed) {
+            auto commit = walk.next();
+            if (!commit) {
+                break;
+            }
+            print(*commit, printed, out);
+        }
+    } catch (const std::runtime_error& e) {
+        out.flush();
+        std::cerr << "Fatal: " << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+    out.flush();
+    return out.good() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+RevWalk::RevWalk(const CommitGraph* graph) : m_graph(graph) {
+    if (m_graph) {
+        m_seenInGraph.resize(m_graph->size());
+    }
+}
+
+void RevWalk::push(const ObjectId& start) {
+    // A commit in the graph is queued without reading its object.
+    std::optional<uint32_t> pos = m_graph ? m_graph->find(start) : std::nullopt;
+    if (!pos) {
+        const std::optional<ObjectId> commit = peelToCommit(start);
+        if (!commit) {
+            throw std::runtime_error("object " + start.toHex() + " does not name a commit");
+        }
+        pos = m_graph ? m_graph->find(*commit) : std::nullopt;
+        if (!pos) {
+            pushParsedCommit(*commit);
+            return;
+        }
+    }
+    pushGraphCommit(*pos);
+}
+
+void RevWalk::setPaths(std::vector<std::string> paths) {
+    m_paths = std::move(paths);
+    m_bloomKeys.clear();
+    if (!m_graph || !m_graph->hasBloomFilters()) {
+        return;
+    }
+    // A filter holds every changed path and its leading directories, so a
+    // path may only have changed if all of these keys are in the filter.
+    for (const std::string& path : m_paths) {
+        std::vector<BloomKey>& keys = m_bloomKeys.emplace_back();
+        for (std::string_view prefix = path; !prefix.empty();) {
+            keys.emplace_back(prefix, m_graph->bloomSettings());
+            const size_t slash = prefix.rfind('/');
+            prefix = prefix.substr(0, slash == std::string_view::npos ? 0 : slash);
+        }
+    }
+}
+
+std::optional<ObjectId> RevWalk::next() {
+    while (!m_queue.empty()) {
+        const Entry entry = m_queue.top();
+        m_queue.pop();
+
+        m_parents.clear();
+        ObjectId tree;
+        if (entry.graphPos != NOT_IN_GRAPH) {
+            m_parentBuffer.clear();
+            if (!m_graph->parents(entry.graphPos, m_parentBuffer)) {
+                throw std::runtime_error("corrupt commit graph entry for " + entry.id.toHex());
+            }
+            for (uint32_t parent : m_parentBuffer) {
+                m_parents.push_back({parent, {}});
+            }
+            if (!m_paths.empty()) {
+                tree = m_graph->tree(entry.graphPos);
+            }
+        } else {
+            auto node = m_parsed.extract(entry.id);
+            tree = node.mapped().tree;
+            for (const ObjectId& parent : node.mapped().parents) {
+                std::optional<uint32_t> pos = m_graph ? m_graph->find(parent) : std::nullopt;
+                m_parents.push_back({pos.value_or(NOT_IN_GRAPH), parent});
+            }
+        }
+
+        const bool show = m_paths.empty() || simplify(entry, tree);
+        for (const Parent& parent : m_parents) {
+            if (parent.graphPos != NOT_IN_GRAPH) {
+                pushGraphCommit(parent.graphPos);
+            } else {
+                pushParsedCommit(parent.id);
+            }
+        }
+        if (show) {
+            return entry.id;
+        }
+    }
+    return std::nullopt;
+}
+
+bool RevWalk::simplify(const Entry& entry, const ObjectId& tree) {
+    if (m_parents.empty()) {
+        return pathsDiffer(std::nullopt, tree); // A root commit shows if it adds one of the paths.
+    }
+    for (size_t i = 0; i < m_parents.size(); ++i) {
+        // Filters describe the diff against the first parent only.
+        const bool same = (i == 0 && entry.graphPos != NOT_IN_GRAPH && bloomRulesOut(entry.graphPos)) ||
+                          !pathsDiffer(parentTree(m_parents[i]), tree);
+        if (same) {
+            const Parent kept = m_parents[i];
+            m_parents.assign(1, kept);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool RevWalk::bloomRulesOut(uint32_t pos) const {
+    if (m_bloomKeys.empty()) {
+        return false;
+    }
+    const std::span<const std::byte> filter = m_graph->bloomFilter(pos);
+    if (filter.empty()) {
+        return false;
+    }
+    return std::ranges::all_of(m_bloomKeys, [&](const std::vector<BloomKey>& keys) {
+        return std::ranges::any_of(keys, [&](const BloomKey& key) { return !key.mayBeIn(filter); });
+    });
+}
+
+bool RevWalk::pathsDiffer(const std::optional<ObjectId>& oldTree, const ObjectId& newTree) const {
+    return std::ranges::any_of(m_paths, [&](const std::string& path) { return pathDiffers(oldTree, newTree, path); });
+}
+
+ObjectId RevWalk::parentTree(const Parent& parent) {
+    return parent.graphPos != NOT_IN_GRAPH ? m_graph->tree(parent.graphPos) : parsedCommit(parent.id).tree;
+}
+
+void RevWalk::pushGraphCommit(uint32_t pos) {
+    if (m_seenInGraph[pos]) {
+        return;
+    }
+    m_seenInGraph[pos] = true;
+    m_queue.push({m_graph->commitTime(pos), m_graph->generation(pos), pos, m_sequence++, m_graph->id(pos)});
+}
+
+void RevWalk::pushParsedCommit(const ObjectId& id) {
+    if (!m_seen.insert(id).second) {
+        return;
+    }
+    // The date is needed to queue the commit, so it is parsed now and kept
+    // until it comes out of the queue.
+    m_queue.push({parsedCommit(id).commitTime, GENERATION_INFINITY, NOT_IN_GRAPH, m_sequence++, id});
+}
+
+const RevWalk::ParsedCommit& RevWalk::parsedCommit(const ObjectId& id) {
+    if (auto it = m_parsed.find(id); it != m_parsed.end()) {
+        return it->second;
+    }
+    auto object = readGitObject(id);
+    auto parts = object ? splitObject(*object) : std::nullopt;
+    auto commit = parts && parts->first == "commit" ? parseCommit(parts->second) : std::nullopt;
+    if (!commit) {
+        throw std::runtime_error("could not read commit " + id.toHex());
+    }
+    return m_parsed.emplace(id, ParsedCommit{commit->tree, std::move(commit->parents), commit->commitTime}).first->second;
+}
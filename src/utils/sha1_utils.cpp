@@ -1,39 +1,48 @@
 #include "../include/sha1_utils.h"
 #include <openssl/sha.h>
-#include <sstream>
-#include <iomanip>
+#include <openssl/evp.h>
 #include <stdexcept>
 #include <span>
 
-std::vector<std::byte> calculateSha1(std::span<const std::byte> data) {
-    std::vector<std::byte> hash(SHA_DIGEST_LENGTH);
+ObjectId calculateSha1(std::span<const std::byte> data) {
+    static_assert(ObjectId::SIZE == SHA_DIGEST_LENGTH);
+    ObjectId hash;
     SHA1(reinterpret_cast<const unsigned char*>(data.data()), data.size(),
-         reinterpret_cast<unsigned char*>(hash.data()));
+         reinterpret_cast<unsigned char*>(hash.bytes.data()));
     return hash;
 }
 
-std::string bytesToHex(std::span<const std::byte> bytes) {
-    std::ostringstream result;
-    result << std::hex << std::setfill('0');
-    for (const auto& byte : bytes) {
-        result << std::setw(2) << static_cast<unsigned int>(byte);
+Sha1Hasher::Sha1Hasher() : m_ctx(EVP_MD_CTX_new()) {
+    if (!m_ctx || EVP_DigestInit_ex(m_ctx, EVP_sha1(), nullptr) != 1) {
+        EVP_MD_CTX_free(m_ctx);
+        throw std::runtime_error("Failed to initialize SHA-1 context");
     }
-    return result.str();
 }
 
-std::string calculateSha1Hex(std::span<const std::byte> data) {
-    return bytesToHex(calculateSha1(data));
+Sha1Hasher::~Sha1Hasher() {
+    EVP_MD_CTX_free(m_ctx);
 }
 
-std::vector<std::byte> hexToBytes(const std::string& hex) {
-    if (hex.length() % 2 != 0) {
-        throw std::invalid_argument("Hex string must have an even number of characters");
-    }
-    std::vector<std::byte> bytes;
-    bytes.reserve(hex.length() / 2);
-    for (unsigned int i = 0; i < hex.length(); i += 2) {
-        std::string byteString = hex.substr(i, 2);
-        bytes.push_back(static_cast<std::byte>(std::stoul(byteString, nullptr, 16)));
+void Sha1Hasher::update(std::span<const std::byte> data) {
+    EVP_DigestUpdate(m_ctx, data.data(), data.size());
+}
+
+ObjectId Sha1Hasher::finish() {
+    ObjectId hash;
+    EVP_DigestFinal_ex(m_ctx, reinterpret_cast<unsigned char*>(hash.bytes.data()), nullptr);
+    return hash;
+}
+
+std::string bytesToHex(std::span<const std::byte> bytes) {
+    std::string result(bytes.size() * 2, '\0');
+    for (size_t i = 0; i < bytes.size(); ++i) {
+        auto value = static_cast<unsigned char>(bytes[i]);
+        result[2 * i] = object_id_detail::HEX_DIGITS[value >> 4];
+        result[2 * i + 1] = object_id_detail::HEX_DIGITS[value & 0x0F];
     }
-    return bytes;
-}
\ No newline at end of file
+    return result;
+}
+
+std::string calculateSha1Hex(std::span<const std::byte> data) {
+    return calculateSha1(data).toHex();
+}
@@ -0,0 +1,29 @@
+#include "../include/size_utils.h"
+
+#include <charconv>
+#include <limits>
+
+std::optional<size_t> parseByteSize(std::string_view text) {
+    size_t value = 0;
+    auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (ec != std::errc{} || end == text.data()) {
+        return std::nullopt;
+    }
+
+    std::string_view suffix(end, text.data() + text.size() - end);
+    size_t multiplier = 1;
+    if (suffix == "k" || suffix == "K") {
+        multiplier = size_t{1} << 10;
+    } else if (suffix == "m" || suffix == "M") {
+        multiplier = size_t{1} << 20;
+    } else if (suffix == "g" || suffix == "G") {
+        multiplier = size_t{1} << 30;
+    } else if (!suffix.empty()) {
+        return std::nullopt;
+    }
+
+    if (value > std::numeric_limits<size_t>::max() / multiplier) {
+        return std::nullopt;
+    }
+    return value * multiplier;
+}
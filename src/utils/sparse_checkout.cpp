@@ -0,0 +1,140 @@
+#include "../include/sparse_checkout.h"
+#include "../include/constants.h"
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+    // Drops leading and trailing slashes: "/src/utils/" becomes "src/utils".
+    std::string_view trimSlashes(std::string_view path) {
+        while (path.starts_with('/')) {
+            path.remove_prefix(1);
+        }
+        while (path.ends_with('/')) {
+            path.remove_suffix(1);
+        }
+        return path;
+    }
+}
+
+SparseCone::SparseCone(const std::vector<std::string>& directories) {
+    std::set<std::string, std::less<>> sorted;
+    for (const std::string& directory : directories) {
+        const std::string_view trimmed = trimSlashes(directory);
+        if (!trimmed.empty()) {
+            sorted.emplace(trimmed);
+        }
+    }
+    // A directory sorts after its ancestors, so one below a directory
+    // already kept in full is seen, and dropped, after it.
+    for (const std::string& directory : sorted) {
+        if (!underRecursive(directory)) {
+            m_recursive.insert(directory);
+        }
+    }
+    // Every ancestor of a listed directory keeps its own files, so a walk can reach it.
+    for (const std::string& directory : m_recursive) {
+        for (size_t slash = directory.find('/'); slash != std::string::npos; slash = directory.find('/', slash + 1)) {
+            m_parents.emplace(directory.substr(0, slash));
+        }
+    }
+}
+
+// Git writes these patterns for `sparse-checkout set A B/C`:
+//     /*        every file at the root,
+//     !/*/      but no directory;
+//     /B/       the files directly in B,
+//     !/B/*/    but none of its subdirectories;
+//     /A/       all of A;
+//     /B/C/     all of B/C.
+std::optional<SparseCone> SparseCone::parse(std::string_view patterns) {
+    std::set<std::string, std::less<>> positive;
+    std::set<std::string, std::less<>> parents;
+    while (!patterns.empty()) {
+        const size_t end = patterns.find('\n');
+        std::string_view line = patterns.substr(0, end);
+        patterns = end == std::string_view::npos ? std::string_view{} : patterns.substr(end + 1);
+        while (line.ends_with('\r') || line.ends_with(' ')) {
+            line.remove_suffix(1);
+        }
+        if (line.empty() || line.starts_with('#') || line == "/*" || line == "!/*/") {
+            continue;
+        }
+        if (line.starts_with("!/") && line.ends_with("/*/") && line.size() > 5) {
+            parents.emplace(line.substr(2, line.size() - 5)); // "!/B/*/": B keeps its files only.
+        } else if (line.starts_with('/') && line.ends_with('/') && line.size() > 2 &&
+                   line.find_first_of("*?[\\!") == std::string_view::npos) {
+            positive.emplace(line.substr(1, line.size() - 2)); // "/A/": A, unless it is a parent.
+        } else {
+            return std::nullopt;
+        }
+    }
+
+    std::vector<std::string> directories;
+    for (const std::string& directory : positive) {
+        if (!parents.contains(directory)) {
+            directories.push_back(directory);
+        }
+    }
+    return SparseCone(directories);
+}
+
+std::optional<SparseCone> SparseCone::load() {
+    std::ifstream file(constants::SPARSE_CHECKOUT_FILE, std::ios::binary);
+    if (!file) {
+        return std::nullopt;
+    }
+    std::ostringstream contents;
+    contents << file.rdbuf();
+    auto cone = parse(contents.str());
+    if (!cone) {
+        throw std::runtime_error(constants::SPARSE_CHECKOUT_FILE.string() + " does not hold cone-mode patterns");
+    }
+    return cone;
+}
+
+bool SparseCone::save() const {
+    std::error_code ec;
+    std::filesystem::create_directories(constants::SPARSE_CHECKOUT_FILE.parent_path(), ec);
+    std::ofstream file(constants::SPARSE_CHECKOUT_FILE, std::ios::binary | std::ios::trunc);
+    return file << toPatterns() && file.flush();
+}
+
+std::string SparseCone::toPatterns() const {
+    // The same layout as Git: the parents, then the directories kept in full.
+    std::string patterns = "/*\n!/*/\n";
+    for (const std::string& directory : m_parents) {
+        patterns.append("/").append(directory).append("/\n!/").append(directory).append("/*/\n");
+    }
+    for (const std::string& directory : m_recursive) {
+        patterns.append("/").append(directory).append("/\n");
+    }
+    return patterns;
+}
+
+bool SparseCone::includesDirectory(std::string_view directory) const {
+    return m_parents.contains(directory) || underRecursive(directory);
+}
+
+bool SparseCone::includesFile(std::string_view path) const {
+    const size_t slash = path.rfind('/');
+    if (slash == std::string_view::npos) {
+        return true; // Files at the root are always checked out.
+    }
+    const std::string_view directory = path.substr(0, slash);
+    return m_parents.contains(directory) || underRecursive(directory);
+}
+
+bool SparseCone::underRecursive(std::string_view directory) const {
+    while (true) {
+        if (m_recursive.contains(directory)) {
+            return true;
+        }
+        const size_t slash = directory.rfind('/');
+        if (slash == std::string_view::npos) {
+            return false;
+        }
+        directory = directory.substr(0, slash);
+    }
+}
@@ -0,0 +1,232 @@
+#include "../include/stat_cache.h"
+#include "../include/object_utils.h"
+#include "../include/sha1_utils.h"
+
+#include <sys/stat.h>
+
+#include <cstring>
+#include <fstream>
+
+namespace {
+    // Layout: header, blob records, tree records, then a SHA-1 of everything before it.
+    // Blob record: ctime s/ns, mtime s/ns, inode, size, mode, SHA, path length, path.
+    // Tree record: entry count, SHA, path length, path.
+    constexpr unsigned char MAGIC[] = {'M', 'G', 'S', 'C'};
+    constexpr uint32_t VERSION = 1;
+    constexpr size_t HEADER_SIZE = 16;
+    constexpr size_t SHA_SIZE = 20;
+    constexpr size_t BLOB_FIXED_SIZE = 8 + 4 + 8 + 4 + 8 + 8 + 4 + SHA_SIZE + 2;
+    constexpr size_t TREE_FIXED_SIZE = 4 + SHA_SIZE + 2;
+
+    uint16_t readBigEndian16(const std::byte* p) {
+        return static_cast<uint16_t>((static_cast<uint16_t>(p[0]) << 8) | static_cast<uint16_t>(p[1]));
+    }
+
+    uint32_t readBigEndian32(const std::byte* p) {
+        return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+               (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+    }
+
+    uint64_t readBigEndian64(const std::byte* p) {
+        return (static_cast<uint64_t>(readBigEndian32(p)) << 32) | readBigEndian32(p + 4);
+    }
+
+    void appendBigEndian16(std::vector<std::byte>& out, uint16_t value) {
+        out.push_back(static_cast<std::byte>(value >> 8));
+        out.push_back(static_cast<std::byte>(value));
+    }
+
+    void appendBigEndian32(std::vector<std::byte>& out, uint32_t value) {
+        out.push_back(static_cast<std::byte>(value >> 24));
+        out.push_back(static_cast<std::byte>(value >> 16));
+        out.push_back(static_cast<std::byte>(value >> 8));
+        out.push_back(static_cast<std::byte>(value));
+    }
+
+    void appendBigEndian64(std::vector<std::byte>& out, uint64_t value) {
+        appendBigEndian32(out, static_cast<uint32_t>(value >> 32));
+        appendBigEndian32(out, static_cast<uint32_t>(value));
+    }
+
+    void appendPath(std::vector<std::byte>& out, const std::string& path) {
+        appendBigEndian16(out, static_cast<uint16_t>(path.size()));
+        auto bytes = std::as_bytes(std::span{path});
+        out.insert(out.end(), bytes.begin(), bytes.end());
+    }
+
+    FileStat readFileStat(const std::byte* p) {
+        FileStat stat;
+        stat.ctimeSec = static_cast<int64_t>(readBigEndian64(p));
+        stat.ctimeNsec = readBigEndian32(p + 8);
+        stat.mtimeSec = static_cast<int64_t>(readBigEndian64(p + 12));
+        stat.mtimeNsec = readBigEndian32(p + 20);
+        stat.inode = readBigEndian64(p + 24);
+        stat.size = readBigEndian64(p + 32);
+        stat.mode = readBigEndian32(p + 40);
+        return stat;
+    }
+
+    // Reads the variable-length path of a record whose fixed part is `fixedSize` bytes long.
+    // Returns false if the record runs past `end`.
+    bool readRecordPath(const std::byte*& p, const std::byte* end, size_t fixedSize, std::string_view& path) {
+        if (static_cast<size_t>(end - p) < fixedSize) return false;
+        size_t length = readBigEndian16(p + fixedSize - 2);
+        if (static_cast<size_t>(end - p) < fixedSize + length) return false;
+        path = std::string_view(reinterpret_cast<const char*>(p + fixedSize), length);
+        p += fixedSize + length;
+        return true;
+    }
+}
+
+std::optional<FileStat> statFile(const std::filesystem::path& path) {
+    struct stat st;
+    if (::stat(path.c_str(), &st) != 0) {
+        return std::nullopt;
+    }
+    FileStat stat;
+    stat.ctimeSec = st.st_ctim.tv_sec;
+    stat.ctimeNsec = static_cast<uint32_t>(st.st_ctim.tv_nsec);
+    stat.mtimeSec = st.st_mtim.tv_sec;
+    stat.mtimeNsec = static_cast<uint32_t>(st.st_mtim.tv_nsec);
+    stat.inode = st.st_ino;
+    stat.size = static_cast<uint64_t>(st.st_size);
+    stat.mode = st.st_mode;
+    return stat;
+}
+
+// =========================================================================
+// StatCache
+// =========================================================================
+
+StatCache StatCache::load(const std::filesystem::path& path) {
+    StatCache cache;
+    auto cacheStat = statFile(path);
+    auto file = MappedFile::open(path);
+    if (!cacheStat || !file) {
+        return cache;
+    }
+
+    auto bytes = file->bytes();
+    if (bytes.size() < HEADER_SIZE + SHA_SIZE || std::memcmp(bytes.data(), MAGIC, 4) != 0 ||
+        readBigEndian32(bytes.data() + 4) != VERSION) {
+        return cache;
+    }
+    auto body = bytes.first(bytes.size() - SHA_SIZE);
+    auto checksum = calculateSha1(body);
+    if (!std::equal(checksum.bytes.begin(), checksum.bytes.end(), bytes.end() - SHA_SIZE)) {
+        return cache;
+    }
+
+    uint32_t blobCount = readBigEndian32(bytes.data() + 8);
+    uint32_t treeCount = readBigEndian32(bytes.data() + 12);
+    cache.m_blobs.reserve(blobCount);
+    cache.m_trees.reserve(treeCount);
+    const std::byte* p = body.data() + HEADER_SIZE;
+    const std::byte* end = body.data() + body.size();
+    std::string_view recordPath;
+    for (uint32_t i = 0; i < blobCount; ++i) {
+        const std::byte* record = p;
+        if (!readRecordPath(p, end, BLOB_FIXED_SIZE, recordPath)) return StatCache{};
+        cache.m_blobs.emplace(recordPath, record);
+    }
+    for (uint32_t i = 0; i < treeCount; ++i) {
+        const std::byte* record = p;
+        if (!readRecordPath(p, end, TREE_FIXED_SIZE, recordPath)) return StatCache{};
+        cache.m_trees.emplace(recordPath, record);
+    }
+
+    // The views above point into the mapping, which moves along with its owner.
+    cache.m_file = std::move(file);
+    cache.m_cacheMtimeSec = cacheStat->mtimeSec;
+    cache.m_cacheMtimeNsec = cacheStat->mtimeNsec;
+    return cache;
+}
+
+std::optional<ObjectId> StatCache::findBlob(std::string_view path, const FileStat& stat) const {
+    auto it = m_blobs.find(path);
+    if (it == m_blobs.end() || readFileStat(it->second) != stat) {
+        return std::nullopt;
+    }
+    // A file modified no earlier than the cache was written may have changed
+    // again within the same timestamp, so it is rehashed.
+    if (stat.mtimeSec > m_cacheMtimeSec || (stat.mtimeSec == m_cacheMtimeSec && stat.mtimeNsec >= m_cacheMtimeNsec)) {
+        return std::nullopt;
+    }
+    return ObjectId::fromBytes(std::span<const std::byte>(it->second + BLOB_FIXED_SIZE - 2 - SHA_SIZE, SHA_SIZE));
+}
+
+std::optional<StatCache::CachedTree> StatCache::findTree(std::string_view path) const {
+    auto it = m_trees.find(path);
+    if (it == m_trees.end()) {
+        return std::nullopt;
+    }
+    return CachedTree{readBigEndian32(it->second), ObjectId::fromBytes(std::span<const std::byte>(it->second + 4, SHA_SIZE))};
+}
+
+// =========================================================================
+// StatCacheWriter
+// =========================================================================
+
+void StatCacheWriter::addBlob(std::string path, const FileStat& stat, const ObjectId& sha) {
+    appendBigEndian64(m_blobs, static_cast<uint64_t>(stat.ctimeSec));
+    appendBigEndian32(m_blobs, stat.ctimeNsec);
+    appendBigEndian64(m_blobs, static_cast<uint64_t>(stat.mtimeSec));
+    appendBigEndian32(m_blobs, stat.mtimeNsec);
+    appendBigEndian64(m_blobs, stat.inode);
+    appendBigEndian64(m_blobs, stat.size);
+    appendBigEndian32(m_blobs, stat.mode);
+    m_blobs.insert(m_blobs.end(), sha.bytes.begin(), sha.bytes.end());
+    appendPath(m_blobs, path);
+    ++m_blobCount;
+}
+
+void StatCacheWriter::addTree(std::string path, uint32_t entryCount, const ObjectId& sha) {
+    appendBigEndian32(m_trees, entryCount);
+    m_trees.insert(m_trees.end(), sha.bytes.begin(), sha.bytes.end());
+    appendPath(m_trees, path);
+    ++m_treeCount;
+}
+
+bool StatCacheWriter::write(const std::filesystem::path& path) const {
+    // The cache names blobs and trees by SHA, and the next write-tree trusts
+    // them: under --fsync=batch, those objects must be durable and in place
+    // before the cache is.
+    try {
+        flushObjectWrites();
+    } catch (const std::exception&) {
+        return false;
+    }
+
+    std::vector<std::byte> out;
+    out.reserve(HEADER_SIZE + m_blobs.size() + m_trees.size() + SHA_SIZE);
+    for (unsigned char c : MAGIC) out.push_back(static_cast<std::byte>(c));
+    appendBigEndian32(out, VERSION);
+    appendBigEndian32(out, m_blobCount);
+    appendBigEndian32(out, m_treeCount);
+    out.insert(out.end(), m_blobs.begin(), m_blobs.end());
+    out.insert(out.end(), m_trees.begin(), m_trees.end());
+    auto checksum = calculateSha1(out);
+    out.insert(out.end(), checksum.bytes.begin(), checksum.bytes.end());
+
+    // Readers only ever see a complete cache.
+    std::filesystem::path tmpPath = path;
+    tmpPath += ".lock";
+    {
+        std::ofstream outFile(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!outFile) {
+            return false;
+        }
+        outFile.write(reinterpret_cast<const char*>(out.data()), out.size());
+        if (!outFile.flush()) {
+            return false;
+        }
+    }
+    try {
+        syncFileForPolicy(tmpPath);
+    } catch (const std::exception&) {
+        return false;
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmpPath, path, ec);
+    return !ec;
+}
@@ -0,0 +1,188 @@
+#include "../include/tree_diff.h"
+#include "../include/object_utils.h"
+#include "../include/tree_parser.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace {
+    // A tree read through the object cache, with its entries' view.
+    struct LoadedTree {
+        ObjectCache::Value object;
+        std::span<const std::byte> content;
+    };
+
+    LoadedTree loadTree(const ObjectId& id) {
+        LoadedTree tree{readCachedGitObject(id), {}};
+        if (!tree.object) {
+            throw std::runtime_error("could not read tree " + id.toHex());
+        }
+        std::span<const std::byte> object = *tree.object;
+        auto nullPos = findNullSeparator(object);
+        const std::string_view header(reinterpret_cast<const char*>(object.data()), std::distance(object.begin(), nullPos));
+        if (nullPos == object.end() || !header.starts_with("tree ")) {
+            throw std::runtime_error("not a tree object: " + id.toHex());
+        }
+        tree.content = object.subspan(std::distance(object.begin(), nullPos) + 1);
+        return tree;
+    }
+
+    // Orders entries as Git sorts them: a tree's name compares as if it ended with '/'.
+    int compareEntries(const TreeEntryView& a, const TreeEntryView& b) {
+        const size_t common = std::min(a.name.size(), b.name.size());
+        if (int cmp = std::memcmp(a.name.data(), b.name.data(), common)) {
+            return cmp;
+        }
+        const auto next = [common](const TreeEntryView& entry) -> unsigned char {
+            return entry.name.size() > common ? static_cast<unsigned char>(entry.name[common]) : entry.isTree() ? '/' : '\0';
+        };
+        return static_cast<int>(next(a)) - static_cast<int>(next(b));
+    }
+
+    // Blobs and executables are both regular files; anything else is its own kind.
+    bool sameKind(const TreeEntryView& a, const TreeEntryView& b) {
+        const auto regular = [](TreeEntryType type) { return type == TreeEntryType::Blob || type == TreeEntryType::Executable; };
+        return a.type == b.type || (regular(a.type) && regular(b.type));
+    }
+
+    /**
+     * @class TreeDiffer
+     * @brief Walks two trees side by side, keeping the current path in one string.
+     */
+    class TreeDiffer {
+    public:
+        TreeDiffer(const TreeDiffOptions& options, const TreeChangeCallback& callback)
+            : m_options(options), m_callback(callback) {}
+
+        // Diffs two trees whose entries are named relative to m_path. Returns false once stopped.
+        bool diff(const ObjectId* oldId, const ObjectId* newId) {
+            LoadedTree oldTree = oldId ? loadTree(*oldId) : LoadedTree{};
+            LoadedTree newTree = newId ? loadTree(*newId) : LoadedTree{};
+            TreeView oldView(oldTree.content);
+            TreeView newView(newTree.content);
+            auto oldIt = oldView.begin();
+            auto newIt = newView.begin();
+
+            while (oldIt != oldView.end() || newIt != newView.end()) {
+                const int cmp = oldIt == oldView.end() ? 1 : newIt == newView.end() ? -1 : compareEntries(*oldIt, *newIt);
+                bool keepGoing;
+                if (cmp < 0) {
+                    keepGoing = oneSided(*oldIt, 'D');
+                    ++oldIt;
+                } else if (cmp > 0) {
+                    keepGoing = oneSided(*newIt, 'A');
+                    ++newIt;
+                } else {
+                    keepGoing = bothSides(*oldIt, *newIt);
+                    ++oldIt;
+                    ++newIt;
+                }
+                if (!keepGoing) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+    private:
+        // An entry present on one side only: a deletion or an addition.
+        bool oneSided(const TreeEntryView& entry, char status) {
+            const size_t length = m_path.size();
+            m_path.append(entry.name);
+            TreeChange change{status, m_path, {}, {}, {}, {}};
+            (status == 'D' ? change.oldMode : change.newMode) = entry.mode;
+            (status == 'D' ? change.oldId : change.newId) = entry.id();
+
+            bool keepGoing = true;
+            const bool descend = entry.isTree() && shouldDescend();
+            if (!descend || m_options.showTrees) {
+                keepGoing = m_callback(change);
+            }
+            if (keepGoing && descend) {
+                const ObjectId id = entry.id();
+                m_path.push_back('/');
+                keepGoing = status == 'D' ? diff(&id, nullptr) : diff(nullptr, &id);
+            }
+            m_path.resize(length);
+            return keepGoing;
+        }
+
+        // An entry with the same name and kind on both sides.
+        bool bothSides(const TreeEntryView& oldEntry, const TreeEntryView& newEntry) {
+            if (std::memcmp(oldEntry.sha.data(), newEntry.sha.data(), ObjectId::SIZE) == 0 && oldEntry.mode == newEntry.mode) {
+                return true; // Identical, down to every file below it.
+            }
+            const size_t length = m_path.size();
+            m_path.append(newEntry.name);
+            const TreeChange change{sameKind(oldEntry, newEntry) ? 'M' : 'T', m_path, oldEntry.mode, newEntry.mode,
+                                    oldEntry.id(), newEntry.id()};
+
+            bool keepGoing = true;
+            const bool descend = newEntry.isTree() && shouldDescend();
+            if (!descend || m_options.showTrees) {
+                keepGoing = m_callback(change);
+            }
+            if (keepGoing && descend) {
+                m_path.push_back('/');
+                keepGoing = diff(&change.oldId, &change.newId);
+            }
+            m_path.resize(length);
+            return keepGoing;
+        }
+
+        // Whether to enter the subtree at m_path.
+        bool shouldDescend() const {
+            return m_options.recursive && (!m_options.descendInto || m_options.descendInto(m_path));
+        }
+
+        const TreeDiffOptions& m_options;
+        const TreeChangeCallback& m_callback;
+        std::string m_path;
+    };
+
+    // Returns the entry of a tree with the given name, as (mode, id).
+    std::optional<std::pair<std::string, ObjectId>> findEntry(const ObjectId& treeId, std::string_view name) {
+        LoadedTree tree = loadTree(treeId);
+        for (const auto& entry : TreeView(tree.content)) {
+            if (entry.name == name) {
+                return std::pair{std::string(entry.mode), entry.id()};
+            }
+        }
+        return std::nullopt;
+    }
+}
+
+bool diffTrees(const std::optional<ObjectId>& oldTree, const std::optional<ObjectId>& newTree,
+               const TreeDiffOptions& options, const TreeChangeCallback& callback) {
+    if (oldTree == newTree) {
+        return true;
+    }
+    TreeDiffer differ(options, callback);
+    return differ.diff(oldTree ? &*oldTree : nullptr, newTree ? &*newTree : nullptr);
+}
+
+bool pathDiffers(std::optional<ObjectId> oldTree, std::optional<ObjectId> newTree, std::string_view path) {
+    while (true) {
+        if (oldTree == newTree) {
+            return false; // Same subtree, or absent on both sides.
+        }
+        const size_t slash = path.find('/');
+        const std::string_view name = path.substr(0, slash);
+        auto oldEntry = oldTree ? findEntry(*oldTree, name) : std::nullopt;
+        auto newEntry = newTree ? findEntry(*newTree, name) : std::nullopt;
+        if (slash == std::string_view::npos) {
+            return oldEntry != newEntry;
+        }
+
+        // Only a directory can hold the rest of the path.
+        const auto subtree = [](const auto& entry) {
+            return entry && classifyTreeEntryMode(entry->first) == TreeEntryType::Tree ? std::optional(entry->second)
+                                                                                       : std::nullopt;
+        };
+        oldTree = subtree(oldEntry);
+        newTree = subtree(newEntry);
+        path = path.substr(slash + 1);
+    }
+}
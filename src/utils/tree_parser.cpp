@@ -1,34 +1,42 @@
 #include "../include/tree_parser.h"
-#include <iostream>
-#include <algorithm>
-#include <span>
+#include "../include/constants.h"
 
-std::optional<std::vector<TreeEntry>> parseTreeObject(std::span<const std::byte> treeContent) {
-    std::vector<TreeEntry> entries;
-    auto current = treeContent.begin();
+#include <cstring>
+#include <stdexcept>
 
-    while (current != treeContent.end()) {
-        TreeEntry entry;
+TreeEntryType classifyTreeEntryMode(std::string_view mode) {
+    if (mode == constants::MODE_BLOB) return TreeEntryType::Blob;
+    if (mode == constants::MODE_TREE) return TreeEntryType::Tree;
+    if (mode == "100755") return TreeEntryType::Executable;
+    if (mode == "120000") return TreeEntryType::Symlink;
+    if (mode == "160000") return TreeEntryType::Submodule;
+    return TreeEntryType::Unknown;
+}
 
-        // Find space after mode
-        auto spacePos = std::find(current, treeContent.end(), std::byte{' '});
-        if (spacePos == treeContent.end()) return std::nullopt; // Malformed
-        entry.mode = std::string(reinterpret_cast<const char*>(&*current), std::distance(current, spacePos));
+void TreeView::iterator::advance() {
+    if (m_rest.empty()) {
+        m_atEnd = true;
+        return;
+    }
+    const char* begin = reinterpret_cast<const char*>(m_rest.data());
+    const size_t size = m_rest.size();
 
-        // Find null after filename
-        auto nullPos = std::find(spacePos + 1, treeContent.end(), std::byte{0});
-        if (nullPos == treeContent.end()) return std::nullopt; // Malformed
-        entry.filename = std::string(reinterpret_cast<const char*>(&*(spacePos + 1)), std::distance(spacePos + 1, nullPos));
+    // Find space after mode
+    auto* space = static_cast<const char*>(std::memchr(begin, ' ', size));
+    if (!space) throw std::runtime_error("Malformed tree entry: missing space after the mode");
 
-        // SHA1 is the next 20 bytes
-        auto shaStart = nullPos + 1;
-        if (std::distance(shaStart, treeContent.end()) < 20) return std::nullopt; // Not enough bytes for SHA
-        auto shaEnd = shaStart + 20;
-        entry.sha1Bytes.assign(shaStart, shaEnd);
-        
-        entries.push_back(entry);
-        current = shaEnd;
-    }
+    // Find null after filename
+    size_t nameStart = static_cast<size_t>(space - begin) + 1;
+    auto* null = static_cast<const char*>(std::memchr(space + 1, '\0', size - nameStart));
+    if (!null) throw std::runtime_error("Malformed tree entry: missing null after the name");
+
+    // SHA1 is the next 20 bytes
+    size_t shaStart = static_cast<size_t>(null - begin) + 1;
+    if (size - shaStart < ObjectId::SIZE) throw std::runtime_error("Malformed tree entry: truncated SHA");
 
-    return entries;
-}
\ No newline at end of file
+    m_entry.mode = std::string_view(begin, static_cast<size_t>(space - begin));
+    m_entry.name = std::string_view(space + 1, static_cast<size_t>(null - space - 1));
+    m_entry.sha = m_rest.subspan(shaStart, ObjectId::SIZE);
+    m_entry.type = classifyTreeEntryMode(m_entry.mode);
+    m_rest = m_rest.subspan(shaStart + ObjectId::SIZE);
+}
@@ -1,35 +1,27 @@
 #include "../include/zlib_utils.h"
 #include <zlib.h>
 #include <span>
+#include <stdexcept>
+#include <algorithm>
 
 
 bool decompressZlib(std::span<const std::byte> input, std::vector<std::byte>& output) {
-    // Start with a reasonable guess for the output size.
-    // Git objects often have good compression, so 3x is a safe starting point.
-    size_t output_size = input.size() * 3;
-    if (output_size < 1024) output_size = 1024; // Minimum buffer size
-    output.resize(output_size);
-
-    while (true) {
-        uLongf destLen = output.size();
-        int res = uncompress(
-            reinterpret_cast<Bytef*>(output.data()), &destLen,
-            reinterpret_cast<const Bytef*>(input.data()), input.size()
-        );
-
-        if (res == Z_OK) {
-            output.resize(destLen); // Shrink buffer to actual decompressed size
-            return true;
-        }
-
-        if (res == Z_BUF_ERROR) {
-            // Output buffer was too small. Double it and try again.
-            if (output.size() > 10 * 1024 * 1024) return false; // Safety break for huge files
+    // Start with a reasonable guess for the output size and double it
+    // whenever it fills up. Inflating resumes where it stopped.
+    output.resize(std::max<size_t>(input.size() * 3, 1024));
+    try {
+        ZlibInflateStream stream(input);
+        size_t produced = 0;
+        while (true) {
+            produced += stream.read(std::span<std::byte>(output).subspan(produced));
+            if (stream.finished()) break;
             output.resize(output.size() * 2);
-        } else {
-            // Some other zlib error occurred
-            return false;
         }
+        output.resize(produced); // Shrink buffer to actual decompressed size
+        return true;
+    } catch (const std::exception&) {
+        // Corrupt or truncated data.
+        return false;
     }
 }
 
@@ -49,4 +41,97 @@ bool compressZlib(std::span<const std::byte> input, std::vector<std::byte>& outp
 
     output.resize(destLen); // Shrink buffer to actual compressed size
     return true;
-}
\ No newline at end of file
+}
+
+static constexpr size_t DEFLATE_CHUNK_SIZE = 64 * 1024;
+
+ZlibDeflateStream::ZlibDeflateStream(Sink sink)
+    : m_sink(std::move(sink)), m_out(DEFLATE_CHUNK_SIZE), m_zstream(std::make_unique<z_stream>()) {
+    if (deflateInit(m_zstream.get(), Z_DEFAULT_COMPRESSION) != Z_OK) {
+        throw std::runtime_error("zlib deflateInit failed.");
+    }
+}
+
+ZlibDeflateStream::~ZlibDeflateStream() {
+    deflateEnd(m_zstream.get());
+}
+
+void ZlibDeflateStream::write(std::span<const std::byte> data) {
+    // avail_in is 32-bit, so huge spans are fed in slices.
+    constexpr size_t MAX_SLICE = size_t{1} << 30;
+    while (!data.empty()) {
+        size_t take = std::min(data.size(), MAX_SLICE);
+        deflateInto(data.first(take), Z_NO_FLUSH);
+        data = data.subspan(take);
+    }
+}
+
+void ZlibDeflateStream::finish() {
+    deflateInto({}, Z_FINISH);
+}
+
+void ZlibDeflateStream::deflateInto(std::span<const std::byte> data, int flush) {
+    z_stream& strm = *m_zstream;
+    strm.next_in = reinterpret_cast<Bytef*>(const_cast<std::byte*>(data.data()));
+    strm.avail_in = static_cast<uInt>(data.size());
+
+    // With Z_NO_FLUSH, deflate is done once it has consumed all the input and
+    // left room in the buffer; with Z_FINISH, once it reports the stream end.
+    int ret;
+    do {
+        strm.next_out = reinterpret_cast<Bytef*>(m_out.data());
+        strm.avail_out = static_cast<uInt>(m_out.size());
+        ret = deflate(&strm, flush);
+        if (ret == Z_STREAM_ERROR) {
+            throw std::runtime_error("zlib deflate failed.");
+        }
+        size_t produced = m_out.size() - strm.avail_out;
+        if (produced > 0) {
+            m_sink(std::span<const std::byte>(m_out.data(), produced));
+        }
+    } while (flush == Z_FINISH ? ret != Z_STREAM_END : strm.avail_out == 0);
+}
+
+
+ZlibInflateStream::ZlibInflateStream(std::span<const std::byte> input) : m_zstream(std::make_unique<z_stream>()) {
+    m_zstream->next_in = reinterpret_cast<Bytef*>(const_cast<std::byte*>(input.data()));
+    m_zstream->avail_in = static_cast<uInt>(input.size());
+    if (inflateInit(m_zstream.get()) != Z_OK) {
+        throw std::runtime_error("zlib inflateInit failed.");
+    }
+}
+
+ZlibInflateStream::ZlibInflateStream(InputSource source)
+    : ZlibInflateStream(std::span<const std::byte>{}) {
+    m_source = std::move(source);
+}
+
+ZlibInflateStream::~ZlibInflateStream() {
+    inflateEnd(m_zstream.get());
+}
+
+size_t ZlibInflateStream::read(std::span<std::byte> out) {
+    z_stream& strm = *m_zstream;
+    size_t produced = 0;
+    while (produced < out.size() && !m_finished) {
+        if (strm.avail_in == 0 && m_source) {
+            auto input = m_source();
+            strm.next_in = reinterpret_cast<Bytef*>(const_cast<std::byte*>(input.data()));
+            strm.avail_in = static_cast<uInt>(input.size());
+        }
+        // avail_out is 32-bit, so huge buffers are filled in slices.
+        size_t slice = std::min<size_t>(out.size() - produced, size_t{1} << 30);
+        strm.next_out = reinterpret_cast<Bytef*>(out.data() + produced);
+        strm.avail_out = static_cast<uInt>(slice);
+        int ret = inflate(&strm, Z_NO_FLUSH);
+        produced += slice - strm.avail_out;
+        if (ret == Z_STREAM_END) {
+            m_finished = true;
+        } else if (ret == Z_BUF_ERROR && strm.avail_in == 0) {
+            throw std::runtime_error("zlib stream is truncated.");
+        } else if (ret != Z_OK && ret != Z_BUF_ERROR) {
+            throw std::runtime_error("zlib inflate failed: error code " + std::to_string(ret));
+        }
+    }
+    return produced;
+}
@@ -16,11 +16,69 @@ actual=$($MYGIT_EXEC cat-file -p "$sha" | tail -n 1)
 
 if [ "$expected" == "$actual" ]; then
     echo -e "${GREEN}[PASS] cat-file displays correct content${NC}"
-    cd ..
-    rm -rf tmp_test
 else
     echo -e "${RED}[FAIL] cat-file mismatch${NC}"
     echo -e "${YELLOW}Expected: $expected${NC}"
     echo -e "${YELLOW}Actual:   $actual${NC}"
     exit 1
 fi
+
+# A loose object well above 10 MB, written by git itself.
+git init --quiet
+seq 1 3000000 > large.txt
+sha=$(git hash-object -w large.txt)
+
+if $MYGIT_EXEC cat-file -p "$sha" | cmp -s - large.txt; then
+    echo -e "${GREEN}[PASS] cat-file reads a large loose object${NC}"
+else
+    echo -e "${RED}[FAIL] cat-file cannot read a large loose object${NC}"
+    exit 1
+fi
+
+# -t and -s must agree with git for every object, loose and then packed as deltas.
+for i in 1 2 3 4 5; do
+    seq 1 $((i * 1000)) > file.txt
+    git add file.txt large.txt
+    git -c user.name=test -c user.email=test@example.com commit --quiet -m "commit $i"
+done
+
+check_type_and_size() {
+    for object in $(git cat-file --batch-all-objects --batch-check='%(objectname)'); do
+        for option in -t -s; do
+            if [ "$($MYGIT_EXEC cat-file $option "$object")" != "$(git cat-file $option "$object")" ]; then
+                echo -e "${RED}[FAIL] cat-file $option $object differs from git ($1)${NC}"
+                exit 1
+            fi
+        done
+    done
+    echo -e "${GREEN}[PASS] cat-file -t and -s match git ($1)${NC}"
+}
+
+check_type_and_size "loose objects"
+git repack -a -d -f --quiet
+check_type_and_size "packed objects with deltas"
+
+# Batch modes answer a list of names, repeats and unknown ones included, exactly like git.
+git cat-file --batch-all-objects --batch-check='%(objectname)' > objects.txt
+{ cat objects.txt; echo 0123456789012345678901234567890123456789; cat objects.txt; } > names.txt
+for mode in --batch --batch-check; do
+    if cmp -s <($MYGIT_EXEC cat-file $mode < names.txt) <(git cat-file $mode < names.txt); then
+        echo -e "${GREEN}[PASS] cat-file $mode matches git${NC}"
+    else
+        echo -e "${RED}[FAIL] cat-file $mode differs from git${NC}"
+        exit 1
+    fi
+done
+
+# A cache too small to hold anything, or none at all, changes speed, never output.
+for size in 0 4k; do
+    if cmp -s <($MYGIT_EXEC --object-cache-size=$size cat-file --batch < names.txt) <(git cat-file --batch < names.txt); then
+        echo -e "${GREEN}[PASS] cat-file --batch with a $size object cache matches git${NC}"
+    else
+        echo -e "${RED}[FAIL] cat-file --batch with a $size object cache differs from git${NC}"
+        exit 1
+    fi
+done
+
+cd ..
+rm -rf tmp_test
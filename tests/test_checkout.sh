@@ -0,0 +1,107 @@
+#!/bin/bash
+set -e
+
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+YELLOW='\033[1;33m'
+NC='\033[0m'
+
+echo -e "${YELLOW}🧪 Testing: checkout${NC}"
+
+rm -rf tmp_test && mkdir tmp_test && cd tmp_test
+
+git init -q
+export GIT_AUTHOR_NAME="A U Thor" GIT_AUTHOR_EMAIL=author@example.com
+export GIT_COMMITTER_NAME="C O Mitter" GIT_COMMITTER_EMAIL=committer@example.com
+
+# Commit "two" modifies a deep file, changes a mode, turns a directory into
+# a file and a file into a directory, turns a symlink into a file and a file
+# into a symlink, and adds and deletes whole directories.
+mkdir -p a/b/c d e same
+echo 1 > a/b/c/f && echo 1 > a/g && echo 1 > d/h && echo 1 > e/i && echo 1 > same/s
+echo 1 > top && echo 1 > a.txt && echo 1 > plain && ln -s top link
+git add -A && git commit -q -m one
+git branch one
+
+echo 2 > a/b/c/f && chmod +x a/g
+rm -rf d && echo d > d
+rm top && mkdir top && echo t > top/x
+rm link && echo not-a-link > link
+rm plain && ln -s a.txt plain
+mkdir new && echo n > new/n
+rm e/i && echo j > e/j && rm a.txt
+git add -A && git commit -q -m two
+git branch two
+two=$(git rev-parse HEAD)
+
+# Passes if the working directory holds exactly the tree of HEAD, plus the
+# untracked files given as arguments.
+expect_clean() {
+    git reset -q # Git's index still describes the previous commit.
+    local expected=""
+    for path in "$@"; do expected+="?? $path"$'\n'; done
+    if ! diff <(printf "%s" "$expected") <(git status --porcelain --untracked-files=all); then
+        echo -e "${RED}[FAIL] $1${NC}"
+        exit 1
+    fi
+}
+
+git checkout -q one
+touch -d "2001-01-01" same/s
+echo untracked > e/untracked
+
+$MYGIT_EXEC checkout two > /dev/null
+[ "$(cat .git/HEAD)" == "ref: refs/heads/two" ] || { echo -e "${RED}[FAIL] HEAD is not on branch two${NC}"; exit 1; }
+expect_clean e/untracked
+[ "$(stat -c %Y same/s)" == "$(date -d 2001-01-01 +%s)" ] || { echo -e "${RED}[FAIL] an unchanged file was rewritten${NC}"; exit 1; }
+echo -e "${GREEN}[PASS] checkout switches branches and only touches what changed${NC}"
+
+$MYGIT_EXEC checkout "$(git rev-parse one)" > /dev/null
+[ "$(cat .git/HEAD)" == "$(git rev-parse one)" ] || { echo -e "${RED}[FAIL] HEAD is not detached at one${NC}"; exit 1; }
+expect_clean e/untracked
+[ -d new ] && { echo -e "${RED}[FAIL] an emptied directory was kept${NC}"; exit 1; }
+echo -e "${GREEN}[PASS] checkout of a SHA detaches HEAD and removes emptied directories${NC}"
+
+# A local change to a file the checkout replaces stops it before anything
+# is written; -f overwrites it.
+echo local > a/b/c/f
+if $MYGIT_EXEC checkout two 2> err.log; then
+    echo -e "${RED}[FAIL] checkout overwrote a local change${NC}"
+    exit 1
+fi
+grep -q "a/b/c/f" err.log || { echo -e "${RED}[FAIL] the local change is not reported${NC}"; exit 1; }
+rm err.log
+[ "$(cat a/b/c/f)" == "local" ] && [ -f top ] || { echo -e "${RED}[FAIL] a refused checkout changed files${NC}"; exit 1; }
+$MYGIT_EXEC checkout -f two > /dev/null
+expect_clean e/untracked
+echo -e "${GREEN}[PASS] checkout refuses to lose local changes unless forced${NC}"
+
+# An untracked file where the target has a file also stops the checkout.
+$MYGIT_EXEC checkout one > /dev/null
+echo mine > new
+if $MYGIT_EXEC checkout two 2> /dev/null; then
+    echo -e "${RED}[FAIL] checkout overwrote an untracked file${NC}"
+    exit 1
+fi
+rm new
+$MYGIT_EXEC checkout "$two" > /dev/null
+expect_clean e/untracked
+echo -e "${GREEN}[PASS] checkout refuses to overwrite untracked files${NC}"
+
+# A tracked file replaced by a symlink, or hard-linked elsewhere, is
+# replaced: the file outside the working tree is never written to.
+echo outside > ../outside
+rm a/b/c/f && ln -s "$PWD/../outside" a/b/c/f
+$MYGIT_EXEC checkout -f one > /dev/null
+[ "$(cat ../outside)" == "outside" ] && [ ! -L a/b/c/f ] && [ "$(cat a/b/c/f)" == "1" ] ||
+    { echo -e "${RED}[FAIL] checkout -f wrote through a symlink${NC}"; exit 1; }
+cp a/b/c/f ../linked && ln -f ../linked a/b/c/f
+$MYGIT_EXEC checkout two > /dev/null
+[ "$(cat ../linked)" == "1" ] && [ "$(cat a/b/c/f)" == "2" ] ||
+    { echo -e "${RED}[FAIL] checkout wrote through a hard link${NC}"; exit 1; }
+rm ../outside ../linked
+expect_clean e/untracked
+echo -e "${GREEN}[PASS] checkout replaces symlinks and hard links instead of writing through them${NC}"
+
+cd ..
+rm -rf tmp_test
@@ -20,7 +20,7 @@ YOUR_CLONE_DIR="my_git_clone"
 GIT_CLONE_DIR="official_git_clone"
 
 # --- Step 1: Clone with your program ---
-echo -e "${CYAN}[1/3] Running your 'clone' command...${NC}"
+echo -e "${CYAN}[1/4] Running your 'clone' command...${NC}"
 $MYGIT_EXEC clone "$REPO_URL" "$YOUR_CLONE_DIR"
 
 # Check if the directory was created by your program
@@ -33,11 +33,11 @@ fi
 echo -e "${GREEN}Directory '${YOUR_CLONE_DIR}' was created.${NC}"
 
 # --- Step 2: Clone with official git for comparison ---
-echo -e "${CYAN}[2/3] Running 'git clone' as reference...${NC}"
+echo -e "${CYAN}[2/4] Running 'git clone' as reference...${NC}"
 git clone --quiet "$REPO_URL" "$GIT_CLONE_DIR"
 
 # --- Step 3: Compare working directories ---
-echo -e "${CYAN}[3/3] Comparing extracted files...${NC}"
+echo -e "${CYAN}[3/4] Comparing extracted files...${NC}"
 diff_output=$(diff -r --exclude=".git" "$YOUR_CLONE_DIR" "$GIT_CLONE_DIR" || true)
 
 if [ -z "$diff_output" ]; then
@@ -52,6 +52,18 @@ else
     exit 1
 fi
 
+# --- Step 4: A serial checkout must produce the same files ---
+echo -e "${CYAN}[4/4] Cloning again with a single checkout worker...${NC}"
+$MYGIT_EXEC clone -j 1 "$REPO_URL" serial_clone > /dev/null
+if diff -r --exclude=".git" serial_clone "$GIT_CLONE_DIR" > /dev/null; then
+    echo -e "${GREEN}[PASS] Serial checkout matches git.${NC}"
+else
+    echo -e "${RED}[FAIL] 'clone -j 1' checked out different files.${NC}"
+    cd ..
+    rm -rf tmp_test_clone
+    exit 1
+fi
+
 # --- Final cleanup ---
 cd ..
 rm -rf tmp_test_clone
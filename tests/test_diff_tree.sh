@@ -0,0 +1,57 @@
+#!/bin/bash
+set -e
+
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+YELLOW='\033[1;33m'
+NC='\033[0m'
+
+echo -e "${YELLOW}🧪 Testing: diff-tree${NC}"
+
+rm -rf tmp_test && mkdir tmp_test && cd tmp_test
+
+git init -q
+export GIT_AUTHOR_NAME="A U Thor" GIT_AUTHOR_EMAIL=author@example.com
+export GIT_COMMITTER_NAME="C O Mitter" GIT_COMMITTER_EMAIL=committer@example.com
+
+# The second commit modifies a deep file, changes a mode, turns a directory
+# into a file and a file into a directory, turns a symlink into a file, adds
+# and deletes whole directories, and leaves neighbours such as "a-b" (which
+# sorts between "a" and "a/") and "same/" untouched.
+mkdir -p a/b/c d e same
+echo 1 > a/b/c/f && echo 1 > a/g && echo 1 > d/h && echo 1 > e/i && echo 1 > same/s
+echo 1 > top && echo 1 > a.txt && echo 1 > a-b && ln -s top link
+git add -A && git commit -q -m one
+old_commit=$(git rev-parse HEAD)
+old_tree=$(git rev-parse HEAD^{tree})
+
+echo 2 > a/b/c/f && chmod +x a/g
+rm -rf d && echo d > d
+rm top && mkdir top && echo t > top/x
+rm link && echo not-a-link > link
+mkdir new && echo n > new/n
+rm e/i && echo j > e/j && rm a.txt
+git add -A && git commit -q -m two
+new_commit=$(git rev-parse HEAD)
+new_tree=$(git rev-parse HEAD^{tree})
+
+for flags in "" "-r" "-t" "-r -t" "--name-only" "-r --name-only" "--name-status" "-r --name-status"; do
+    for pair in "$old_tree $new_tree" "$new_tree $old_tree" "$old_commit $new_commit" "$new_commit $new_commit"; do
+        if ! diff <(git diff-tree $flags $pair) <($MYGIT_EXEC diff-tree $flags $pair); then
+            echo -e "${RED}[FAIL] diff-tree $flags $pair differs from Git${NC}"
+            exit 1
+        fi
+    done
+done
+echo -e "${GREEN}[PASS] diff-tree matches Git${NC}"
+
+# Branch and tag names resolve to their commit's tree.
+git tag -a v1 -m "a tag" "$old_commit"
+if ! diff <(git diff-tree -r v1 master) <($MYGIT_EXEC diff-tree -r v1 master); then
+    echo -e "${RED}[FAIL] diff-tree -r v1 master differs from Git${NC}"
+    exit 1
+fi
+echo -e "${GREEN}[PASS] diff-tree resolves refs and tags${NC}"
+
+cd ..
+rm -rf tmp_test
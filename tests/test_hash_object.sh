@@ -24,5 +24,41 @@ else
     exit 1
 fi
 
+# Files above 1 MiB are streamed; git must be able to read the object back.
+git init --quiet
+seq 1 500000 > large.txt
+actual=$($MYGIT_EXEC hash-object -w large.txt | tail -n 1)
+expected=$(git hash-object large.txt)
+
+if [ "$expected" == "$actual" ] && git cat-file -p "$actual" | cmp -s - large.txt; then
+    echo -e "${GREEN}[PASS] streamed hash-object matches Git${NC}"
+else
+    echo -e "${RED}[FAIL] streamed hash-object mismatch${NC}"
+    echo -e "${YELLOW}Expected: $expected${NC}"
+    echo -e "${YELLOW}Actual:   $actual${NC}"
+    exit 1
+fi
+
+# With --packed, several files land in one pack, small and streamed ones alike.
+rm -rf .git/objects/?? .git/objects/pack
+seq 1 400000 > large2.txt
+actual=$($MYGIT_EXEC hash-object -w --packed file.txt large.txt large2.txt)
+expected=$(git hash-object file.txt large.txt large2.txt)
+if [ "$expected" == "$actual" ] && [ "$(ls .git/objects/pack/*.pack | wc -l)" -eq 1 ] \
+    && git verify-pack .git/objects/pack/*.idx && git cat-file -p "$(echo "$actual" | tail -n 1)" | cmp -s - large2.txt; then
+    echo -e "${GREEN}[PASS] hash-object --packed writes one pack that Git reads${NC}"
+else
+    echo -e "${RED}[FAIL] hash-object --packed mismatch${NC}"
+    exit 1
+fi
+
+# A failed --packed run stores no pack, so it must not print any id either.
+echo "not stored" > unstored.txt
+if actual=$($MYGIT_EXEC hash-object -w --packed unstored.txt missing.txt 2> /dev/null) || [ -n "$actual" ]; then
+    echo -e "${RED}[FAIL] hash-object --packed printed ids for objects it did not store${NC}"
+    exit 1
+fi
+echo -e "${GREEN}[PASS] hash-object --packed prints nothing when it fails${NC}"
+
 cd ..
 rm -rf tmp_test
@@ -0,0 +1,46 @@
+#!/bin/bash
+set -e
+
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+YELLOW='\033[1;33m'
+NC='\033[0m'
+
+echo -e "${YELLOW}🧪 Testing: index-pack${NC}"
+
+rm -rf tmp_test && mkdir tmp_test && cd tmp_test
+
+# Build a history with delta chains, then pack it with git.
+git init --quiet repo
+cd repo
+for i in $(seq 1 12); do
+    seq 1 800 | sed "s/^$((i * 40))\$/changed in revision $i/" > big.txt
+    echo "revision $i" > note.txt
+    git add .
+    git commit --quiet -m "revision $i"
+done
+git repack --quiet -a -d --depth=10
+cd ..
+
+expected_idx=$(ls repo/.git/objects/pack/pack-*.idx)
+expected_name=$(basename "$expected_idx" .idx)
+expected_name=${expected_name#pack-}
+
+# A 1 KiB delta base cache forces evicted bases to be rebuilt from the pack.
+for options in "-j 1" "-j 4" "-j 4 --delta-cache-size=1k"; do
+    rm -f copy.pack copy.idx
+    cp repo/.git/objects/pack/pack-*.pack copy.pack
+    actual_name=$($MYGIT_EXEC index-pack $options copy.pack)
+
+    if [ "$actual_name" == "$expected_name" ] && cmp -s copy.idx "$expected_idx"; then
+        echo -e "${GREEN}[PASS] index-pack $options matches git's .idx${NC}"
+    else
+        echo -e "${RED}[FAIL] index-pack $options differs from git${NC}"
+        echo -e "${YELLOW}Expected pack name: $expected_name${NC}"
+        echo -e "${YELLOW}Actual pack name:   $actual_name${NC}"
+        exit 1
+    fi
+done
+
+cd ..
+rm -rf tmp_test
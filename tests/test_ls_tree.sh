@@ -33,5 +33,20 @@ else
     exit 1
 fi
 
+# Trees cut short in the mode, the name or the SHA must be rejected.
+malformed_ok=true
+for content in "100644" "100644 name-without-null" "100644 short-sha\0abc"; do
+    sha=$(printf "$content" | git hash-object -t tree --literally -w --stdin)
+    if $MYGIT_EXEC ls-tree "$sha" > /dev/null 2>&1; then
+        malformed_ok=false
+    fi
+done
+if $malformed_ok; then
+    echo -e "${GREEN}[PASS] ls-tree rejects malformed trees${NC}"
+else
+    echo -e "${RED}[FAIL] ls-tree accepted a malformed tree${NC}"
+    exit 1
+fi
+
 cd ..
 rm -rf tmp_test
@@ -34,5 +34,34 @@ else
     exit 1
 fi
 
+# Recursive listings, with trees (-t) and blob sizes (-l), must match Git line
+# for line, both for the tree and for a commit pointing at it.
+mkdir -p dir1/deep/deeper && echo "deep content" > dir1/deep/deeper/d.txt
+printf '#!/bin/sh\n' > dir1/run.sh && chmod +x dir1/run.sh
+git add .
+tree_sha=$(git write-tree)
+commit_sha=$(git commit-tree "$tree_sha" -m "ls-tree test")
+for flags in "-r" "-t" "-r -t" "-l" "-r -l" "-rtl" "-r --name-only"; do
+    for target in "$tree_sha" "$commit_sha"; do
+        if ! diff <(git ls-tree $flags "$target") <($MYGIT_EXEC ls-tree $flags "$target"); then
+            echo -e "${RED}[FAIL] ls-tree $flags $target differs from Git${NC}"
+            exit 1
+        fi
+    done
+done
+echo -e "${GREEN}[PASS] ls-tree -r/-t/-l matches Git${NC}"
+
+# Like diff-tree, ls-tree takes any tree-ish: HEAD, a branch or an annotated tag.
+git update-ref refs/heads/main "$commit_sha"
+git symbolic-ref HEAD refs/heads/main
+git tag -a -m "annotated" v1 "$commit_sha"
+for target in HEAD main v1; do
+    if ! diff <(git ls-tree -r "$target") <($MYGIT_EXEC ls-tree -r "$target"); then
+        echo -e "${RED}[FAIL] ls-tree -r $target differs from Git${NC}"
+        exit 1
+    fi
+done
+echo -e "${GREEN}[PASS] ls-tree resolves revisions like Git${NC}"
+
 cd ..
 rm -rf tmp_test
@@ -0,0 +1,78 @@
+#!/bin/bash
+set -e
+
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+YELLOW='\033[1;33m'
+NC='\033[0m'
+
+echo -e "${YELLOW}🧪 Testing: reading objects from packfiles${NC}"
+
+rm -rf tmp_test && mkdir tmp_test && cd tmp_test
+
+# Build a small history whose file revisions git will store as deltas.
+git init --quiet
+mkdir dir1
+for i in 1 2 3 4 5; do
+    seq 1 500 | sed "s/^$((i * 50))\$/changed in revision $i/" > big.txt
+    echo "revision $i" > dir1/note.txt
+    git add .
+    git commit --quiet -m "revision $i"
+done
+
+# Move every object into a single pack and delete the loose copies.
+git repack --quiet -a -d
+git prune-packed
+if [ -n "$(find .git/objects -path '*/objects/??/*' -type f)" ]; then
+    echo -e "${RED}[FAIL] Setup error: loose objects remain after repacking${NC}"
+    exit 1
+fi
+
+oldest_blob=$(git rev-parse HEAD~4:big.txt)
+head_tree=$(git rev-parse HEAD^{tree})
+head_commit=$(git rev-parse HEAD)
+
+check() {
+    local label="$1" expected="$2" actual="$3"
+    if [ "$expected" == "$actual" ]; then
+        echo -e "${GREEN}[PASS] $label${NC}"
+    else
+        echo -e "${RED}[FAIL] $label${NC}"
+        echo -e "${YELLOW}Expected:${NC}"
+        echo "$expected"
+        echo -e "${YELLOW}Actual:${NC}"
+        echo "$actual"
+        exit 1
+    fi
+}
+
+check "cat-file reads a delta-compressed blob" \
+    "$(git cat-file -p "$oldest_blob")" "$($MYGIT_EXEC cat-file -p "$oldest_blob")"
+check "cat-file reads a packed commit" \
+    "$(git cat-file -p "$head_commit")" "$($MYGIT_EXEC cat-file -p "$head_commit")"
+check "ls-tree lists a packed tree" \
+    "$(git ls-tree "$head_tree")" "$($MYGIT_EXEC ls-tree "$head_tree")"
+
+# An entry is inflated from a window that runs to the end of the pack. In a
+# pack past 4 GiB, that window must not be truncated to 32 bits for zlib. A
+# hole before the trailer makes the pack sparse, so nothing is written to disk.
+mkdir huge && cd huge
+git init --quiet
+seq 1 300 > blob.txt # Between 16 and 2047 bytes: a 2-byte entry header at offset 12.
+blob=$(git hash-object -w blob.txt)
+pack=$(echo "$blob" | git pack-objects --quiet .git/objects/pack/pack)
+rm -rf .git/objects/??
+pack_file=.git/objects/pack/pack-$pack.pack
+pack_size=$(stat -c %s "$pack_file")
+tail -c 20 "$pack_file" > trailer
+# The window from the entry's data at offset 14 to the trailer is 2^32 + 4 bytes,
+# which a 32-bit cast would turn into 4 bytes.
+truncate -s $((pack_size - 20)) "$pack_file"
+truncate -s $((4294967296 + 18)) "$pack_file"
+cat trailer >> "$pack_file"
+check "cat-file reads an entry of a pack larger than 4 GiB" \
+    "$(cat blob.txt)" "$($MYGIT_EXEC cat-file -p "$blob")"
+cd ..
+
+cd ..
+rm -rf tmp_test
@@ -0,0 +1,94 @@
+#!/bin/bash
+set -e
+
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+YELLOW='\033[1;33m'
+NC='\033[0m'
+
+echo -e "${YELLOW}🧪 Testing: commit-graph, rev-list and log${NC}"
+
+rm -rf tmp_test && mkdir tmp_test && cd tmp_test
+
+git init -q
+export GIT_AUTHOR_NAME="A U Thor" GIT_AUTHOR_EMAIL=author@example.com
+export GIT_COMMITTER_NAME="C O Mitter" GIT_COMMITTER_EMAIL=committer@example.com
+t=1700000000
+commit() {
+    t=$((t + 100))
+    GIT_AUTHOR_DATE="$t -0700" GIT_COMMITTER_DATE="$t +0200" git commit -q --allow-empty --allow-empty-message -m "$1"
+}
+
+# Two branches, an octopus merge, an annotated tag, a multi-line message, an
+# empty message, and a branch that forks off the middle of the history.
+commit one
+commit ""
+commit two
+git checkout -q -b side
+commit s1
+commit s2
+git checkout -q master
+commit three
+git checkout -q -b other
+commit o1
+git checkout -q master
+t=$((t + 100))
+GIT_AUTHOR_DATE="$t +0530" GIT_COMMITTER_DATE="$t +0000" git merge -q --no-ff -m octopus side other > /dev/null
+commit "four
+
+with a body
+
+and a last paragraph"
+git tag -a v1 -m "a tag" HEAD~1
+git checkout -q -b topic HEAD~2
+commit t1
+git checkout -q master
+
+compare() {
+    local label=$1
+    for revs in "HEAD" "master" "master topic" "v1" "side" "-n 3 master topic" "--max-count=2 HEAD"; do
+        if ! diff <(git rev-list $revs) <($MYGIT_EXEC rev-list $revs); then
+            echo -e "${RED}[FAIL] rev-list $revs differs from Git ($label)${NC}"
+            exit 1
+        fi
+    done
+    for revs in "" "-n 2" "topic v1"; do
+        if ! diff <(git log $revs) <($MYGIT_EXEC log $revs); then
+            echo -e "${RED}[FAIL] log $revs differs from Git ($label)${NC}"
+            exit 1
+        fi
+    done
+}
+
+compare "without a commit graph"
+echo -e "${GREEN}[PASS] rev-list and log match Git without a commit graph${NC}"
+
+$MYGIT_EXEC commit-graph write
+if ! git commit-graph verify; then
+    echo -e "${RED}[FAIL] git commit-graph verify rejects the graph${NC}"
+    exit 1
+fi
+compare "with a commit graph"
+echo -e "${GREEN}[PASS] commit-graph write is valid; rev-list and log match Git with it${NC}"
+
+# Commits made after the graph was written are parsed and then join the graph walk.
+commit five
+git checkout -q topic
+commit t2
+git checkout -q master
+compare "with commits outside the graph"
+echo -e "${GREEN}[PASS] rev-list and log match Git when the graph is out of date${NC}"
+
+# With generation numbers v1, Git writes the same file byte for byte.
+rm -f .git/objects/info/commit-graph
+git -c commitGraph.generationVersion=1 commit-graph write --reachable
+cp .git/objects/info/commit-graph expected-graph
+$MYGIT_EXEC commit-graph write
+if ! cmp -s expected-graph .git/objects/info/commit-graph; then
+    echo -e "${RED}[FAIL] commit-graph differs from Git's${NC}"
+    exit 1
+fi
+echo -e "${GREEN}[PASS] commit-graph matches Git's file${NC}"
+
+cd ..
+rm -rf tmp_test
@@ -0,0 +1,80 @@
+#!/bin/bash
+set -e
+
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+YELLOW='\033[1;33m'
+NC='\033[0m'
+
+echo -e "${YELLOW}🧪 Testing: sparse-checkout${NC}"
+
+rm -rf tmp_test && mkdir tmp_test && cd tmp_test
+
+export GIT_AUTHOR_NAME="A U Thor" GIT_AUTHOR_EMAIL=author@example.com
+export GIT_COMMITTER_NAME="C O Mitter" GIT_COMMITTER_EMAIL=committer@example.com
+
+git init -q origin && cd origin
+mkdir -p A/A1 B/C/D B/E X
+for f in r1 A/a1 A/A1/x B/b1 B/C/c1 B/C/D/d1 B/E/e1 X/x; do echo "$f" > "$f"; done
+git add -A && git commit -q -m one && git branch one
+echo changed > A/a1 && echo changed > B/E/e1 && echo changed > X/x && echo new > B/C/D/new
+git add -A && git commit -q -m two && git branch two
+git checkout -q one
+cd ..
+
+# "theirs" is a sparse checkout made by git, "mine" a full clone that mygit
+# makes sparse. Both must end up with the same files and patterns.
+git clone -q origin theirs
+git clone -q origin mine
+for clone in theirs mine; do git -C $clone branch -q two origin/two; done
+(cd theirs && git checkout -q one && git sparse-checkout set --cone A B/C)
+
+files() { (cd "$1" && find . -path ./.git -prune -o -type f -print | sort); }
+compare() {
+    if ! diff <(files theirs) <(files mine); then
+        echo -e "${RED}[FAIL] $1: the checked-out files differ from Git${NC}"
+        exit 1
+    fi
+    # Git keeps its patterns after disable; mygit removes them.
+    if [ -e mine/.git/info/sparse-checkout ] && ! diff theirs/.git/info/sparse-checkout mine/.git/info/sparse-checkout; then
+        echo -e "${RED}[FAIL] $1: the patterns differ from Git${NC}"
+        exit 1
+    fi
+}
+
+cd mine
+git checkout -q one
+$MYGIT_EXEC sparse-checkout set A B/C
+cd ..
+compare "sparse-checkout set"
+[ -d mine/X ] && { echo -e "${RED}[FAIL] a directory outside the cone was kept${NC}"; exit 1; }
+echo -e "${GREEN}[PASS] sparse-checkout set matches Git${NC}"
+
+(cd theirs && git sparse-checkout add B/E)
+(cd mine && $MYGIT_EXEC sparse-checkout add B/E)
+compare "sparse-checkout add"
+diff <(cd theirs && git sparse-checkout list) <(cd mine && $MYGIT_EXEC sparse-checkout list) ||
+    { echo -e "${RED}[FAIL] sparse-checkout list differs from Git${NC}"; exit 1; }
+echo -e "${GREEN}[PASS] sparse-checkout add and list match Git${NC}"
+
+# The trees outside the cone are never read: checkout succeeds without them.
+(cd theirs && git checkout -q two)
+cd mine
+for tree in $(git rev-parse one:X two:X one:A/A1); do
+    rm -f ".git/objects/${tree:0:2}/${tree:2}"
+done
+$MYGIT_EXEC checkout two > /dev/null
+cd ..
+compare "checkout in a sparse cone"
+[ "$(cat mine/A/a1)" == "changed" ] || { echo -e "${RED}[FAIL] a file in the cone was not updated${NC}"; exit 1; }
+echo -e "${GREEN}[PASS] checkout stays in the cone without reading the trees outside it${NC}"
+
+cp -rn origin/.git/objects/. mine/.git/objects/ # Restore the trees removed above.
+(cd mine && $MYGIT_EXEC sparse-checkout disable)
+(cd theirs && git sparse-checkout disable)
+compare "sparse-checkout disable"
+[ -e mine/.git/info/sparse-checkout ] && { echo -e "${RED}[FAIL] the patterns were not removed${NC}"; exit 1; }
+echo -e "${GREEN}[PASS] sparse-checkout disable checks every file out again${NC}"
+
+cd ..
+rm -rf tmp_test
@@ -25,5 +25,109 @@ else
     exit 1
 fi
 
+# A nested tree must hash the same whatever the number of threads.
+mkdir -p src/utils docs
+for i in $(seq 1 20); do
+    echo "util $i" > "src/utils/util_$i.c"
+    echo "doc $i" > "docs/page_$i.md"
+done
+echo "int main() {}" > src/main.c
+git add .
+expected=$(git write-tree)
+for threads in 1 4; do
+    actual=$($MYGIT_EXEC write-tree -j $threads 2> /dev/null | tail -n 1)
+    if [ "$expected" == "$actual" ]; then
+        echo -e "${GREEN}[PASS] write-tree -j $threads matches Git on nested directories${NC}"
+    else
+        echo -e "${RED}[FAIL] write-tree -j $threads mismatch on nested directories${NC}"
+        echo -e "${YELLOW}Expected: $expected${NC}"
+        echo -e "${YELLOW}Actual:   $actual${NC}"
+        exit 1
+    fi
+done
+
+# The second run reuses .git/stat-cache; edits made right after it must still be seen.
+echo "util 3 edited" > src/utils/util_3.c
+echo "doc X" > docs/page_7.md # Same size as before.
+rm docs/page_12.md
+mkdir -p src/extra && echo "extra" > src/extra/new.c
+git add -A .
+expected=$(git write-tree)
+actual=$($MYGIT_EXEC write-tree 2> /dev/null | tail -n 1)
+if [ "$expected" == "$actual" ] && [ -f .git/stat-cache ]; then
+    echo -e "${GREEN}[PASS] write-tree sees changes made after the stat cache was written${NC}"
+else
+    echo -e "${RED}[FAIL] write-tree mismatch after editing cached files${NC}"
+    echo -e "${YELLOW}Expected: $expected${NC}"
+    echo -e "${YELLOW}Actual:   $actual${NC}"
+    exit 1
+fi
+
+# --packed stores the new objects in one pack that Git can read, and no loose file.
+# Git needs its objects to write the expected tree, so they are deleted afterwards.
+head -c 2000000 /dev/urandom > src/large.bin # Streamed into the pack.
+git add -A .
+expected=$(git write-tree)
+rm -rf .git/objects/?? .git/objects/pack .git/stat-cache
+actual=$($MYGIT_EXEC write-tree --packed 2> /dev/null | tail -n 1)
+loose=$(find .git/objects -path '*/pack' -prune -o -type f -print | grep -v '/info/' | wc -l)
+packs=$(ls .git/objects/pack/*.pack | wc -l)
+if [ "$expected" == "$actual" ] && [ "$loose" -eq 0 ] && [ "$packs" -eq 1 ] \
+    && git verify-pack .git/objects/pack/*.idx && git fsck --no-dangling 2> /dev/null \
+    && [ "$($MYGIT_EXEC ls-tree -r "$actual")" == "$(git ls-tree -r "$expected")" ]; then
+    echo -e "${GREEN}[PASS] write-tree --packed writes one pack that Git accepts${NC}"
+else
+    echo -e "${RED}[FAIL] write-tree --packed: tree $actual (expected $expected), $loose loose files, $packs packs${NC}"
+    exit 1
+fi
+
+# Objects already stored in the other store are not written again.
+rm -f .git/stat-cache
+$MYGIT_EXEC write-tree > /dev/null 2>&1
+loose=$(find .git/objects -path '*/pack' -prune -o -type f -print | grep -v '/info/' | wc -l)
+rm -rf .git/objects/pack .git/stat-cache
+$MYGIT_EXEC write-tree > /dev/null 2>&1
+rm -f .git/stat-cache
+$MYGIT_EXEC write-tree --packed > /dev/null 2>&1
+packs=$(find .git/objects/pack -name '*.pack' 2> /dev/null | wc -l)
+if [ "$loose" -eq 0 ] && [ "$packs" -eq 0 ]; then
+    echo -e "${GREEN}[PASS] write-tree skips objects that are already packed or loose${NC}"
+else
+    echo -e "${RED}[FAIL] write-tree duplicated stored objects: $loose loose files, $packs packs${NC}"
+    exit 1
+fi
+
+# Every fsync policy stores the same objects, complete and under their final names.
+for policy in none per-object batch; do
+    rm -rf .git/objects/?? .git/objects/pack .git/stat-cache
+    actual=$($MYGIT_EXEC --fsync=$policy write-tree 2> /dev/null | tail -n 1)
+    leftovers=$(find .git/objects -name 'tmp_*' | wc -l)
+    if [ "$expected" == "$actual" ] && [ "$leftovers" -eq 0 ] && git fsck --no-dangling 2> /dev/null \
+        && [ "$(git ls-tree -r "$actual")" == "$(git ls-tree -r "$expected")" ]; then
+        echo -e "${GREEN}[PASS] write-tree with --fsync=$policy matches Git${NC}"
+    else
+        echo -e "${RED}[FAIL] write-tree with --fsync=$policy: tree $actual (expected $expected), $leftovers temporary files left${NC}"
+        exit 1
+    fi
+done
+if $MYGIT_EXEC --fsync=sometimes write-tree > /dev/null 2>&1; then
+    echo -e "${RED}[FAIL] an unknown fsync policy was accepted${NC}"
+    exit 1
+fi
+
+# A file touched without a content change leaves every tree as it was, but
+# the cache must still learn its new stat so the next run does not hash it.
+# The sleeps keep the file out of the racy window, where hashing it again is right.
+sleep 1
+touch src/main.c
+sleep 1
+$MYGIT_EXEC write-tree > /dev/null 2>&1
+if $MYGIT_EXEC write-tree -v 2>&1 >/dev/null | grep -q "^Hashed 0 of"; then
+    echo -e "${GREEN}[PASS] write-tree records touched files in the stat cache${NC}"
+else
+    echo -e "${RED}[FAIL] write-tree hashed a touched file again${NC}"
+    exit 1
+fi
+
 cd ..
 rm -rf tmp_test